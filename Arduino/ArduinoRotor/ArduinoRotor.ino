@@ -21,12 +21,23 @@
  /// \version 1.1  various small changes, added main documentation for doxygen
  /// \version 1.2  Modification to overcome Arduino include strategy 
  /// \version 1.3  Removed artefacts from experiment.
+ /// \version 1.4  Process() path markers for the cycle benchmark.
+ /// \version 1.5  ADC interrupt for the position sensor.
+ /// \version 1.6  ADC interrupt for the current sensor.
+ /// \version 1.7  Analog comparator interrupt for the power warning.
+ /// \version 1.8  Reset cause saved before the constructors, watchdog started.
+ /// \version 1.9  Pin change interrupt for the rotary encoder.
+ /// \version 1.10 Neopixel update through the SPI.
+ /// \version 1.11 Serial port shared by the serial commands and the debug logger.
+ /// \version 1.12 Reset cause passed by Optiboot 5.0 and later in r2.
  /// \mainpage PE1MEW Arduino Rotor Controller
  /// 
  /// This is the PE1MEW Arduino Rotor Controller.
 
 #include <Arduino.h>
 #include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <avr/pgmspace.h>
 #include "pe1mew_rotorcontroller.h"  // include files when used in Arduino project folder
 
 #ifdef __AVR__
@@ -39,6 +50,33 @@ void loop();
 
 PE1MEW_RotorController rotorController = PE1MEW_RotorController();  ///< rotor object from PE1MEW_RotorController class type
 volatile bool ticked = false; ///< variable set by timer 1 to indicate that 10mS interval is passed.
+uint8_t resetCause __attribute__((section(".noinit"))); ///< MCUSR at the start, see eResetCause, 0 when not known.
+
+static const uint8_t OPTIBOOT_MAJOR_R2 = 5; ///< First major version of Optiboot that passes MCUSR in r2.
+
+/// \brief save and clear the reset cause and stop the watchdog, before the constructors run.
+/// After a watchdog reset the watchdog keeps running with the shortest timeout.
+/// Optiboot clears MCUSR before it starts the sketch. From version 5.0 it passes the value in r2,
+/// which the startup code does not change before .init3; the major version is the last byte of
+/// the flash. With an older Optiboot, as on a stock Uno, the cause stays 0 (not known).
+void saveResetCause(void) __attribute__((naked, used, section(".init3")));
+void saveResetCause(void)
+{
+  uint8_t bootloaderCause;
+  asm volatile ("mov %0, r2" : "=r" (bootloaderCause));
+  
+  resetCause = MCUSR;
+  if (resetCause == 0)
+  {
+    uint8_t major = pgm_read_byte(FLASHEND);
+    if (major >= OPTIBOOT_MAJOR_R2 && major != 0xFF)    // 0xFF: no bootloader
+    {
+      resetCause = bootloaderCause & (RESET_POWERON | RESET_EXTERNAL | RESET_BROWNOUT | RESET_WATCHDOG);
+    }
+  }
+  MCUSR = 0;
+  wdt_disable();
+}
 
 /// \brief functions called at startup to configure hardware
 void setup() 
@@ -49,16 +87,18 @@ void setup()
   #endif
   // End of trinket special code
 
-  /// \brief initialize serial communication for debug activities
-  /// \todo shall be removed and replaced by debug logger
+  /// \brief initialize serial communication for the serial commands and the debug logger
+  /// The messages of the debug logger are sent in binary, see pe1mew_debuglog.h.
   Serial.begin(115200); // initialize serial:
+  DEBUG_LOG1(START, resetCause);
   
   
   /// \brief timer configuration
   /// The rotor controller is running using fixed interrupt intervals.
   /// The time base is 10 mS because the Neopixel need approximately 2 mS to update the leds.
   /// During this update interrupts are disabled to prevent timing delay in the protocol of the 
-  /// Neopixel led.
+  /// Neopixel led. With NEOPIXELSPI the leds are updated in about 1.4 mS through the SPI with
+  /// interrupts enabled.
   ///
   /// In this implementation registers in the ATMega328 are used.
   /// In the case of using other microprocessors than used in this example it is suggested to use the 
@@ -78,6 +118,10 @@ void setup()
   // enable timer compare interrupt:
   TIMSK1 |= (1 << OCIE1A);
   sei();          // enable global interrupts
+
+#ifdef WATCHDOG
+  rotorController.startWatchdog(resetCause);
+#endif
 }
 
 /// \brief main loop
@@ -86,7 +130,15 @@ void loop()
 {
   if (ticked)
   {
+#ifdef CYCLEBENCHMARK
+    // The simulator of the benchmark counts the cycles from the write of 1 to the write of 0 in GPIOR0.
+    GPIOR1 = rotorController.getProcessPath();
+    GPIOR0 = 1;
+    rotorController.Process();
+    GPIOR0 = 0;
+#else
     rotorController.Process();
+#endif
     ticked = false;
   }
 }
@@ -99,3 +151,46 @@ ISR(TIMER1_COMPA_vect)
   ticked = true;  // set trigger for mainloop to run process() function of rotorController object.
 }
 
+#ifdef POSITIONSENSOR
+/// \brief ISR of the ADC in free running mode
+/// Each conversion of the feedback potentiometer is added to the samples of the position sensor.
+ISR(ADC_vect)
+{
+  PE1MEW_PositionSensor::addSample(ADC);
+}
+#endif
+
+#ifdef POWERWARNING
+/// \brief ISR of the analog comparator, the supply drops.
+/// The direction is written in the journal. When the supply returns before the controller
+/// is off, the controller is restarted by the watchdog as at power-up.
+ISR(ANALOG_COMP_vect)
+{
+  rotorController.powerFail();
+  while (ACSR & (1 << ACO))
+  {
+  }
+  wdt_enable(WDTO_15MS);
+  while (true)
+  {
+  }
+}
+#endif
+
+#ifdef CURRENTSENSOR
+/// \brief ISR of the ADC in free running mode
+/// Each conversion of the motor current is added to the samples of the current sensor.
+ISR(ADC_vect)
+{
+  PE1MEW_CurrentSensor::addSample(ADC);
+}
+#endif
+
+#ifdef ROTARYENCODER
+/// \brief ISR of the pin change interrupt of port B
+/// Each change of output A or B of the rotary encoder is added to the edges of the steering.
+ISR(PCINT0_vect)
+{
+  PE1MEW_RotorSteering::addEncoderEdge(PINB & ((1 << PINB0) | (1 << PINB1)));
+}
+#endif
@@ -0,0 +1,120 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_currentsensor.cpp
+ /// \brief Motor current sensor class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+
+#include "pe1mew_currentsensor.h"
+
+#include "Arduino.h"
+
+#ifdef __AVR__
+#include <util/atomic.h>
+#endif
+
+CURRENT_SHARED uint16_t PE1MEW_CurrentSensor::_SampleSum = 0;
+CURRENT_SHARED uint8_t  PE1MEW_CurrentSensor::_SampleCount = 0;
+
+PE1MEW_CurrentSensor::PE1MEW_CurrentSensor():
+	_Value(0),
+	_Running(0),
+	_RunCounter(0),
+	_StallCounter(0)
+{
+	_SampleSum = 0;
+	_SampleCount = 0;
+}
+
+void PE1MEW_CurrentSensor::Initialize(void)
+{
+#ifdef __AVR__
+	ADMUX = (1 << REFS0) | CURRENT_CHANNEL;						// AVcc reference, right adjusted
+	ADCSRB = 0;													// free running
+	DIDR0 |= (1 << CURRENT_CHANNEL);							// no digital input on the channel
+	ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE)
+		   | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);		// ADC clock / 128, start
+#endif
+}
+
+void PE1MEW_CurrentSensor::addSample(uint16_t sample)
+{
+	if (_SampleCount < CURRENT_SAMPLE_MAX)	// Process() was delayed: keep the samples summed so far
+	{
+		_SampleSum += sample;
+		_SampleCount++;
+	}
+}
+
+bool PE1MEW_CurrentSensor::Process(void)
+{
+	uint16_t sum;
+	uint8_t count;
+	
+#ifdef __AVR__
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+	{
+		sum = _SampleSum;
+		count = _SampleCount;
+		_SampleSum = 0;
+		_SampleCount = 0;
+	}
+	
+	if (count == 0)
+	{
+		return false;
+	}
+	
+	_Value = (uint16_t)(((uint32_t)sum << CURRENT_EXTRA_BITS) / count);
+	return true;
+}
+
+bool PE1MEW_CurrentSensor::isStalled(bool running)
+{
+	if (!running)
+	{
+		_RunCounter = 0;
+		_StallCounter = 0;
+		return false;
+	}
+	
+	if (_RunCounter < CURRENT_INRUSH_TICKS)		// the motor starts: the current is that of a stalled motor
+	{
+		_RunCounter++;
+		return false;
+	}
+	
+	if (_Running == 0)							// first move since power-up
+	{
+		_Running = _Value;
+	}
+	
+	if (_Value > _Running + (_Running >> CURRENT_STALL_SHIFT) || _Value < (_Running >> CURRENT_OPEN_SHIFT))
+	{
+		if (_StallCounter < CURRENT_STALL_TICKS)
+		{
+			_StallCounter++;
+		}
+		return _StallCounter >= CURRENT_STALL_TICKS;
+	}
+	
+	// The rotor turns: follow the current, which changes with the load and the direction.
+	_StallCounter = 0;
+	_Running += ((int16_t)_Value - (int16_t)_Running) >> CURRENT_AVERAGE_SHIFT;
+	return false;
+}
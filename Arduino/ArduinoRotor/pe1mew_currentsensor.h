@@ -0,0 +1,90 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_currentsensor.h
+ /// \brief Motor current sensor class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+
+#ifndef PE1MEW_CURRENTSENSOR_H
+#define PE1MEW_CURRENTSENSOR_H
+
+#include <stdint.h>
+
+static const uint8_t  CURRENT_CHANNEL = 1;			///< ADC channel of the current sense voltage, A1.
+static const uint8_t  CURRENT_SAMPLE_MAX = 64;		///< Samples summed per tick, 64 * 1023 fits in 16 bits.
+static const uint8_t  CURRENT_EXTRA_BITS = 3;		///< Bits gained by oversampling, 10 bit samples give 13 bit values.
+static const uint8_t  CURRENT_INRUSH_TICKS = 30;	///< Ticks after the relay is activated in which the start current of the motor is ignored.
+static const uint8_t  CURRENT_STALL_TICKS = 3;		///< Ticks the current shall be out of range before the rotor is stalled.
+static const uint8_t  CURRENT_STALL_SHIFT = 1;		///< Stalled above the running current plus 1/2.
+static const uint8_t  CURRENT_OPEN_SHIFT = 2;		///< Stopped by a limit switch below 1/4 of the running current.
+static const uint8_t  CURRENT_AVERAGE_SHIFT = 3;	///< The running current follows the current of a turning rotor by 1/8 per tick.
+
+#ifdef __AVR__
+#define CURRENT_SHARED volatile		///< Written by the ADC interrupt.
+#else
+#define CURRENT_SHARED thread_local	///< The simulator runs a controller per thread.
+#endif
+
+/// \class PE1MEW_CurrentSensor
+/// \brief Detects a stalled rotor from the current of the motor.
+///
+/// The voltage of a current sense resistor with an amplifier, or of a current transformer with
+/// a rectifier and filter, is converted continuously as by PE1MEW_PositionSensor. The running
+/// current of the rotor is learned while it turns. A current that stays well above the running 
+/// current, the rotor pushed against an end stop or jammed, or well below it, a limit switch of
+/// the rotor cut the motor, is a stall. The current at the start of the motor is ignored.
+class PE1MEW_CurrentSensor
+{
+public:
+	/// \brief Default constructor
+	PE1MEW_CurrentSensor();
+	
+	/// \brief start the ADC in free running mode with interrupt.
+	void Initialize(void);
+	
+	/// \brief decimate the samples of the last tick, at each sys tick.
+	/// \return true when there were samples and getValue() is valid.
+	bool Process(void);
+	
+	/// \brief get the decimated current of the last tick.
+	/// \return value in ADC steps with CURRENT_EXTRA_BITS fractional bits.
+	uint16_t getValue(void){return _Value;}
+	
+	/// \brief get the learned current of a turning rotor.
+	/// \return value in ADC steps with CURRENT_EXTRA_BITS fractional bits, 0 before the first move.
+	uint16_t getRunningValue(void){return _Running;}
+	
+	/// \brief detect a rotor that does not turn while the motor runs, at an end stop or jammed.
+	/// Called at each sys tick after Process().
+	/// \param running the motor relay is active.
+	/// \return true when the current was out of range for CURRENT_STALL_TICKS ticks after the start current.
+	bool isStalled(bool running);
+	
+	/// \brief add a sample, called by the ADC interrupt in ArduinoRotor.ino.
+	/// \param sample 10 bit result of the ADC.
+	static void addSample(uint16_t sample);
+
+private:
+	static CURRENT_SHARED uint16_t _SampleSum;	///< Sum of the samples since the last Process().
+	static CURRENT_SHARED uint8_t  _SampleCount;	///< Number of samples in _SampleSum.
+	uint16_t _Value;							///< Decimated current of the last tick with samples.
+	uint16_t _Running;							///< Current of a turning rotor, 0 until learned.
+	uint8_t  _RunCounter;						///< Ticks since the relay was activated, up to CURRENT_INRUSH_TICKS.
+	uint8_t  _StallCounter;						///< Ticks the current was out of range.
+};
+
+#endif // PE1MEW_CURRENTSENSOR_H
@@ -0,0 +1,76 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_debuglog.cpp
+ /// \brief Debug logger for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+
+#include "pe1mew_debuglog.h"
+
+#include "Arduino.h"
+#include <avr/pgmspace.h>
+
+/// \brief number of arguments of each message, index is the token - DEBUG_TOKEN_BASE - 1.
+static const uint8_t DEBUGLOG_ARGUMENT_COUNT[] PROGMEM = {
+#define DEBUGLOG_ARGUMENT_COUNT_ENTRY(name, level, arguments, format)	arguments,
+	DEBUGLOG_MESSAGES(DEBUGLOG_ARGUMENT_COUNT_ENTRY)
+#undef DEBUGLOG_ARGUMENT_COUNT_ENTRY
+};
+
+uint8_t  PE1MEW_DebugLog::_Buffer[DEBUGLOG_SIZE];
+uint8_t  PE1MEW_DebugLog::_Head = 0;
+uint8_t  PE1MEW_DebugLog::_Tail = 0;
+uint16_t PE1MEW_DebugLog::_Dropped = 0;
+
+uint8_t PE1MEW_DebugLog::getLength(uint8_t token)
+{
+	if (token <= DEBUG_TOKEN_BASE || token >= DEBUG_TOKEN_END)
+	{
+		return 0;
+	}
+	return 1 + 2 * pgm_read_byte(&DEBUGLOG_ARGUMENT_COUNT[token - DEBUG_TOKEN_BASE - 1]);
+}
+
+void PE1MEW_DebugLog::Process(void)
+{
+	// Whole messages only: the text written by print() between them stays readable.
+	while (_Tail != _Head)
+	{
+		uint8_t length = getLength(_Buffer[_Tail & DEBUGLOG_MASK]);
+		if (length == 0)
+		{
+			_Tail = _Head;			// Not a message: the ring buffer is not in step, start again.
+			return;
+		}
+		if (Serial.availableForWrite() < length)
+		{
+			return;
+		}
+		for (uint8_t i = 0; i < length; i++)
+		{
+			Serial.write(_Buffer[_Tail++ & DEBUGLOG_MASK]);
+		}
+	}
+	
+	if (_Dropped != 0 && Serial.availableForWrite() >= 3)
+	{
+		Serial.write((uint8_t)DEBUG_DROPPED);
+		Serial.write((uint8_t)_Dropped);
+		Serial.write((uint8_t)(_Dropped >> 8));
+		_Dropped = 0;
+	}
+}
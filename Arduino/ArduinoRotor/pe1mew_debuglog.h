@@ -0,0 +1,183 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_debuglog.h
+ /// \brief Debug logger for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	DEFERRED only for the frame and the reports, once per run of ticks.
+
+#ifndef PE1MEW_DEBUGLOG_H
+#define PE1MEW_DEBUGLOG_H
+
+#include <stdint.h>
+
+/// \brief levels of the messages of the debug logger.
+enum eDebugLevel { LEVEL_ERROR = 1,		///< The controller can not continue as intended
+				   LEVEL_WARNING,		///< The controller recovered from a problem
+				   LEVEL_INFO,			///< Normal operation: moves and start-up
+				   LEVEL_DEBUG };		///< Details of the tick
+
+/// \brief Debug logger: messages up to this level are sent in binary on the serial port.
+/// Messages of higher levels, and all messages when it is not defined, are not compiled.
+//#define DEBUGLOG LEVEL_INFO
+
+static const uint8_t DEBUGLOG_SIZE = 64;			///< Bytes of the ring buffer of the messages, a power of 2 up to 128.
+static const uint8_t DEBUGLOG_MASK = DEBUGLOG_SIZE - 1;	///< Mask of an index in the ring buffer.
+
+/// \brief messages of the debug logger: name, eDebugLevel, number of arguments and format.
+/// A message is sent as its token, 0x80 + its position in this list, followed by its 16 bit
+/// arguments LSB first. Text on the serial port is ASCII, so the decoder tells a token from text.
+/// The format is only used by the decoder on the host, Simulator/rotordebug, and is not in the
+/// firmware: %u unsigned, %d signed, %x hexadecimal, %c character, %t tenths of degrees.
+/// New messages are added at the end, so older streams are decoded as they were sent.
+#define DEBUGLOG_MESSAGES(MESSAGE) \
+	MESSAGE(DROPPED,		LEVEL_WARNING,	1, "%u messages dropped, the ring buffer was full") \
+	MESSAGE(START,			LEVEL_INFO,		1, "start, reset cause 0x%x") \
+	MESSAGE(MOVE_START,		LEVEL_INFO,		2, "move from %t to %t") \
+	MESSAGE(MOVE_END,		LEVEL_INFO,		1, "stopped at %t") \
+	MESSAGE(STALL,			LEVEL_WARNING,	2, "stall at %t, runtime %u ticks") \
+	MESSAGE(JAMMED,			LEVEL_ERROR,	1, "jammed at %t") \
+	MESSAGE(COMMAND,		LEVEL_DEBUG,	2, "command %c argument %u") \
+	MESSAGE(DEFERRED,		LEVEL_DEBUG,	1, "task %u deferred (0 frame, 2 report)") \
+	MESSAGE(OVERRUN,		LEVEL_WARNING,	1, "tick of %u us") \
+	MESSAGE(EEPROM_HEALTH,	LEVEL_ERROR,	1, "eeprom health 0x%x")
+
+#define DEBUGLOG_TOKEN(name, level, arguments, format)		DEBUG_##name,
+#define DEBUGLOG_LEVEL(name, level, arguments, format)		DEBUG_LEVEL_##name = level,
+#define DEBUGLOG_ARGUMENTS(name, level, arguments, format)	DEBUG_ARGUMENTS_##name = arguments,
+
+/// \brief token of each message.
+enum eDebugToken { DEBUG_TOKEN_BASE = 0x7F,
+				   DEBUGLOG_MESSAGES(DEBUGLOG_TOKEN)
+				   DEBUG_TOKEN_END };
+
+/// \brief eDebugLevel of each message.
+enum eDebugMessageLevel { DEBUGLOG_MESSAGES(DEBUGLOG_LEVEL) DEBUG_LEVEL_END };
+
+/// \brief number of arguments of each message.
+enum eDebugMessageArguments { DEBUGLOG_MESSAGES(DEBUGLOG_ARGUMENTS) DEBUG_ARGUMENTS_END };
+
+#ifdef DEBUGLOG
+/// \brief log a message without arguments.
+#define DEBUG_LOG(name) \
+	do { if ((uint8_t)DEBUG_LEVEL_##name <= (uint8_t)(DEBUGLOG)) { \
+		static_assert(DEBUG_ARGUMENTS_##name == 0, "DEBUG_LOG: " #name " has arguments"); \
+		PE1MEW_DebugLog::put(DEBUG_##name); } } while (0)
+
+/// \brief log a message with one argument.
+#define DEBUG_LOG1(name, a) \
+	do { if ((uint8_t)DEBUG_LEVEL_##name <= (uint8_t)(DEBUGLOG)) { \
+		static_assert(DEBUG_ARGUMENTS_##name == 1, "DEBUG_LOG1: " #name " has not 1 argument"); \
+		PE1MEW_DebugLog::put(DEBUG_##name, (uint16_t)(a)); } } while (0)
+
+/// \brief log a message with two arguments.
+#define DEBUG_LOG2(name, a, b) \
+	do { if ((uint8_t)DEBUG_LEVEL_##name <= (uint8_t)(DEBUGLOG)) { \
+		static_assert(DEBUG_ARGUMENTS_##name == 2, "DEBUG_LOG2: " #name " has not 2 arguments"); \
+		PE1MEW_DebugLog::put(DEBUG_##name, (uint16_t)(a), (uint16_t)(b)); } } while (0)
+#else
+#define DEBUG_LOG(name)			do { } while (0)
+#define DEBUG_LOG1(name, a)		do { } while (0)
+#define DEBUG_LOG2(name, a, b)	do { } while (0)
+#endif
+
+/// \class PE1MEW_DebugLog
+/// \brief Debug logger with the messages in binary tokens.
+///
+/// A message is copied with its arguments in a ring buffer in RAM, some 20 cycles per message.
+/// At the end of the tick Process() moves whole messages to the transmit buffer of Serial, whose
+/// UART interrupt sends them. Messages are logged in the main loop only, not in an interrupt.
+/// When the ring buffer is full a message is dropped and the number dropped is logged later.
+/// Use the DEBUG_LOG macros: a message above DEBUGLOG is not compiled, nor its arguments.
+class PE1MEW_DebugLog
+{
+public:
+	/// \brief copy a message without arguments to the ring buffer.
+	/// \param token eDebugToken
+	static inline void put(uint8_t token)
+	{
+		if (reserve(1))
+		{
+			_Buffer[_Head++ & DEBUGLOG_MASK] = token;
+		}
+	}
+	
+	/// \brief copy a message with one argument to the ring buffer.
+	/// \param token eDebugToken
+	/// \param a argument
+	static inline void put(uint8_t token, uint16_t a)
+	{
+		if (reserve(3))
+		{
+			uint8_t head = _Head;
+			_Buffer[head++ & DEBUGLOG_MASK] = token;
+			_Buffer[head++ & DEBUGLOG_MASK] = (uint8_t)a;
+			_Buffer[head++ & DEBUGLOG_MASK] = (uint8_t)(a >> 8);
+			_Head = head;
+		}
+	}
+	
+	/// \brief copy a message with two arguments to the ring buffer.
+	/// \param token eDebugToken
+	/// \param a first argument
+	/// \param b second argument
+	static inline void put(uint8_t token, uint16_t a, uint16_t b)
+	{
+		if (reserve(5))
+		{
+			uint8_t head = _Head;
+			_Buffer[head++ & DEBUGLOG_MASK] = token;
+			_Buffer[head++ & DEBUGLOG_MASK] = (uint8_t)a;
+			_Buffer[head++ & DEBUGLOG_MASK] = (uint8_t)(a >> 8);
+			_Buffer[head++ & DEBUGLOG_MASK] = (uint8_t)b;
+			_Buffer[head++ & DEBUGLOG_MASK] = (uint8_t)(b >> 8);
+			_Head = head;
+		}
+	}
+	
+	/// \brief move whole messages to the transmit buffer of Serial, as far as they fit.
+	/// Call once per tick, not while a binary export is being sent.
+	static void Process(void);
+	
+	/// \brief get the number of bytes of a message.
+	/// \param token eDebugToken
+	/// \return length including the token, 0 when the token is unknown.
+	static uint8_t getLength(uint8_t token);
+
+private:
+	/// \brief tell if a message fits in the ring buffer, count it as dropped when not.
+	/// \param length bytes of the message.
+	static inline bool reserve(uint8_t length)
+	{
+		if ((uint8_t)(_Head - _Tail) > DEBUGLOG_SIZE - length)
+		{
+			if (_Dropped < 0xFFFF)
+			{
+				_Dropped++;
+			}
+			return false;
+		}
+		return true;
+	}
+	
+	static uint8_t  _Buffer[DEBUGLOG_SIZE];	///< Ring buffer of the messages.
+	static uint8_t  _Head;					///< Index of the next byte put, counts beyond DEBUGLOG_SIZE.
+	static uint8_t  _Tail;					///< Index of the next byte sent, counts beyond DEBUGLOG_SIZE.
+	static uint16_t _Dropped;				///< Messages dropped since the last DEBUG_DROPPED message.
+};
+
+#endif // PE1MEW_DEBUGLOG_H
@@ -18,20 +18,56 @@
  /// \date 20-7-2016
  /// \author Remko Welling (PE1MEW)
  /// \version 1.0
+ /// \version 1.1	Added layered compositor with saturating blend and gamma correction.
+ /// \version 1.2	Replaced floating point led intensity calculation by PE1MEW_LedRing.
+ /// \version 1.3	Directions in tenths of degrees.
+ /// \version 1.4	Implemented showLed(), added setLedClear() and setLedColor().
+ /// \version 1.5	Process() can skip the frame of a tick.
+ /// \version 1.6	Cardinal marker positions computed once per frame.
+ /// \version 1.7	Removed the unused halfLedStep from ledIntensity().
 
 #include "pe1mew_displaycontrol.h"
 
 #include <math.h>
+#include <avr/pgmspace.h>
+
+/// \brief gamma correction table (gamma 2.2) stored in flash.
+/// Index is the linear intensity, value is the intensity send to the led.
+/// Non-zero intensities map to at least 1 so the tail of a direction stays visible.
+static const uint8_t PROGMEM gammaTable[256] = {
+	  0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+	  1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+	  3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+	  6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+	 12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+	 20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+	 30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+	 42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+	 56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+	 73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+	 91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+	113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+	137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+	163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+	192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+	223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+
+/// \brief add two intensities and limit the result to 255.
+static inline uint8_t addSaturated(uint8_t a, uint8_t b)
+{
+	uint16_t sum = (uint16_t)a + b;
+	return (sum > 0xFF) ? 0xFF : (uint8_t)sum;
+}
 
 PE1MEW_DisplayControl::PE1MEW_DisplayControl():
     pixels(LEDCOUNT, PIN, NEO_GRB + NEO_KHZ800),
 	_CurrentDirection(0),
     _NextDirection(0),
     _brightness(128),
-	_RotorRunning(false)
+	_RotorRunning(false),
+	_layers(LAYER_DEFAULT)
 {
-	_ledStep = MAXDegrees / LEDCOUNT;
-	
 	initialize();
 }
 
@@ -42,10 +78,9 @@ PE1MEW_DisplayControl::PE1MEW_DisplayControl(uint8_t  brightness = 255,
 	_CurrentDirection(currentDirection),
     _NextDirection(nextDirection),
     _brightness(brightness),
-	_RotorRunning(false)
+	_RotorRunning(false),
+	_layers(LAYER_DEFAULT)
 {
-    _ledStep = MAXDegrees / LEDCOUNT;
-	
 	initialize();
 }
 
@@ -54,12 +89,27 @@ void PE1MEW_DisplayControl::initialize(void)
 	// This initializes the NeoPixel library.
 	pixels.begin();
 
+	for (uint8_t i = 0; i < PRESETCOUNT; i++)
+	{
+		_presetDirection[i] = PRESET_UNUSED;
+	}
+#ifdef DISPLAYBENCHMARK
+	_ledStep = MAXDegrees / LEDCOUNT;
+	_legacyTime = 0;
+	_composeTime = 0;
+#endif
 }
 
-void PE1MEW_DisplayControl::Process(void)
+void PE1MEW_DisplayControl::Process(bool show)
 {
-	pixels.clear();
+	if (!show)
+	{
+		return;
+	}
 	
+#ifdef DISPLAYBENCHMARK
+	uint32_t startTime = micros();
+	pixels.clear();
 	if (_RotorRunning)
 	{
 		setLedActive();
@@ -68,7 +118,14 @@ void PE1MEW_DisplayControl::Process(void)
 	{
 		setLedIdle();
 	}
-
+	_legacyTime = (uint16_t)(micros() - startTime);
+	
+	startTime = micros();
+	composeFrame();
+	_composeTime = (uint16_t)(micros() - startTime);
+#else
+	composeFrame();
+#endif
 	
 	// This sends the updated pixel color to the hardware.
 	
@@ -76,6 +133,91 @@ void PE1MEW_DisplayControl::Process(void)
 	pixels.show();
 }
 
+void PE1MEW_DisplayControl::setPresetDirection(uint8_t index, uint16_t angle)
+{
+	if (index < PRESETCOUNT)
+	{
+		_presetDirection[index] = angle;
+	}
+}
+
+void PE1MEW_DisplayControl::composeFrame(void)
+{
+	uint8_t red, green, blue, intensity;
+	uint16_t currentPosition = LedRing::position(_CurrentDirection);
+	uint16_t nextPosition = LedRing::position(_NextDirection);
+	uint16_t presetPosition[PRESETCOUNT];
+	uint16_t cardinalPosition[CARDINALCOUNT];
+	
+	for (uint8_t preset = 0; preset < PRESETCOUNT; preset++)
+	{
+		presetPosition[preset] = LedRing::position(_presetDirection[preset]);
+	}
+	
+	for (uint8_t marker = 0; marker < CARDINALCOUNT; marker++)
+	{
+		cardinalPosition[marker] = LedRing::position(marker * (MAXDegrees / CARDINALCOUNT));
+	}
+	
+	for (uint8_t i = 0; i < LEDCOUNT; i++)
+	{
+		red = 0;
+		green = 0;
+		blue = 0;
+		
+		// Current direction: red when running, green when idle.
+		if (_layers & LAYER_CURRENT)
+		{
+			intensity = LedRing::intensity(i, currentPosition);
+			if (_RotorRunning)
+			{
+				red = addSaturated(red, intensity);
+			}
+			else
+			{
+				green = addSaturated(green, intensity);
+			}
+		}
+		
+		// Next direction: blue, only when running.
+		if ((_layers & LAYER_NEXT) && _RotorRunning)
+		{
+			blue = addSaturated(blue, LedRing::intensity(i, nextPosition));
+		}
+		
+		// North, east, south and west markers in dimmed white.
+		if (_layers & LAYER_CARDINAL)
+		{
+			for (uint8_t marker = 0; marker < CARDINALCOUNT; marker++)
+			{
+				intensity = LedRing::intensity(i, cardinalPosition[marker]) >> MARKERSHIFT;
+				red   = addSaturated(red, intensity);
+				green = addSaturated(green, intensity);
+				blue  = addSaturated(blue, intensity);
+			}
+		}
+		
+		// Preset directions in dimmed yellow.
+		if (_layers & LAYER_PRESET)
+		{
+			for (uint8_t preset = 0; preset < PRESETCOUNT; preset++)
+			{
+				if (_presetDirection[preset] <= MAXDegrees)
+				{
+					intensity = LedRing::intensity(i, presetPosition[preset]) >> MARKERSHIFT;
+					red   = addSaturated(red, intensity);
+					green = addSaturated(green, intensity);
+				}
+			}
+		}
+		
+		pixels.setPixelColor(i, pgm_read_byte(&gammaTable[red]),
+								pgm_read_byte(&gammaTable[green]),
+								pgm_read_byte(&gammaTable[blue]));
+	}
+}
+
+#ifdef DISPLAYBENCHMARK
 void PE1MEW_DisplayControl::setLedActive(void)
 {
 	uint8_t red = 0, blue = 0, green = 0;
@@ -157,7 +299,6 @@ uint8_t PE1MEW_DisplayControl::ledIntensity(uint8_t led, int16_t angle)
 {
     uint8_t returnValue = 0;
     float AngleNormalised = 0;
-    float halfLedStep = floor(_ledStep / 2.0);
 
     int16_t ledAngle = led * _ledStep;
     AngleNormalised = normaliseAngle(angle);
@@ -194,6 +335,7 @@ int16_t PE1MEW_DisplayControl::normaliseAngle(uint16_t angle)
 	returnValue = angle - (( angle / _ledStep ) * _ledStep);
 	return returnValue;
 }
+#endif
 
 void PE1MEW_DisplayControl::showLedClear(void)
 {
@@ -214,10 +356,19 @@ void PE1MEW_DisplayControl::showLedColor(uint8_t led, uint32_t color)
 	pixels.show();
 }
 
-/// \todo remove function
+void PE1MEW_DisplayControl::setLedClear(void)
+{
+	pixels.clear();
+}
+
+void PE1MEW_DisplayControl::setLedColor(uint8_t led, uint32_t color)
+{
+	pixels.setPixelColor(led, color);
+}
+
 void PE1MEW_DisplayControl::showLed(void)
 {
-	
+	pixels.show();
 }
 
 void PE1MEW_DisplayControl::displayTest(void)
@@ -19,6 +19,14 @@
 /// \author Remko Welling (PE1MEW)
 /// \version 1.0
 /// \version 1.1	Added define for include of Neopixel library to select right include for using Atmel Studio of Arduino IDE. 
+/// \version 1.2	Replaced setLedActive() and setLedIdle() by a layered compositor with saturating blend and gamma correction.
+/// \version 1.3	Led positions are calculated by PE1MEW_LedRing in fixed point for any number of leds.
+/// \version 1.4	Directions in tenths of degrees.
+/// \version 1.5	Added setLedClear() and setLedColor() to build a led pattern that is shown once by showLed().
+/// \version 1.6	Optional output of the frame through the SPI with PE1MEW_NeoPixelSpi.
+/// \version 1.7	Process() can skip the frame, time of show() in DISPLAY_SHOW_TIME.
+/// \version 1.8	Added CARDINALCOUNT.
+/// \version 1.9	_ledStep is a uint16_t in tenths of degrees.
 
 // \todo move static variables within scope of class?
 
@@ -27,12 +35,25 @@
 
 #include <stdint.h>
 
+#include "pe1mew_ledring.h"
+
 #if defined(ARDUINO)				// test for usage of Arduino IDE
 #	include "Adafruit_NeoPixel.h"	// Use Arduino compatible include
 #else
 #	include "../AdaFruit/Adafruit_NeoPixel.h"
 #endif
 
+/// \brief Uncomment to send the frame through the SPI with interrupts enabled, see pe1mew_neopixelspi.h.
+/// The data line of the Neopixel ring moves from PIN to MOSI, pin 11.
+//#define NEOPIXELSPI
+
+#ifdef NEOPIXELSPI
+#include "pe1mew_neopixelspi.h"
+static const uint16_t DISPLAY_SHOW_TIME = 1700;	///< uS to send a frame through the SPI, interrupts enabled.
+#else
+static const uint16_t DISPLAY_SHOW_TIME = 800;	///< uS to send a frame with the Adafruit library, 30 uS per led with interrupts disabled.
+#endif
+
 /// \brief enum for predefined colors
 enum eColor { RED = 0x00FF0000, 	///< Red
 			  GREEN = 0x0000FF00, 	///< Green
@@ -43,11 +64,31 @@ enum eColor { RED = 0x00FF0000, 	///< Red
 /// Settings required for the Adafruit Neopixel ring.
 // Which pin on the Arduino is connected to the NeoPixels?
 // On a Trinket or Gemma we suggest changing this to 1
-static uint8_t PIN = 6;				///< Pin to which the Neopixel ring is connected.
+static const uint8_t PIN = 6;				///< Pin to which the Neopixel ring is connected.
 
 // How many NeoPixels are attached to the Arduino?
-static uint8_t  LEDCOUNT   = 24;	///< Number of leds in the Neopixel ring.
-static uint16_t MAXDegrees = 360;	///< Total number of degrees in on a compass card.
+static const uint8_t LEDCOUNT = 24;	///< Number of leds in the Neopixel ring.
+static const uint16_t MAXDegrees = 3600;	///< Total number of tenths of degrees in on a compass card.
+
+/// Settings for the display layers.
+static const uint8_t PRESETCOUNT = 4;		///< Number of preset directions that can be shown on the compass card.
+static const uint16_t PRESET_UNUSED = 0xFFFF;	///< Value of a preset direction that is not in use.
+static const uint8_t  MARKERSHIFT   = 3;		///< Marker layers are dimmed by shifting their intensity right by this number of bits.
+static const uint8_t  CARDINALCOUNT = 4;		///< Number of cardinal markers: north, east, south and west.
+
+/// \brief Uncomment to measure the time in uS of the legacy renderer and the compositor in Process().
+/// Results are available through getLegacyTime() and getComposeTime().
+//#define DISPLAYBENCHMARK
+
+/// \brief layers that can be composed in to one frame on the compass card.
+/// Layers are bit flags and can be combined.
+enum eDisplayLayer { LAYER_CURRENT  = 0x01,	///< Current direction, red when rotor is running, green when idle.
+					 LAYER_NEXT     = 0x02,	///< Next direction in blue, only shown when rotor is running.
+					 LAYER_CARDINAL = 0x04,	///< Dimmed white markers at north, east, south and west.
+					 LAYER_PRESET   = 0x08,	///< Dimmed yellow markers at the preset directions.
+					 LAYER_DEFAULT  = LAYER_CURRENT | LAYER_NEXT };	///< Layers shown after power-up.
+
+typedef PE1MEW_LedRing<LEDCOUNT> LedRing;	///< Geometry of the Neopixel ring.
 
 /// \class PE1MEW_DisplayControl
 /// \brief All functions to show information on the Neopixel ring.
@@ -64,21 +105,22 @@ public:
 	/// \brief overloaded constructor
 	/// This allows to set variables at creation of the object.
 	/// \param brightness the initial brightness of the NeoPixel leds. value shall be between 0 (off) and 255 (maximum).
-	/// \param nextDirection the next direction in degrees to which the rotor controller shall turn. this value should be the same as the current angle.
-	/// \param currentAngle current direction in degrees of antenna. This value should be the last stored direction from memory.
+	/// \param nextDirection the next direction in tenths of degrees to which the rotor controller shall turn. this value should be the same as the current angle.
+	/// \param currentAngle current direction in tenths of degrees of antenna. This value should be the last stored direction from memory.
     PE1MEW_DisplayControl(uint8_t  brightness,
                           uint16_t nextDirection,
                           uint16_t currentAngle);
 
 	/// \brief at systick executed function for housekeeping of the Display controller.
-	void Process(void);
+	/// \param show false to skip the frame of this tick, it is composed and send at the next tick.
+	void Process(bool show = true);
 
 	/// \brief set current direction of the rotor controller.
-	/// \param angle direction in degrees.
+	/// \param angle direction in tenths of degrees.
 	void setCurrentDirection(uint16_t angle){_CurrentDirection = angle;}
 	
 	/// \brief set the next direction t which the antenna shall be turned.
-	/// \param angle direction in degrees.
+	/// \param angle direction in tenths of degrees.
     void setNextDirection(uint16_t angle){_NextDirection = angle;}
 	
 	/// \brief Set brightness of the NeoPixel leds. 
@@ -90,10 +132,39 @@ public:
 	/// \param state When true motor is running.
 	void setRotorRunning(bool state){_RotorRunning = state;}
 	
+	/// \brief select the layers that are composed on the compass card.
+	/// \param layers combination of eDisplayLayer flags.
+	void setLayers(uint8_t layers){_layers = layers;}
+	
+	/// \brief set a preset direction shown in the preset layer.
+	/// \param index of the preset (0 to PRESETCOUNT - 1).
+	/// \param angle direction in tenths of degrees, PRESET_UNUSED to remove the preset.
+	void setPresetDirection(uint8_t index, uint16_t angle);
+
+#ifdef DISPLAYBENCHMARK
+	/// \brief get duration of the last run of the legacy renderer.
+	/// \return time in uS.
+	uint16_t getLegacyTime(void){return _legacyTime;}
+	
+	/// \brief get duration of the last run of the compositor.
+	/// \return time in uS.
+	uint16_t getComposeTime(void){return _composeTime;}
+#endif
+
 	/// \todo functions shall be revised.
 	void showLedClear(void);
 	void showLedBrightness(uint8_t brightness);
 	void showLedColor(uint8_t led, uint32_t color);
+	
+	/// \brief clear all leds without sending the frame to the Neopixel ring.
+	void setLedClear(void);
+	
+	/// \brief set color of one led without sending the frame to the Neopixel ring.
+	/// \param led lednumber (0 to ledcount - 1 in neopixel ring)
+	/// \param color 0x00RRGGBB
+	void setLedColor(uint8_t led, uint32_t color);
+	
+	/// \brief send the frame set by setLedClear() and setLedColor() to the Neopixel ring.
 	void showLed(void);
     
 private:
@@ -102,17 +173,34 @@ private:
 	// Note that for older NeoPixel strips you might need to change the third parameter--see the strand test
 	// example for more information on possible values.
 	// = Adafruit_NeoPixel(NUMPIXELS, PIN, NEO_GRB + NEO_KHZ800);
+#ifdef NEOPIXELSPI
+	PE1MEW_NeoPixelSpi<LEDCOUNT> pixels;	///< Neopixel leds on the SPI.
+#else
 	Adafruit_NeoPixel pixels;				///< Neopixel library object to control Neopixel leds.
+#endif
 	
-    uint16_t _CurrentDirection;				///< Current or actual direction of rotor in degrees
-    uint16_t _NextDirection;				///< Wanted direction of rotor in degrees
+    uint16_t _CurrentDirection;				///< Current or actual direction of rotor in tenths of degrees
+    uint16_t _NextDirection;				///< Wanted direction of rotor in tenths of degrees
 	uint8_t  _brightness;					///< brightness of the Neopixel leds. 0=off 255=maximum.
     bool	 _RotorRunning;					///< state of the rotor motor. true=running, false=stop.
-	uint8_t  _ledStep;						///< angle in degrees between two led of the NeoPixel ring.
+	uint8_t  _layers;						///< eDisplayLayer flags of the layers that are composed.
+	uint16_t _presetDirection[PRESETCOUNT];	///< Preset directions in tenths of degrees, PRESET_UNUSED when not in use.
+#ifdef DISPLAYBENCHMARK
+	uint16_t _ledStep;						///< angle in tenths of degrees between two led of the NeoPixel ring.
+	uint16_t _legacyTime;					///< duration of the last run of the legacy renderer in uS.
+	uint16_t _composeTime;					///< duration of the last run of the compositor in uS.
+#endif
 	
 	/// \brief Helper function of contructor to initialize variables.
 	void	initialize(void);
 	
+	/// \brief Compose all active layers in to the frame buffer of the Neopixel ring.
+	/// The led position of each layer is calculated once per frame. Each led is calculated once:
+	/// the intensities of all layers are added with saturation and the result is gamma corrected
+	/// before it is written to the frame buffer.
+	void	composeFrame(void);
+
+#ifdef DISPLAYBENCHMARK
 	///\brief Displays Next- and Currentdirection on the compas card in 2 colors
 	/// Next direction is in blue, current direction is red.
 	/// This function is used when motor is running or at test and configuration modes
@@ -133,6 +221,7 @@ private:
 	/// This function is used by setLedActive() and setLedIdle()
 	/// \param angle in degrees (0-360)
 	int16_t normaliseAngle(uint16_t angle);
+#endif
 	
 	void displayTest(void);
 
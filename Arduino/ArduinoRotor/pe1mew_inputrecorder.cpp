@@ -0,0 +1,165 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_inputrecorder.cpp
+ /// \brief Input recorder class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	startExport() uses getExporting().
+
+#include "pe1mew_inputrecorder.h"
+
+#include "Arduino.h"
+
+PE1MEW_InputRecorder::PE1MEW_InputRecorder():
+	_Length(0),
+	_Tick(0),
+	_EventTick(0),
+	_Buttons(0),
+	_Relays(0),
+	_Full(false),
+	_ExportPosition(0),
+	_ExportLength(0),
+	_TailLength(0)
+{
+}
+
+void PE1MEW_InputRecorder::Initialize(uint8_t buttons, uint16_t direction, uint16_t runtime, uint8_t brightness)
+{
+	_Buffer[0] = RECORDER_FORMAT;
+	_Buffer[1] = buttons;
+	_Buffer[2] = (uint8_t)(direction >> 8);
+	_Buffer[3] = (uint8_t)direction;
+	_Buffer[4] = (uint8_t)(runtime >> 8);
+	_Buffer[5] = (uint8_t)runtime;
+	_Buffer[6] = brightness;
+	_Length = RECORDER_HEADER;
+	_Buttons = buttons;
+	_Relays = 0;
+	_Full = false;
+	_Tick = 0;
+	_EventTick = 0;
+}
+
+void PE1MEW_InputRecorder::recordButtons(uint8_t buttons)
+{
+	if (buttons != _Buttons)
+	{
+		_Buttons = buttons;
+		addEvent(RECORD_BUTTONS, buttons, 0);
+	}
+}
+
+void PE1MEW_InputRecorder::recordDirection(uint16_t direction)
+{
+	addEvent(RECORD_DIRECTION, 0, direction);
+}
+
+void PE1MEW_InputRecorder::Process(bool relay1, bool relay2)
+{
+	uint8_t relays = (relay1 ? 0x01 : 0x00) | (relay2 ? 0x02 : 0x00);
+	
+	if (relays != _Relays)
+	{
+		_Relays = relays;
+		addEvent(RECORD_RELAYS, relays, 0);
+	}
+	_Tick++;
+	
+	// Export: send as many characters as fit in the transmit buffer of the serial port.
+	while (_ExportPosition < _ExportLength + _TailLength && Serial.availableForWrite() > 3)
+	{
+		uint8_t value = (_ExportPosition < _ExportLength) ? _Buffer[_ExportPosition] : _Tail[_ExportPosition - _ExportLength];
+		if (value < 0x10)
+		{
+			Serial.print('0');
+		}
+		Serial.print(value, HEX);
+		_ExportPosition++;
+		
+		if (_ExportPosition == _ExportLength + _TailLength)
+		{
+			Serial.println();
+		}
+	}
+}
+
+void PE1MEW_InputRecorder::startExport(void)
+{
+	if (getExporting())
+	{
+		return;
+	}
+	
+	_ExportLength = _Length;
+	_TailLength = 0;
+	if (!_Full)									// End the export at this tick.
+	{
+		_TailLength = encodeEvent(_Tail, RECORD_END, 0, 0);
+	}
+	_ExportPosition = 0;
+	Serial.print('R');
+}
+
+void PE1MEW_InputRecorder::addEvent(uint8_t type, uint8_t data, uint16_t value)
+{
+	uint8_t event[RECORDER_EVENT_MAX];
+	uint8_t length = 0;
+	
+	if (_Length == 0 || _Full)
+	{
+		return;									// Not initialized or full.
+	}
+	
+	length = encodeEvent(event, type, data, value);
+	if (_Length + length > RECORDER_SIZE - RECORDER_EVENT_MAX)
+	{
+		length = encodeEvent(event, RECORD_END, 0x01, 0);	// Full: inputs after this tick are not recorded.
+		_Full = true;
+	}
+	memcpy(&_Buffer[_Length], event, length);
+	_Length += length;
+	_EventTick = _Tick;
+}
+
+uint8_t PE1MEW_InputRecorder::encodeEvent(uint8_t* event, uint8_t type, uint8_t data, uint16_t value)
+{
+	uint32_t delta = _Tick - _EventTick;
+	uint8_t length = 1;
+	
+	if (delta < 15)
+	{
+		event[0] = type | (uint8_t)(delta << 2) | data;
+	}
+	else
+	{
+		event[0] = type | (15 << 2) | data;
+		delta -= 15;
+		do
+		{
+			event[length] = (uint8_t)(delta & 0x7F) | ((delta > 0x7F) ? 0x80 : 0x00);
+			delta >>= 7;
+			length++;
+		} while (delta > 0);
+	}
+	
+	if (type == RECORD_DIRECTION)
+	{
+		event[length++] = (uint8_t)(value >> 8);
+		event[length++] = (uint8_t)value;
+	}
+	return length;
+}
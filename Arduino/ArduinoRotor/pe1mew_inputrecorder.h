@@ -0,0 +1,116 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_inputrecorder.h
+ /// \brief Input recorder class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Added getExporting().
+
+#ifndef PE1MEW_INPUTRECORDER_H
+#define PE1MEW_INPUTRECORDER_H
+
+#include <stdint.h>
+
+static const uint8_t RECORDER_SIZE = 128;		///< Size of the recording in bytes, including the header.
+static const uint8_t RECORDER_FORMAT = 0x01;	///< Version of the recording format, first byte of the header.
+static const uint8_t RECORDER_HEADER = 7;		///< Size of the header in bytes.
+static const uint8_t RECORDER_EVENT_MAX = 8;	///< Largest event in bytes: header, 5 bytes delta and 2 bytes value.
+
+/// \brief types of events in a recording, bit 7 and 6 of the event byte.
+enum eRecorderEvent { RECORD_BUTTONS = 0x00,	///< Buttons changed, eButtonState in bit 1 and 0
+					  RECORD_RELAYS = 0x40,		///< Relays changed, bit 0 relay 1 active, bit 1 relay 2 active
+					  RECORD_DIRECTION = 0x80,	///< Next direction set by a serial command, 2 bytes MSB first follow
+					  RECORD_END = 0xC0 };		///< End of the recording, bit 0 set when the recording is full
+
+/// \class PE1MEW_InputRecorder
+/// \brief Records the buttons, serial directions and relays from power-up for replay in the simulator.
+///
+/// The recording starts with a header:
+/// - byte 0: RECORDER_FORMAT
+/// - byte 1: buttons at power-up as eButtonState
+/// - byte 2, 3: direction in EEPROM at power-up in tenths of degrees, MSB first
+/// - byte 4, 5: runtime in EEPROM at power-up in ticks, MSB first
+/// - byte 6: brightness in EEPROM at power-up
+///
+/// Each event is one byte: the eRecorderEvent type in bit 7 and 6, the number of ticks since
+/// the previous event (0-14) in bit 5 to 2 and the data in bit 1 and 0. When there are 15 or more
+/// ticks between events, bit 5 to 2 are 15 and the number of ticks minus 15 follows in 7 bit groups,
+/// least significant first, bit 7 set when more groups follow. Ticks count from 0 at the first
+/// Process() of the controller; buttons are recorded before and relays after the tick is processed.
+///
+/// The recording is exported with the serial command "R" as one line: "R" followed by the bytes
+/// in hexadecimal and a RECORD_END event at the tick of the command. The line is send in parts
+/// at each tick, so the sys tick is not delayed.
+class PE1MEW_InputRecorder
+{
+public:
+	/// \brief Default constructor
+	PE1MEW_InputRecorder();
+	
+	/// \brief start the recording with the settings at power-up.
+	/// \param buttons buttons at power-up as eButtonState.
+	/// \param direction direction in tenths of degrees.
+	/// \param runtime runtime in ticks.
+	/// \param brightness brightness of the leds.
+	void Initialize(uint8_t buttons, uint16_t direction, uint16_t runtime, uint8_t brightness);
+	
+	/// \brief record the buttons, at the start of a tick.
+	/// \param buttons buttons as eButtonState.
+	void recordButtons(uint8_t buttons);
+	
+	/// \brief record a next direction set by a serial command.
+	/// \param direction in tenths of degrees.
+	void recordDirection(uint16_t direction);
+	
+	/// \brief record the relays and end the tick. Sends the next part of an export.
+	/// \param relay1 relay 1 is active.
+	/// \param relay2 relay 2 is active.
+	void Process(bool relay1, bool relay2);
+	
+	/// \brief start to export the recording over the serial port.
+	void startExport(void);
+	
+	/// \brief tell if the export runs, no other text shall be sent on the serial port meanwhile.
+	bool getExporting(void){return _ExportPosition < _ExportLength + _TailLength;}
+
+private:
+	uint8_t  _Buffer[RECORDER_SIZE];	///< Header and events.
+	uint8_t  _Length;					///< Bytes in _Buffer.
+	uint32_t _Tick;						///< Ticks since the first Process().
+	uint32_t _EventTick;				///< Tick of the last event.
+	uint8_t  _Buttons;					///< Last recorded buttons.
+	uint8_t  _Relays;					///< Last recorded relays.
+	bool	 _Full;						///< Recording ended by a RECORD_END event because it is full.
+	uint8_t  _ExportPosition;			///< Next byte to export, _ExportLength when no export is running.
+	uint8_t  _ExportLength;				///< Bytes of _Buffer to export followed by _Tail.
+	uint8_t  _Tail[RECORDER_EVENT_MAX];	///< RECORD_END event of the export.
+	uint8_t  _TailLength;				///< Bytes in _Tail.
+	
+	/// \brief add an event to the recording.
+	/// The last RECORDER_EVENT_MAX bytes are kept for the RECORD_END event of a full recording.
+	/// \param type eRecorderEvent
+	/// \param data bit 1 and 0 of the event
+	/// \param value value of a RECORD_DIRECTION event
+	void addEvent(uint8_t type, uint8_t data, uint16_t value);
+	
+	/// \brief encode an event.
+	/// \param[out] event at least RECORDER_EVENT_MAX bytes
+	/// \return length of the event in bytes.
+	uint8_t encodeEvent(uint8_t* event, uint8_t type, uint8_t data, uint16_t value);
+};
+
+#endif // PE1MEW_INPUTRECORDER_H
@@ -0,0 +1,81 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software:
+  you can redistribute it and/or modify it under the terms of a Creative
+  Commons Attribution-NonCommercial 4.0 International License
+  (http://creativecommons.org/licenses/by-nc/4.0/) by
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that
+  it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file pe1mew_ledring.h
+/// \brief Led ring geometry for PE1MEW Arduino Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+
+#ifndef PE1MEW_LEDRING_H
+#define PE1MEW_LEDRING_H
+
+#include <stdint.h>
+
+/// \class PE1MEW_LedRing
+/// \brief Maps directions on to a led ring of any size.
+///
+/// A direction in tenths of degrees is converted to a led position in 8.8 fixed point: the
+/// high byte is the led below the direction, the low byte is the fraction towards the next led.
+/// The step between two leds is a compile-time constant with 16 fractional bits, so
+/// rings of 16, 32 or 60 leds get exact spacing (22.5, 11.25, 6 degrees) without floats
+/// and the cost of a conversion does not depend on the number of leds.
+/// \tparam LEDS number of leds in the ring (1 to 255).
+template <uint8_t LEDS>
+class PE1MEW_LedRing
+{
+public:
+	static_assert(LEDS > 0, "led ring shall have at least one led");
+
+	static const uint16_t DEGREES = 3600;		///< Total number of tenths of degrees on the compass card.
+	static const uint32_t STEP = ((uint32_t)LEDS << 24) / DEGREES;	///< Led position per tenth of a degree, 8.8 position with 16 extra fractional bits.
+
+	/// \brief convert a direction to a led position.
+	/// \param angle direction in tenths of degrees (0-3600)
+	/// \return led position in 8.8 fixed point, led number in the high byte.
+	static uint16_t position(uint16_t angle)
+	{
+		uint16_t returnValue = (uint16_t)(((uint32_t)angle * STEP + 0x8000) >> 16);
+		if (returnValue >= ((uint16_t)LEDS << 8))
+		{
+			returnValue -= ((uint16_t)LEDS << 8);	// 3600 tenths of degrees is led 0
+		}
+		return returnValue;
+	}
+
+	/// \brief calculate the intensity of a led for a led position.
+	/// The led below the position and the led above share 255 in proportion to the fraction.
+	/// The led above the last led is led 0.
+	/// \param led lednumber (0 to LEDS - 1)
+	/// \param position led position from position()
+	/// \return intensity of the led (0 = off, 255 - maximal)
+	static uint8_t intensity(uint8_t led, uint16_t position)
+	{
+		uint8_t lower = (uint8_t)(position >> 8);
+		uint8_t fraction = (uint8_t)position;
+
+		if (led == lower)
+		{
+			return 0xFF - fraction;
+		}
+		if (led == ((lower + 1 < LEDS) ? lower + 1 : 0))
+		{
+			return fraction;
+		}
+		return 0;
+	}
+};
+
+#endif // PE1MEW_LEDRING_H
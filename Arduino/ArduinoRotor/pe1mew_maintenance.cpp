@@ -0,0 +1,151 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_maintenance.cpp
+ /// \brief Maintenance counter class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+
+#include "pe1mew_maintenance.h"
+
+#include "Arduino.h"
+#include <EEPROM.h>
+
+static const uint8_t  TICKS_PER_SECOND = 100;			///< Sys ticks in a second.
+static const uint16_t SEQUENCE_EMPTY = 0xFFFF;			///< Sequence number of erased EEPROM, not used.
+
+PE1MEW_MaintenanceCounter::PE1MEW_MaintenanceCounter():
+	_Counter(),
+	_MotorTicks(0),
+	_Relays(0),
+	_IdleTicks(0),
+	_RecordTicks(0),
+	_Changed(false),
+	_Sequence(0),
+	_Slot(0),
+	_RecordByte(MAINTENANCE_SLOT_SIZE),
+	_Record()
+{
+	bool found = false;
+	
+	for (uint8_t slot = 0; slot < MAINTENANCE_SLOTS; slot++)
+	{
+		uint8_t record[MAINTENANCE_SLOT_SIZE];
+		for (uint8_t i = 0; i < MAINTENANCE_SLOT_SIZE; i++)
+		{
+			record[i] = EEPROM.read(MAINTENANCE_START + (uint16_t)slot * MAINTENANCE_SLOT_SIZE + i);
+		}
+		
+		uint16_t sequence = ((uint16_t)record[0] << 8) | record[1];
+		if (sequence == SEQUENCE_EMPTY || record[MAINTENANCE_SLOT_SIZE - 1] != getCheck(record))
+		{
+			continue;				// erased or written partly
+		}
+		
+		// The newest is found across the wrap of the sequence number, as in the journal.
+		if (!found || (int16_t)(sequence - (_Sequence - 1)) > 0)
+		{
+			found = true;
+			_Sequence = sequence + 1;
+			_Slot = (slot + 1) % MAINTENANCE_SLOTS;
+			for (uint8_t counter = 0; counter < COUNTERS; counter++)
+			{
+				const uint8_t* value = &record[2 + counter * 4];
+				_Counter[counter] = ((uint32_t)value[0] << 24) | ((uint32_t)value[1] << 16) | ((uint32_t)value[2] << 8) | value[3];
+			}
+		}
+	}
+	_Sequence = (_Sequence == SEQUENCE_EMPTY) ? 0 : _Sequence;
+}
+
+bool PE1MEW_MaintenanceCounter::Process(bool relay1, bool relay2, bool write)
+{
+	uint8_t relays = (relay1 ? 0x01 : 0x00) | (relay2 ? 0x02 : 0x00);
+	uint8_t closed = relays & ~_Relays;
+	
+	if (closed & 0x01)
+	{
+		_Counter[COUNTER_RELAY1]++;
+	}
+	if (closed & 0x02)
+	{
+		_Counter[COUNTER_RELAY2]++;
+	}
+	if ((relays & 0x01) && ++_MotorTicks >= TICKS_PER_SECOND)
+	{
+		_MotorTicks = 0;
+		_Counter[COUNTER_MOTOR]++;
+	}
+	_Changed |= (relays != 0);
+	_Relays = relays;
+	_IdleTicks = (relays != 0) ? 0 : ((_IdleTicks < MAINTENANCE_IDLE_TICKS) ? _IdleTicks + 1 : _IdleTicks);
+	_RecordTicks = (_RecordTicks < MAINTENANCE_INTERVAL) ? _RecordTicks + 1 : _RecordTicks;
+	
+	if (_RecordByte >= MAINTENANCE_SLOT_SIZE && _Changed && _IdleTicks >= MAINTENANCE_IDLE_TICKS && _RecordTicks >= MAINTENANCE_INTERVAL)
+	{
+		_Record[0] = (uint8_t)(_Sequence >> 8);
+		_Record[1] = (uint8_t)_Sequence;
+		for (uint8_t counter = 0; counter < COUNTERS; counter++)
+		{
+			uint8_t* value = &_Record[2 + counter * 4];
+			value[0] = (uint8_t)(_Counter[counter] >> 24);
+			value[1] = (uint8_t)(_Counter[counter] >> 16);
+			value[2] = (uint8_t)(_Counter[counter] >> 8);
+			value[3] = (uint8_t)_Counter[counter];
+		}
+		_Record[MAINTENANCE_SLOT_SIZE - 1] = getCheck(_Record);
+		_RecordByte = 0;
+		_RecordTicks = 0;
+		_Changed = false;
+	}
+	
+	if (!write || _RecordByte >= MAINTENANCE_SLOT_SIZE)
+	{
+		return false;
+	}
+	
+	// The sequence number is written last: until then the check byte does not match.
+	uint8_t index = (_RecordByte + 2) % MAINTENANCE_SLOT_SIZE;
+	EEPROM.update(MAINTENANCE_START + (uint16_t)_Slot * MAINTENANCE_SLOT_SIZE + index, _Record[index]);
+	_RecordByte++;
+	
+	if (_RecordByte == MAINTENANCE_SLOT_SIZE)
+	{
+		_Sequence = (_Sequence + 1 == SEQUENCE_EMPTY) ? 0 : _Sequence + 1;
+		_Slot = (_Slot + 1) % MAINTENANCE_SLOTS;
+	}
+	return true;
+}
+
+void PE1MEW_MaintenanceCounter::clearCounter(uint8_t counter)
+{
+	if (counter < COUNTERS)
+	{
+		_Counter[counter] = 0;
+		_Changed = true;
+		_RecordTicks = MAINTENANCE_INTERVAL;	// Written at the next idle moment.
+	}
+}
+
+uint8_t PE1MEW_MaintenanceCounter::getCheck(const uint8_t* record)
+{
+	uint8_t check = 0;
+	for (uint8_t i = 0; i < MAINTENANCE_SLOT_SIZE - 1; i++)
+	{
+		check ^= record[i];
+	}
+	return ~check;
+}
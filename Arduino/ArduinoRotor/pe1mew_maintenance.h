@@ -0,0 +1,89 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_maintenance.h
+ /// \brief Maintenance counter class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Added getPending() for the tick budget.
+
+#ifndef PE1MEW_MAINTENANCE_H
+#define PE1MEW_MAINTENANCE_H
+
+#include <stdint.h>
+
+static const uint16_t MAINTENANCE_START = 0x10;			///< EEPROM address of the maintenance counters.
+static const uint8_t  MAINTENANCE_SLOTS = 16;			///< Records of the counters, written in turn to spread the wear.
+static const uint8_t  MAINTENANCE_SLOT_SIZE = 15;		///< Bytes of a record: sequence number (2), 3 counters (4) and check byte.
+static const uint16_t MAINTENANCE_IDLE_TICKS = 500;		///< Ticks the relays are at rest before the counters are written.
+static const uint32_t MAINTENANCE_INTERVAL = 60000;		///< Minimum ticks between two records, 10 minutes.
+
+/// \brief counters of the maintenance counter.
+enum eMaintenanceCounter { COUNTER_RELAY1 = 0,	///< Times relay 1 (motor) closed
+						   COUNTER_RELAY2,		///< Times relay 2 (direction) closed
+						   COUNTER_MOTOR,		///< Seconds relay 1 was closed
+						   COUNTERS };			///< Number of counters
+
+/// \class PE1MEW_MaintenanceCounter
+/// \brief Counts the relay cycles and the time the motor runs, kept in EEPROM to plan the replacement of the relays.
+///
+/// The relays are sampled at each sys tick, in all modes; a relay can not open and close again within a tick.
+/// The counters are written to EEPROM when the relays have been at rest for MAINTENANCE_IDLE_TICKS and at most
+/// once per MAINTENANCE_INTERVAL, in the next of MAINTENANCE_SLOTS records. A record is written one byte per tick
+/// with the sequence number last; at power-up the newest record with a valid check byte is used. Cycles
+/// since the last record are lost when the power is lost.
+class PE1MEW_MaintenanceCounter
+{
+public:
+	/// \brief Default constructor, reads the newest record from EEPROM.
+	PE1MEW_MaintenanceCounter();
+	
+	/// \brief count the relays and write the next byte of a record, at each sys tick.
+	/// \param relay1 relay 1 is active.
+	/// \param relay2 relay 2 is active.
+	/// \param write the EEPROM is free in this tick.
+	/// \return true when a byte was written in this tick.
+	bool Process(bool relay1, bool relay2, bool write);
+	
+	/// \brief tell if Process() has a byte of a record to write.
+	bool getPending(void){return _RecordByte < MAINTENANCE_SLOT_SIZE;}
+	
+	/// \brief get a counter.
+	/// \param counter eMaintenanceCounter
+	/// \return cycles or seconds.
+	uint32_t getCounter(uint8_t counter){return _Counter[counter];}
+	
+	/// \brief clear a counter after the relay is replaced. It is written with the next record.
+	/// \param counter eMaintenanceCounter
+	void clearCounter(uint8_t counter);
+
+private:
+	uint32_t _Counter[COUNTERS];		///< Counters since the first start.
+	uint8_t  _MotorTicks;				///< Ticks relay 1 was closed since the last full second.
+	uint8_t  _Relays;					///< Relays in the previous tick.
+	uint16_t _IdleTicks;				///< Ticks the relays are at rest.
+	uint32_t _RecordTicks;				///< Ticks since the last record.
+	bool	 _Changed;					///< The counters changed since the last record.
+	uint16_t _Sequence;					///< Sequence number of the next record.
+	uint8_t  _Slot;						///< Slot of the next record.
+	uint8_t  _RecordByte;				///< Bytes of _Record written, MAINTENANCE_SLOT_SIZE when none is queued.
+	uint8_t  _Record[MAINTENANCE_SLOT_SIZE];	///< Record being written.
+	
+	/// \brief get the check byte of a record.
+	uint8_t getCheck(const uint8_t* record);
+};
+
+#endif // PE1MEW_MAINTENANCE_H
@@ -19,44 +19,112 @@
  /// \author Remko Welling (PE1MEW)
  /// \version 1.0	Initial version
  /// \version 1.1	Corrected readRunTimeCounter() and writeRunTimeCounter() writing to big sizes.
+ /// \version 1.2	Direction stored in tenths of degrees, memory in degrees is converted at startup.
+ /// \version 1.3	Journal of the direction while the rotor turns.
+ /// \version 1.4	Move log after the journal.
+ /// \version 1.5	Direction and runtime queued and written one byte at a time.
+ /// \version 1.6	Incremental self-test with a shadow copy of the cell under test.
+ /// \version 1.7	Change of the health logged by the debug logger.
+ /// \version 1.8	Check byte of the configuration cells, memory of a previous version is converted.
  
  
 /*
 
 	0	_memoryState
 	1	_memBrightness
-	2	_memDirection MSB
-	3	_memDirection LSB
-	4	..
-	5	..
+	2	_memDirection MSB (tenths of degrees)
+	3	_memDirection LSB (tenths of degrees)
+	4	journal sequence number of _memDirection MSB
+	5	journal sequence number of _memDirection LSB
 	6	_memRunTimeCounter MSB
 	7	_memRunTimeCounter LSB
+	0x08 - 0x0F		last watchdog reset, see pe1mew_watchdog.h
+	0x10 - 0xFF		maintenance counters, see pe1mew_maintenance.h
+	...
+	0x100 - 0x23F	journal, JOURNAL_SLOTS entries of:
+		0	sequence number MSB
+		1	sequence number LSB
+		2	direction MSB (tenths of degrees)
+		3	direction LSB (tenths of degrees)
+		4	check byte
+	0x240 - 0x3EF	move log, see pe1mew_movelog.h
+	0x3FB			check byte of 1 - 7: complement of their exclusive or
+	0x3FC - 0x3FF	self-test:
+		0	shadow state, SHADOW_ACTIVE while the cell may hold a test pattern
+		1	address of the cell under test
+		2	value of the cell under test
+		3	spare cell for the test patterns
 
 */
 
 
-#include "PE1MEW_MemoryControl.h"
+#include "pe1mew_memorycontrol.h"
+#include "pe1mew_debuglog.h"
 
 #include "Arduino.h"
 
-static uint8_t MEMORYINITIALIZED = 0x01;		///< Value indicates that memory is initialized.
+static const uint8_t MEMORYINITIALIZED = 0x03;		///< Value indicates that memory is initialized.
+static const uint8_t MEMORYNOCHECK	 = 0x02;		///< Value indicates that memory is initialized without the check byte.
+static const uint8_t MEMORYDEGREES	 = 0x01;		///< Value indicates that memory is initialized with direction in degrees.
+static const uint16_t MEMORYMAXDIRECTION = 3600;		///< Maximum direction in tenths of degrees.
 
 PE1MEW_MemoryControl::PE1MEW_MemoryControl():
-	_memRunTimeCounter(0),
-	_memDirection(0),
-	_memBrightness(MEMORYINITIALIZED)
+	_JournalSequence(0),
+	_JournalSlot(0),
+	_JournalByte(JOURNAL_SLOT_SIZE),
+	_JournalEntry(),
+	_Save(),
+	_SavePending(0),
+	_TestStep(TEST_IDLE),
+	_TestCell(TEST_FIRST_CELL),
+	_TestValue(0),
+	_VerifyAddress(0xFFFF),
+	_VerifyValue(0),
+	_ScanSlot(0),
+	_ScanDamaged(0),
+	_Damaged(0),
+	_Scans(0),
+	_Health(0)
 {
+	// The power was lost while a cell held a test pattern: its value is in the shadow copy.
+	if (EEPROM.read(SHADOW_START) == SHADOW_ACTIVE)
+	{
+		EEPROM.update(EEPROM.read(SHADOW_START + 1), EEPROM.read(SHADOW_START + 2));
+		EEPROM.update(SHADOW_START, SHADOW_IDLE);
+	}
+	
 	#ifdef FIRSTSTART							///< Test for EEProm to be initialized.
 		EEPROM.write(0,MEMORYINITIALIZED);
 	#endif
 		
+	if(EEPROM.read(0) == MEMORYDEGREES)			///< Memory of a previous version: convert direction to tenths of degrees.
+	{
+		writeDirection(readDirection() * 10);
+		EEPROM.update(0, MEMORYINITIALIZED);
+	}
+	
+	if(EEPROM.read(0) == MEMORYNOCHECK)			///< Memory of a previous version: add the check byte.
+	{
+		writeConfigCheck();
+		EEPROM.update(0, MEMORYINITIALIZED);
+	}
+	
 	if(EEPROM.read(0) != MEMORYINITIALIZED)
 	{
 		writeRunTimeCounter(36000);
 		writeBrightness(200);
-		writeDirection(100);
+		writeDirection(1000);
 		EEPROM.update(0, MEMORYINITIALIZED);
 	}
+	
+	// Continue the journal after its newest entry.
+	uint16_t direction;
+	uint8_t slot = findCheckpoint(_JournalSequence, direction);
+	if (slot < JOURNAL_SLOTS)
+	{
+		_JournalSequence++;
+		_JournalSlot = (slot + 1) % JOURNAL_SLOTS;
+	}
 }
 
 uint16_t PE1MEW_MemoryControl::readRunTimeCounter(void)
@@ -71,10 +139,13 @@ uint16_t PE1MEW_MemoryControl::readRunTimeCounter(void)
 
 void PE1MEW_MemoryControl::writeRunTimeCounter(uint16_t counterValue)
 {
+	_SavePending &= ~0x30;					// A queued runtime is older.
+	stopCellTest();
 	EEPROM.update(7, (uint8_t)counterValue);
 	EEPROM.update(6, (uint8_t)(counterValue >> 8));
 	//EEPROM.update(5, (uint8_t)(counterValue >> 16));
 	//EEPROM.update(4, (uint8_t)(counterValue >> 24));
+	writeConfigCheck();
 }
 
 uint8_t PE1MEW_MemoryControl::readBrightness(void)
@@ -84,78 +155,353 @@ uint8_t PE1MEW_MemoryControl::readBrightness(void)
 
 void PE1MEW_MemoryControl::writeBrightness(uint8_t brightness)
 {
+	stopCellTest();
 	EEPROM.update(1, brightness);
+	writeConfigCheck();
 }
 
 uint16_t PE1MEW_MemoryControl::readDirection(void)
 {
 	uint16_t returnValue = 0;
+	uint16_t sequence = 0;
+	uint16_t written = ((uint16_t)EEPROM.read(4) << 8) | EEPROM.read(5);
 	returnValue = (uint16_t)EEPROM.read(3);
 	returnValue += (uint16_t)(EEPROM.read(2) << 8);
-	if(360 < returnValue)
+	
+	// The power was lost while the rotor turned: the journal holds a newer direction.
+	uint16_t checkpoint;
+	if (findCheckpoint(sequence, checkpoint) < JOURNAL_SLOTS && (int16_t)(sequence - written) > 0)
 	{
-		returnValue = 360;	
+		returnValue = checkpoint;
+	}
+	
+	if(MEMORYMAXDIRECTION < returnValue)
+	{
+		returnValue = MEMORYMAXDIRECTION;	
 	}
 	return returnValue;
 }
 
 void PE1MEW_MemoryControl::writeDirection(uint16_t direction)
 {
+	_SavePending &= ~0x0F;					// A queued direction is older.
+	stopCellTest();
 	EEPROM.update(3, (uint8_t)direction);
 	EEPROM.update(2, (uint8_t)(direction >> 8));
+	
+	// Entries up to here are older. A queued entry is dropped, it is invalid as long as its
+	// sequence number is not written.
+	_JournalByte = JOURNAL_SLOT_SIZE;
+	EEPROM.update(5, (uint8_t)(_JournalSequence - 1));
+	EEPROM.update(4, (uint8_t)((uint16_t)(_JournalSequence - 1) >> 8));
+	writeConfigCheck();
 }
 
-bool PE1MEW_MemoryControl::memoryTest(void)
+void PE1MEW_MemoryControl::queueDirection(uint16_t direction)
 {
+	_Save[0] = (uint8_t)(direction >> 8);
+	_Save[1] = (uint8_t)direction;
 	
-	bool returnValue = true;
-	
-	// --- Test RunTimeCounter memory
-	_memRunTimeCounter = readRunTimeCounter();	///< get current value and write to temporary memory
-	
-	writeRunTimeCounter(0xFFFF);				///< write all bits of memory
-	if(readRunTimeCounter() != 0xFFFF)			///< Verify if all bits have been written
+	// As writeDirection(): the sequence number of the entries up to here, a queued entry is dropped.
+	_JournalByte = JOURNAL_SLOT_SIZE;
+	_Save[2] = (uint8_t)((uint16_t)(_JournalSequence - 1) >> 8);
+	_Save[3] = (uint8_t)(_JournalSequence - 1);
+	_SavePending |= 0x0F | SAVE_CHECK;
+}
+
+void PE1MEW_MemoryControl::queueRunTimeCounter(uint16_t counterValue)
+{
+	_Save[4] = (uint8_t)(counterValue >> 8);
+	_Save[5] = (uint8_t)counterValue;
+	_SavePending |= 0x30 | SAVE_CHECK;
+}
+
+bool PE1MEW_MemoryControl::writeCheckpoint(uint16_t direction)
+{
+	if (_JournalByte < JOURNAL_SLOT_SIZE)
+	{
+		return false;
+	}
+	setCheckpoint(direction);
+	_JournalByte = 0;
+	return true;
+}
+
+void PE1MEW_MemoryControl::commitCheckpoint(uint16_t direction)
+{
+	setCheckpoint(direction);
+	for (_JournalByte = 0; _JournalByte < JOURNAL_SLOT_SIZE; )
+	{
+		writeCheckpointByte();
+	}
+}
+
+void PE1MEW_MemoryControl::setCheckpoint(uint16_t direction)
+{
+	_JournalEntry[0] = (uint8_t)(_JournalSequence >> 8);
+	_JournalEntry[1] = (uint8_t)_JournalSequence;
+	_JournalEntry[2] = (uint8_t)(direction >> 8);
+	_JournalEntry[3] = (uint8_t)direction;
+	_JournalEntry[4] = (uint8_t)~(_JournalEntry[0] ^ _JournalEntry[1] ^ _JournalEntry[2] ^ _JournalEntry[3]);
+}
+
+bool PE1MEW_MemoryControl::Process(void)
+{
+	if (_SavePending != 0)
 	{
-		returnValue = false;								///< set result successful
+		uint8_t index = 0;
+		while (!(_SavePending & (1 << index)))
+		{
+			index++;
+		}
+		stopCellTest();
+		if (index < SAVE_SIZE)
+		{
+			EEPROM.update(SAVE_START + index, _Save[index]);
+		}
+		else
+		{
+			writeConfigCheck();					// After the bytes it covers.
+		}
+		_SavePending &= ~(1 << index);
+		return true;
 	}
 	
-	writeRunTimeCounter(_memRunTimeCounter);
-	if(readRunTimeCounter() != _memRunTimeCounter)
+	if (_JournalByte >= JOURNAL_SLOT_SIZE)
 	{
-		returnValue = false;
+		return false;
 	}
+	writeCheckpointByte();
+	return true;
+}
+
+void PE1MEW_MemoryControl::writeCheckpointByte(void)
+{
+	// The sequence number is written last: until then the check byte does not match and a slot
+	// that was written partly when the power was lost is not used.
+	static const uint8_t order[JOURNAL_SLOT_SIZE] = { 2, 3, 4, 0, 1 };
+	uint8_t index = order[_JournalByte];
 	
-	// --- Test Direction memory
-	_memDirection = readDirection();
+	EEPROM.update(JOURNAL_START + (uint16_t)_JournalSlot * JOURNAL_SLOT_SIZE + index, _JournalEntry[index]);
+	_JournalByte++;
 	
-	writeDirection(0xFF);
-	if(readDirection() != 0xFF)
+	if (_JournalByte == JOURNAL_SLOT_SIZE)
 	{
-		returnValue = false;
+		_JournalSequence++;
+		_JournalSlot = (_JournalSlot + 1) % JOURNAL_SLOTS;
 	}
+}
+
+uint8_t PE1MEW_MemoryControl::findCheckpoint(uint16_t& sequence, uint16_t& direction)
+{
+	uint8_t newest = JOURNAL_SLOTS;
 	
-	writeDirection(_memDirection);
-	if(readDirection() != _memDirection)
+	for (uint8_t slot = 0; slot < JOURNAL_SLOTS; slot++)
 	{
-		returnValue = false;
+		uint8_t entry[JOURNAL_SLOT_SIZE];
+		for (uint8_t i = 0; i < JOURNAL_SLOT_SIZE; i++)
+		{
+			entry[i] = EEPROM.read(JOURNAL_START + (uint16_t)slot * JOURNAL_SLOT_SIZE + i);
+		}
+		
+		uint16_t entrySequence = ((uint16_t)entry[0] << 8) | entry[1];
+		uint16_t entryDirection = ((uint16_t)entry[2] << 8) | entry[3];
+		if (entry[4] != (uint8_t)~(entry[0] ^ entry[1] ^ entry[2] ^ entry[3]) || entryDirection > MEMORYMAXDIRECTION)
+		{
+			continue;				// erased or written partly
+		}
+		
+		// The sequence numbers of the slots differ less than 32768: the newest is found across the wrap.
+		if (newest == JOURNAL_SLOTS || (int16_t)(entrySequence - sequence) > 0)
+		{
+			newest = slot;
+			sequence = entrySequence;
+			direction = entryDirection;
+		}
+	}
+	return newest;
+}
+
+void PE1MEW_MemoryControl::startTest(void)
+{
+	if (_TestStep == TEST_IDLE)
+	{
+		_Health &= ~HEALTH_WRITE;
+		_TestCell = TEST_FIRST_CELL;
+		_VerifyAddress = 0xFFFF;
+		_TestStep = TEST_SPARE_55;
+	}
+}
+
+bool PE1MEW_MemoryControl::ProcessTest(bool write)
+{
+	if (!write || !getTestWrite())
+	{
+		scanStep();
+		return false;
 	}
 	
-	// --- Test Brightness memory
-	_memBrightness = readBrightness();
+	switch (_TestStep)
+	{
+		case TEST_SPARE_55:
+			writeTestByte(SHADOW_START + 3, 0x55);
+			_TestStep = TEST_SPARE_AA;
+			break;
+		
+		case TEST_SPARE_AA:
+			writeTestByte(SHADOW_START + 3, 0xAA);
+			_TestStep = TEST_SHADOW_ADDRESS;
+			break;
+		
+		case TEST_SHADOW_ADDRESS:
+			_TestValue = EEPROM.read(_TestCell);
+			writeTestByte(SHADOW_START + 1, _TestCell);
+			_TestStep = TEST_SHADOW_VALUE;
+			break;
+		
+		case TEST_SHADOW_VALUE:
+			writeTestByte(SHADOW_START + 2, _TestValue);
+			_TestStep = TEST_SHADOW_ACTIVE;
+			break;
+		
+		case TEST_SHADOW_ACTIVE:
+			writeTestByte(SHADOW_START, SHADOW_ACTIVE);
+			_TestStep = TEST_CELL_PATTERN;
+			break;
+		
+		case TEST_CELL_PATTERN:
+			writeTestByte(_TestCell, (uint8_t)~_TestValue);
+			_TestStep = TEST_CELL_RESTORE;
+			break;
+		
+		case TEST_CELL_RESTORE:
+			writeTestByte(_TestCell, _TestValue);
+			_TestStep = TEST_SHADOW_IDLE;
+			break;
+		
+		case TEST_SHADOW_IDLE:
+			writeTestByte(SHADOW_START, SHADOW_IDLE);
+			_TestCell++;
+			_TestStep = (_TestCell <= TEST_LAST_CELL) ? TEST_SHADOW_ADDRESS : TEST_FINISH;
+			break;
+		
+		default:
+			// The last byte is read back, nothing is written.
+			writeTestByte(0xFFFF, 0);
+			_TestStep = TEST_IDLE;
+			return false;
+	}
+	return true;
+}
+
+void PE1MEW_MemoryControl::writeTestByte(uint16_t address, uint8_t value)
+{
+	// A byte is read back one tick after it is written, the write has completed by then.
+	if (_VerifyAddress != 0xFFFF && EEPROM.read(_VerifyAddress) != _VerifyValue)
+	{
+		_Health |= HEALTH_WRITE;
+	}
 	
-	writeBrightness(0xFF);
-	if(readBrightness() != 0xFF)
+	_VerifyAddress = address;
+	_VerifyValue = value;
+	if (address != 0xFFFF)
+	{
+		EEPROM.update(address, value);
+	}
+}
+
+void PE1MEW_MemoryControl::stopCellTest(void)
+{
+	// From TEST_SHADOW_VALUE on _TestValue is copied, up to TEST_SHADOW_IDLE the cell or the shadow state may differ.
+	if (_TestStep > TEST_SHADOW_ADDRESS && _TestStep <= TEST_SHADOW_IDLE)
 	{
-		returnValue = false;
+		EEPROM.update(_TestCell, _TestValue);
+		EEPROM.update(SHADOW_START, SHADOW_IDLE);
+		_VerifyAddress = 0xFFFF;
+		_TestStep = TEST_SHADOW_ADDRESS;
+	}
+}
+
+void PE1MEW_MemoryControl::scanStep(void)
+{
+	if (_ScanSlot < JOURNAL_SLOTS)
+	{
+		// An entry is erased, valid or the one being written. The sequence number is
+		// written last, so that entry is the only one with a check byte that does not match.
+		uint8_t entry[JOURNAL_SLOT_SIZE];
+		bool erased = true;
+		for (uint8_t i = 0; i < JOURNAL_SLOT_SIZE; i++)
+		{
+			entry[i] = EEPROM.read(JOURNAL_START + (uint16_t)_ScanSlot * JOURNAL_SLOT_SIZE + i);
+			erased &= (entry[i] == 0xFF);
+		}
+		
+		uint16_t entryDirection = ((uint16_t)entry[2] << 8) | entry[3];
+		if (!erased && (entry[4] != (uint8_t)~(entry[0] ^ entry[1] ^ entry[2] ^ entry[3]) || entryDirection > MEMORYMAXDIRECTION))
+		{
+			_ScanDamaged++;
+		}
+		_ScanSlot++;
+		return;
 	}
 	
-	writeBrightness(_memBrightness);
-	if(readBrightness() != _memBrightness)
+	// The configuration ends the scan.
+	uint8_t health = _Health & HEALTH_WRITE;
+	uint16_t direction = ((uint16_t)EEPROM.read(2) << 8) | EEPROM.read(3);
+	uint16_t runTime = readRunTimeCounter();
+	if (EEPROM.read(0) != MEMORYINITIALIZED || direction > MEMORYMAXDIRECTION || runTime == 0 || runTime == 0xFFFF ||
+		(!(_SavePending & SAVE_CHECK) && EEPROM.read(CONFIG_CHECK) != getConfigCheck()))
 	{
-		returnValue = false;
+		health |= HEALTH_CONFIG;
+	}
+	if (_ScanDamaged > 1)
+	{
+		health |= HEALTH_JOURNAL;
 	}
 	
-	return returnValue;
+	if (health != _Health)
+	{
+		DEBUG_LOG1(EEPROM_HEALTH, health);
+	}
+	_Health = health;
+	_Damaged = _ScanDamaged;
+	_ScanDamaged = 0;
+	_ScanSlot = 0;
+	_Scans++;
+}
+
+uint8_t PE1MEW_MemoryControl::getConfigCheck(void)
+{
+	uint8_t check = 0;
+	for (uint8_t cell = TEST_FIRST_CELL; cell <= TEST_LAST_CELL; cell++)
+	{
+		// From TEST_SHADOW_VALUE on the cell under test may hold its complement, see stopCellTest().
+		bool testing = cell == _TestCell && _TestStep > TEST_SHADOW_ADDRESS && _TestStep <= TEST_SHADOW_IDLE;
+		check ^= testing ? _TestValue : EEPROM.read(cell);
+	}
+	return (uint8_t)~check;
+}
+
+void PE1MEW_MemoryControl::report(void)
+{
+	Serial.print(F("eeprom "));
+	Serial.print((_Health == 0) ? F("ok") : F("fail"));
+	if (_Health & HEALTH_CONFIG)
+	{
+		Serial.print(F(" config"));
+	}
+	if (_Health & HEALTH_JOURNAL)
+	{
+		Serial.print(F(" journal"));
+	}
+	if (_Health & HEALTH_WRITE)
+	{
+		Serial.print(F(" write"));
+	}
+	Serial.print(F(" scans "));
+	Serial.print(_Scans);
+	Serial.print(F(" damaged "));
+	Serial.println(_Damaged);
 }
 
 /*
@@ -18,6 +18,12 @@
  /// \date 20-7-2016
  /// \author Remko Welling (PE1MEW)
  /// \version 1.0
+ /// \version 1.1	Direction stored in tenths of degrees.
+ /// \version 1.2	Journal of the direction while the rotor turns.
+ /// \version 1.3	Process() tells if it wrote the EEPROM.
+ /// \version 1.4	Direction and runtime queued and written one byte at a time.
+ /// \version 1.5	Replaced memoryTest() by an incremental self-test that keeps a shadow copy of the cell under test.
+ /// \version 1.6	Check byte of the configuration cells.
  
 #ifndef PE1MEW_MEMORYCONTROL_H
 #define PE1MEW_MEMORYCONTROL_H
@@ -35,6 +41,24 @@
 
 //#define FIRSTSTART
 
+static const uint16_t JOURNAL_START = 0x100;		///< EEPROM address of the journal of the direction.
+static const uint8_t  JOURNAL_SLOTS = 64;			///< Entries in the journal, written in turn to spread the wear.
+static const uint8_t  JOURNAL_SLOT_SIZE = 5;		///< Bytes of an entry: sequence number (2), direction (2) and check byte.
+static const uint8_t  SAVE_START = 2;				///< EEPROM address of the first byte written by queueDirection() and queueRunTimeCounter().
+static const uint8_t  SAVE_SIZE = 6;				///< Bytes from SAVE_START: direction (2), journal sequence number (2) and runtime (2).
+static const uint16_t CONFIG_CHECK = 0x3FB;			///< EEPROM address of the check byte of the configuration cells TEST_FIRST_CELL to TEST_LAST_CELL.
+static const uint8_t  SAVE_CHECK = 0x40;			///< Bit of the check byte in the queued bytes, written after the bytes from SAVE_START.
+static const uint16_t SHADOW_START = 0x3FC;			///< EEPROM address of the shadow copy of the self-test: state, address, value and a spare cell.
+static const uint8_t  SHADOW_IDLE = 0xFF;			///< State of the shadow copy when no cell holds a test pattern.
+static const uint8_t  SHADOW_ACTIVE = 0x5A;			///< State of the shadow copy while the cell at its address may hold a test pattern.
+static const uint8_t  TEST_FIRST_CELL = 1;			///< First configuration cell tested by the self-test.
+static const uint8_t  TEST_LAST_CELL = 7;			///< Last configuration cell tested by the self-test.
+
+/// \brief results of the self-test, bit flags, 0 is healthy.
+enum eMemoryHealth { HEALTH_CONFIG = 0x01,		///< A configuration cell is out of its range or does not match the check byte.
+					 HEALTH_JOURNAL = 0x02,		///< More than one journal entry is damaged, only the entry being written may be.
+					 HEALTH_WRITE = 0x04 };		///< A byte written by the self-test did not read back.
+
 
 /// \class PE1MEW_MemoryControl
 /// \brief Rotor steering class
@@ -61,24 +85,127 @@ public:
 	void writeBrightness(uint8_t brightness);
 
 	/// \brief read last direction before power off from EEProm
-	/// \return direction in degrees
+	/// \return direction in tenths of degrees
 	uint16_t readDirection(void);
 	
 	/// \brief write direction to EEProm
-	/// \param direction in degrees
+	/// \param direction in tenths of degrees
 	void writeDirection(uint16_t direction);
 	
-	/// \brief memory test function
-	/// \todo make function.
-	/// tests memory operation for all stored variables
-	/// \return true=success, false=failed.
-	bool memoryTest(void);
+	/// \brief queue the direction, written by Process() one byte at a time like writeDirection().
+	/// The direction is written before the sequence number that marks the journal as older, a queued
+	/// journal entry is dropped.
+	/// \param direction in tenths of degrees
+	void queueDirection(uint16_t direction);
+	
+	/// \brief queue the TimerCounter calibration value, written by Process() one byte at a time.
+	/// \param counterValue timer calibration value
+	void queueRunTimeCounter(uint16_t counterValue);
+	
+	/// \brief queue an entry of the direction in the journal, while the rotor turns.
+	/// The entry is written by Process(), one byte at each sys tick so the tick is not blocked. 
+	/// readDirection() returns the last complete entry when it is newer than the last writeDirection().
+	/// \param direction in tenths of degrees
+	/// \return false when the previous entry is still being written and direction is not queued.
+	bool writeCheckpoint(uint16_t direction);
+	
+	/// \brief write an entry of the direction in the journal at once.
+	/// Called by the power warning interrupt, takes 5 EEPROM writes of 3.4 mS. A queued entry is replaced.
+	/// \param direction in tenths of degrees
+	void commitCheckpoint(uint16_t direction);
+	
+	/// \brief write the next queued byte, at each sys tick.
+	/// The queued direction and runtime are written before a queued journal entry.
+	/// \return true when a byte was written in this tick.
+	bool Process(void);
+	
+	/// \brief tell if Process() has a byte to write.
+	bool getPending(void){return _SavePending != 0 || _JournalByte < JOURNAL_SLOT_SIZE;}
+	
+	/// \brief start the write test of the self-test.
+	/// The spare cell is written with 0x55 and 0xAA, then each configuration cell is written with
+	/// its complement and its value, one byte per call of ProcessTest(). The value is copied to the
+	/// shadow copy first and the constructor restores it when the power was lost during the test.
+	void startTest(void);
+	
+	/// \brief run the next step of the self-test, in a tick in which nothing else wrote the EEPROM.
+	/// Without a write test, and while other bytes are queued, a journal entry or the configuration
+	/// is read and checked. A scan of all entries takes JOURNAL_SLOTS + 1 calls.
+	/// \param write the EEPROM may be written in this tick.
+	/// \return true when a byte was written in this tick.
+	bool ProcessTest(bool write);
+	
+	/// \brief tell if ProcessTest() has a byte to write.
+	bool getTestWrite(void){return _TestStep != TEST_IDLE && !getPending();}
+	
+	/// \brief tell if the write test started by startTest() is running.
+	bool getTestRunning(void){return _TestStep != TEST_IDLE;}
+	
+	/// \brief get the result of the self-test.
+	/// \return eMemoryHealth bits of the last scan and the last write test, 0 is healthy.
+	uint8_t getHealth(void){return _Health;}
+	
+	/// \brief report the result of the self-test on the serial port.
+	void report(void);
 	
 private:
-
-	uint8_t  _memRunTimeCounter;	///< variable for temporary storage while testing memory functions
-	uint16_t _memDirection;			///< variable for temporary storage while testing memory functions
-	uint8_t	 _memBrightness;		///< variable for temporary storage while testing memory functions
+	/// \brief steps of the write test, in order.
+	enum eTestStep { TEST_IDLE = 0,			///< No write test
+					 TEST_SPARE_55,			///< Write 0x55 in the spare cell
+					 TEST_SPARE_AA,			///< Write 0xAA in the spare cell
+					 TEST_SHADOW_ADDRESS,	///< Copy the address of the cell to the shadow copy
+					 TEST_SHADOW_VALUE,		///< Copy the value of the cell to the shadow copy
+					 TEST_SHADOW_ACTIVE,	///< Mark the shadow copy active
+					 TEST_CELL_PATTERN,		///< Write the complement of the value in the cell
+					 TEST_CELL_RESTORE,		///< Write the value in the cell
+					 TEST_SHADOW_IDLE,		///< Mark the shadow copy idle, next cell
+					 TEST_FINISH };			///< Check the last byte written
+	
+	uint16_t _JournalSequence;		///< Sequence number of the next journal entry.
+	uint8_t  _JournalSlot;			///< Slot of the next journal entry.
+	uint8_t  _JournalByte;			///< Bytes of the queued entry written, JOURNAL_SLOT_SIZE when none is queued.
+	uint8_t  _JournalEntry[JOURNAL_SLOT_SIZE];	///< Queued entry.
+	uint8_t  _Save[SAVE_SIZE];		///< Queued bytes from SAVE_START.
+	uint8_t  _SavePending;			///< Bits of the bytes in _Save that are not written, bit 0 is SAVE_START, and SAVE_CHECK.
+	uint8_t  _TestStep;				///< eTestStep of the write test.
+	uint8_t  _TestCell;				///< Configuration cell under test.
+	uint8_t  _TestValue;			///< Value of the cell under test.
+	uint16_t _VerifyAddress;		///< Address of the last byte written by the write test, 0xFFFF when none.
+	uint8_t  _VerifyValue;			///< Value of the last byte written by the write test.
+	uint8_t  _ScanSlot;				///< Journal entry read at the next scan step, JOURNAL_SLOTS for the configuration.
+	uint8_t  _ScanDamaged;			///< Damaged journal entries found in this scan.
+	uint8_t  _Damaged;				///< Damaged journal entries found in the last complete scan.
+	uint16_t _Scans;				///< Complete scans since power-up.
+	uint8_t  _Health;				///< eMemoryHealth bits.
+	
+	/// \brief find the newest valid journal entry.
+	/// \param[out] sequence of the entry.
+	/// \param[out] direction of the entry in tenths of degrees.
+	/// \return slot of the entry, JOURNAL_SLOTS when the journal is empty.
+	uint8_t findCheckpoint(uint16_t& sequence, uint16_t& direction);
+	
+	/// \brief prepare the next journal entry in _JournalEntry.
+	/// \param direction in tenths of degrees
+	void setCheckpoint(uint16_t direction);
+	
+	/// \brief write the next byte of the queued journal entry.
+	void writeCheckpointByte(void);
+	
+	/// \brief put back the value of the cell under test before a configuration cell is written.
+	/// The write test continues with the cell and its new value.
+	void stopCellTest(void);
+	
+	/// \brief write a byte of the write test, the previous byte is read back first.
+	void writeTestByte(uint16_t address, uint8_t value);
+	
+	/// \brief read and check the next journal entry or the configuration.
+	void scanStep(void);
+	
+	/// \brief get the check byte of the configuration cells, as it is after a running cell test.
+	uint8_t getConfigCheck(void);
+	
+	/// \brief write the check byte of the configuration cells.
+	void writeConfigCheck(void){EEPROM.update(CONFIG_CHECK, getConfigCheck());}
 	
 	
 	/** the current address in the EEPROM (i.e. which byte we're going to write to next) **/
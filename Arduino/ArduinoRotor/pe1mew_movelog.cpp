@@ -0,0 +1,183 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_movelog.cpp
+ /// \brief Move log class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Process() tells if it wrote the EEPROM.
+ /// \version 1.2	The log ends before the check byte of the configuration.
+
+#include "pe1mew_movelog.h"
+
+#include "Arduino.h"
+
+static const uint8_t  LOG_IDLE = LOG_SLOT_SIZE + 1;		///< _RecordByte when no record is queued.
+static const uint16_t TICKS_PER_SECOND = 100;			///< Sys ticks in a second.
+
+static_assert(LOG_START + (uint16_t)LOG_SLOTS * LOG_SLOT_SIZE <= CONFIG_CHECK, "move log overlaps the check byte of the configuration");
+
+PE1MEW_MoveLog::PE1MEW_MoveLog():
+	_Record(),
+	_RecordByte(LOG_IDLE),
+	_Slot(0),
+	_Sequence(0),
+	_Start(0),
+	_Ticks(0),
+	_IdleTicks(0),
+	_Idle(0),
+	_Relays(0),
+	_Cycles(0),
+	_Moving(false),
+	_ExportSlot(0),
+	_ExportCount(0),
+	_ExportByte(0)
+{
+	// The newest record is the one that is not followed by the next sequence number. There are
+	// fewer slots than sequence numbers, so the records can not all follow each other.
+	for (uint8_t slot = 0; slot < LOG_SLOTS; slot++)
+	{
+		uint8_t sequence = readSequence(slot);
+		if (sequence != LOG_EMPTY && readSequence((slot + 1) % LOG_SLOTS) != nextSequence(sequence))
+		{
+			_Slot = (slot + 1) % LOG_SLOTS;
+			_Sequence = nextSequence(sequence);
+			break;
+		}
+	}
+}
+
+void PE1MEW_MoveLog::startMove(uint16_t direction)
+{
+	_Start = direction;
+	_Ticks = 0;
+	_Idle = (_IdleTicks / TICKS_PER_SECOND > 0xFFFF) ? 0xFFFF : (uint16_t)(_IdleTicks / TICKS_PER_SECOND);
+	_Cycles = 0;
+	_Moving = true;
+}
+
+void PE1MEW_MoveLog::endMove(uint16_t target, uint16_t direction)
+{
+	_Moving = false;
+	_IdleTicks = 0;
+	if (_RecordByte < LOG_IDLE)
+	{
+		return;									// The previous record is still written.
+	}
+	
+	_Record[0] = _Sequence;
+	_Record[1] = (uint8_t)(_Start >> 8);
+	_Record[2] = (uint8_t)_Start;
+	_Record[3] = (uint8_t)(target >> 8);
+	_Record[4] = (uint8_t)target;
+	_Record[5] = (uint8_t)(direction >> 8);
+	_Record[6] = (uint8_t)direction;
+	_Record[7] = (uint8_t)(_Ticks >> 8);
+	_Record[8] = (uint8_t)_Ticks;
+	_Record[9] = (uint8_t)(_Idle >> 8);
+	_Record[10] = (uint8_t)_Idle;
+	_Record[11] = ((target > _Start) ? LOG_CW : 0x00) | _Cycles;
+	_RecordByte = 0;
+}
+
+bool PE1MEW_MoveLog::Process(bool relay1, bool relay2, bool write)
+{
+	uint8_t relays = (relay1 ? 0x01 : 0x00) | (relay2 ? 0x02 : 0x00);
+	
+	if (_Moving)
+	{
+		_Ticks = (_Ticks < 0xFFFF) ? _Ticks + 1 : _Ticks;
+		uint8_t closed = relays & ~_Relays;
+		_Cycles += (closed & 0x01) + (closed >> 1);	// Each relay that closed.
+		_Cycles = (_Cycles > LOG_CYCLES_MAX) ? LOG_CYCLES_MAX : _Cycles;
+	}
+	else if (_IdleTicks < 0xFFFFFFFF)
+	{
+		_IdleTicks++;
+	}
+	_Relays = relays;
+	
+	// Record: the sequence number is cleared, the move is written and the sequence number is written last.
+	bool written = write && _RecordByte < LOG_IDLE && _ExportCount == 0;
+	if (written)
+	{
+		uint16_t address = LOG_START + (uint16_t)_Slot * LOG_SLOT_SIZE;
+		if (_RecordByte == 0)
+		{
+			EEPROM.update(address, LOG_EMPTY);
+		}
+		else if (_RecordByte < LOG_SLOT_SIZE)
+		{
+			EEPROM.update(address + _RecordByte, _Record[_RecordByte]);
+		}
+		else
+		{
+			EEPROM.update(address, _Record[0]);
+			_Slot = (_Slot + 1) % LOG_SLOTS;
+			_Sequence = nextSequence(_Sequence);
+		}
+		_RecordByte++;
+	}
+	
+	// Export: send as many bytes as fit in the transmit buffer of the serial port.
+	while (_ExportCount > 0 && Serial.availableForWrite() > 0)
+	{
+		Serial.write(EEPROM.read(LOG_START + (uint16_t)_ExportSlot * LOG_SLOT_SIZE + 1 + _ExportByte));
+		if (++_ExportByte == LOG_RECORD_SIZE)
+		{
+			_ExportByte = 0;
+			_ExportSlot = (_ExportSlot + 1) % LOG_SLOTS;
+			_ExportCount--;
+		}
+	}
+	return written;
+}
+
+void PE1MEW_MoveLog::startExport(void)
+{
+	if (_ExportCount > 0)
+	{
+		return;									// Export is running.
+	}
+	
+	// Count the records that precede each other back from the newest.
+	uint8_t slot = (_Slot + LOG_SLOTS - 1) % LOG_SLOTS;
+	uint8_t sequence = readSequence(slot);
+	uint8_t count = 0;
+	while (count < LOG_SLOTS && sequence != LOG_EMPTY)
+	{
+		count++;
+		slot = (slot + LOG_SLOTS - 1) % LOG_SLOTS;
+		uint8_t previous = readSequence(slot);
+		if (previous == LOG_EMPTY || nextSequence(previous) != sequence)
+		{
+			break;
+		}
+		sequence = previous;
+	}
+	
+	Serial.write('L');
+	Serial.write(LOG_FORMAT);
+	Serial.write(count);
+	_ExportSlot = (_Slot + LOG_SLOTS - count) % LOG_SLOTS;
+	_ExportByte = 0;
+	_ExportCount = count;
+}
+
+uint8_t PE1MEW_MoveLog::readSequence(uint8_t slot)
+{
+	return EEPROM.read(LOG_START + (uint16_t)slot * LOG_SLOT_SIZE);
+}
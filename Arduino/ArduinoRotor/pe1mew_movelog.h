@@ -0,0 +1,116 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_movelog.h
+ /// \brief Move log class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Process() tells if it wrote the EEPROM.
+ /// \version 1.2	Added getPending() for the tick budget.
+ /// \version 1.3	Added getExporting() for the debug logger.
+ /// \version 1.4	36 records, the check byte of the configuration follows the log.
+
+#ifndef PE1MEW_MOVELOG_H
+#define PE1MEW_MOVELOG_H
+
+#include <stdint.h>
+#include "pe1mew_memorycontrol.h"
+
+static const uint16_t LOG_START = JOURNAL_START + (uint16_t)JOURNAL_SLOTS * JOURNAL_SLOT_SIZE;	///< EEPROM address of the move log, after the journal.
+static const uint8_t  LOG_SLOTS = 36;			///< Records in the log, the oldest is overwritten. The log ends before CONFIG_CHECK.
+static const uint8_t  LOG_SLOT_SIZE = 12;		///< Bytes of a record: sequence number and LOG_RECORD_SIZE bytes of the move.
+static const uint8_t  LOG_RECORD_SIZE = 11;		///< Bytes of a move in the record and in the export.
+static const uint8_t  LOG_EMPTY = 0xFF;			///< Sequence number of an erased record or a record being written.
+static const uint8_t  LOG_FORMAT = 0x01;		///< Version of the export format, second byte of the export.
+static const uint8_t  LOG_CW = 0x80;			///< Flag in the last byte of a move: the target is CW of the start.
+static const uint8_t  LOG_CYCLES_MAX = 0x7F;	///< Relay cycles saturate at this count.
+
+/// \class PE1MEW_MoveLog
+/// \brief Logs each completed move in a circular log in EEPROM for analysis of the use of the rotor.
+///
+/// A move is logged in LOG_RECORD_SIZE bytes, MSB first:
+/// - byte 0, 1: direction at the start of the move in tenths of degrees
+/// - byte 2, 3: target at the end of the move in tenths of degrees
+/// - byte 4, 5: direction at the end of the move in tenths of degrees
+/// - byte 6, 7: duration of the move in ticks, 0xFFFF when longer
+/// - byte 8, 9: time between the end of the previous move and the start of this move in seconds,
+///   0xFFFF when longer, counted from power-up for the first move
+/// - byte 10: LOG_CW when the target is CW of the start, bit 6 to 0 the number of times a relay
+///   closed during the move
+///
+/// The record is written one byte at each sys tick in which the journal does not write, so the sys
+/// tick is not delayed. Its sequence number is cleared first and written last, so a record that
+/// was written partly when the power was lost is not used. A record of a move that ends while the
+/// previous record is still written is dropped.
+///
+/// The log is exported with the serial command "L" in binary: 'L', LOG_FORMAT, the number of moves
+/// and the moves from the oldest to the newest. The export is send in parts at each tick and
+/// records are not written while it runs.
+class PE1MEW_MoveLog
+{
+public:
+	/// \brief Default constructor, finds the newest record in EEPROM.
+	PE1MEW_MoveLog();
+	
+	/// \brief start a move, at the first tick the rotor runs.
+	/// \param direction at the start in tenths of degrees.
+	void startMove(uint16_t direction);
+	
+	/// \brief end a move and queue its record, at the first tick the rotor stopped.
+	/// \param target of the move in tenths of degrees.
+	/// \param direction at the end in tenths of degrees.
+	void endMove(uint16_t target, uint16_t direction);
+	
+	/// \brief count the move and the relays, write the next byte of a record and send the next part of an export.
+	/// \param relay1 relay 1 is active.
+	/// \param relay2 relay 2 is active.
+	/// \param write the EEPROM is free in this tick.
+	/// \return true when a byte was written in this tick.
+	bool Process(bool relay1, bool relay2, bool write);
+	
+	/// \brief tell if Process() has a byte to write.
+	bool getPending(void){return _RecordByte <= LOG_SLOT_SIZE && _ExportCount == 0;}
+	
+	/// \brief tell if an export is being sent, no other binary data may be sent in between.
+	bool getExporting(void){return _ExportCount != 0;}
+	
+	/// \brief start to export the log over the serial port.
+	void startExport(void);
+
+private:
+	uint8_t  _Record[LOG_SLOT_SIZE];	///< Record being written, sequence number in byte 0.
+	uint8_t  _RecordByte;				///< Bytes of _Record written, LOG_SLOT_SIZE + 1 when none is queued.
+	uint8_t  _Slot;						///< Slot of the next record.
+	uint8_t  _Sequence;					///< Sequence number of the next record, 0 to LOG_EMPTY - 1.
+	uint16_t _Start;					///< Direction at the start of the move.
+	uint16_t _Ticks;					///< Ticks of the move.
+	uint32_t _IdleTicks;				///< Ticks since the end of the previous move.
+	uint16_t _Idle;						///< Seconds between the previous move and this move.
+	uint8_t  _Relays;					///< Relays in the previous tick.
+	uint8_t  _Cycles;					///< Relay cycles in the move.
+	bool	 _Moving;					///< A move is running.
+	uint8_t  _ExportSlot;				///< Slot of the next exported move.
+	uint8_t  _ExportCount;				///< Moves to export, 0 when no export is running.
+	uint8_t  _ExportByte;				///< Next byte of the exported move.
+	
+	/// \brief get the sequence number of a slot.
+	uint8_t readSequence(uint8_t slot);
+	
+	/// \brief get the sequence number after \p sequence.
+	uint8_t nextSequence(uint8_t sequence){return (sequence + 1) % LOG_EMPTY;}
+};
+
+#endif // PE1MEW_MOVELOG_H
@@ -0,0 +1,192 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software:
+  you can redistribute it and/or modify it under the terms of a Creative
+  Commons Attribution-NonCommercial 4.0 International License
+  (http://creativecommons.org/licenses/by-nc/4.0/) by
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that
+  it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file pe1mew_neopixelspi.h
+/// \brief Neopixel output through the SPI for PE1MEW Arduino Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+
+#ifndef PE1MEW_NEOPIXELSPI_H
+#define PE1MEW_NEOPIXELSPI_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "Arduino.h"
+
+#ifndef __AVR__
+#include <vector>
+#endif
+
+static const uint8_t  NEOPIXEL_SPI_MOSI_PIN = 11;		///< Data line of the Neopixel ring, MOSI.
+static const uint8_t  NEOPIXEL_SPI_SCK_PIN  = 13;		///< SPI clock, not connected.
+static const uint8_t  NEOPIXEL_SPI_SS_PIN   = 10;		///< SS is an output so the SPI stays master, not connected.
+static const uint32_t NEOPIXEL_SPI_CLOCK    = 4000000;	///< SPI clock in Hz, F_CPU / 2 at 8 MHz, 250 nS per SPI bit.
+static const uint8_t  NEOPIXEL_SPI_ZERO     = 0xC0;		///< SPI byte of a 0 bit: 500 nS high, 1500 nS low.
+static const uint8_t  NEOPIXEL_SPI_ONE      = 0xE0;		///< SPI byte of a 1 bit: 750 nS high, 1250 nS low.
+
+/// \class PE1MEW_NeoPixelSpi
+/// \brief Sends a frame to a WS2812 ring through the SPI with interrupts enabled.
+///
+/// Adafruit_NeoPixel::show() generates the WS2812 timing with the CPU and disables interrupts
+/// for the whole frame, 720 uS for 24 leds. Here each WS2812 bit is one SPI byte of
+/// NEOPIXEL_SPI_ZERO or NEOPIXEL_SPI_ONE, the SPI shifts it out while the CPU prepares the next.
+/// Every SPI byte ends low, so a late byte because of an interrupt only makes the low time of
+/// a bit longer; the leds latch the frame after a low time of 50 uS (WS2812B).
+///
+/// The frame is kept in wire order, green, red, blue, per led. Expanding it to SPI bytes takes
+/// 8 bytes per color byte, 576 bytes for 24 leds, so the expansion is done while sending.
+/// Brightness is applied when sending, not to the stored colors as Adafruit_NeoPixel does.
+/// The methods used by PE1MEW_DisplayControl have the same names as in Adafruit_NeoPixel.
+///
+/// On the host the SPI bytes are kept in getStream() so the timing can be tested.
+/// \tparam COUNT number of leds.
+template <uint8_t COUNT>
+class PE1MEW_NeoPixelSpi
+{
+public:
+	/// \brief constructor.
+	/// \param count number of leds, COUNT is used.
+	/// \param pin not used, the data line is always MOSI.
+	/// \param type not used, the leds are always GRB at 800 kHz.
+	PE1MEW_NeoPixelSpi(uint16_t count, uint8_t pin, uint16_t type):
+		_Scale(256)
+	{
+		(void)count;
+		(void)pin;
+		(void)type;
+		clear();
+	}
+	
+	/// \brief configure the SPI as master at F_CPU / 2, mode 0, MSB first.
+	void begin(void)
+	{
+		pinMode(NEOPIXEL_SPI_SS_PIN, OUTPUT);
+		pinMode(NEOPIXEL_SPI_SCK_PIN, OUTPUT);
+		pinMode(NEOPIXEL_SPI_MOSI_PIN, OUTPUT);
+		digitalWrite(NEOPIXEL_SPI_MOSI_PIN, LOW);
+#ifdef __AVR__
+		SPCR = (1 << SPE) | (1 << MSTR);
+		SPSR = (1 << SPI2X);
+#endif
+	}
+	
+	/// \brief switch all leds off, the frame is send by show().
+	void clear(void)
+	{
+		memset(_Frame, 0, sizeof(_Frame));
+	}
+	
+	/// \brief set brightness of the next frames.
+	/// \param brightness 0 (off) to 255 (maximum).
+	void setBrightness(uint8_t brightness)
+	{
+		_Scale = (uint16_t)brightness + 1;
+	}
+	
+	/// \brief set color of one led, the frame is send by show().
+	/// \param led lednumber (0 to COUNT - 1)
+	/// \param color 0x00RRGGBB
+	void setPixelColor(uint16_t led, uint32_t color)
+	{
+		if (led < COUNT)
+		{
+			uint8_t* pixel = &_Frame[led * 3];
+			pixel[0] = (uint8_t)(color >> 8);
+			pixel[1] = (uint8_t)(color >> 16);
+			pixel[2] = (uint8_t)color;
+		}
+	}
+	
+	/// \brief set color of one led, the frame is send by show().
+	/// \param led lednumber (0 to COUNT - 1)
+	void setPixelColor(uint16_t led, uint8_t red, uint8_t green, uint8_t blue)
+	{
+		setPixelColor(led, Color(red, green, blue));
+	}
+	
+	/// \brief pack a color.
+	/// \return 0x00RRGGBB
+	static uint32_t Color(uint8_t red, uint8_t green, uint8_t blue)
+	{
+		return ((uint32_t)red << 16) | ((uint16_t)green << 8) | blue;
+	}
+	
+	/// \brief get a byte as it is send to the leds, with brightness applied.
+	/// \param index byte in wire order, 3 per led (0 to COUNT * 3 - 1)
+	uint8_t getWireByte(uint16_t index) const
+	{
+		return (uint8_t)((_Frame[index] * _Scale) >> 8);
+	}
+	
+	/// \brief get the SPI byte of one bit of a wire byte.
+	/// \param value wire byte from getWireByte()
+	/// \param mask bit of the wire byte, 0x80 is send first.
+	static uint8_t getSpiByte(uint8_t value, uint8_t mask)
+	{
+		return (value & mask) ? NEOPIXEL_SPI_ONE : NEOPIXEL_SPI_ZERO;
+	}
+	
+	/// \brief send the frame.
+	/// A leading 0x00 starts the SPI so each following byte waits for the previous one.
+	/// The wire byte is scaled before the wait, the SPI byte is written as soon as SPIF is set.
+	void show(void)
+	{
+#ifdef __AVR__
+		SPDR = 0x00;
+		for (uint16_t i = 0; i < (uint16_t)COUNT * 3; i++)
+		{
+			uint8_t value = getWireByte(i);
+			for (uint8_t mask = 0x80; mask != 0; mask >>= 1)
+			{
+				uint8_t spiByte = getSpiByte(value, mask);
+				while (!(SPSR & (1 << SPIF)))
+				{
+				}
+				SPDR = spiByte;
+			}
+		}
+		while (!(SPSR & (1 << SPIF)))
+		{
+		}
+#else
+		_Stream.clear();
+		_Stream.push_back(0x00);
+		for (uint16_t i = 0; i < (uint16_t)COUNT * 3; i++)
+		{
+			uint8_t value = getWireByte(i);
+			for (uint8_t mask = 0x80; mask != 0; mask >>= 1)
+			{
+				_Stream.push_back(getSpiByte(value, mask));
+			}
+		}
+#endif
+	}
+
+#ifndef __AVR__
+	/// \brief get the SPI bytes of the last show().
+	const std::vector<uint8_t>& getStream(void) const {return _Stream;}
+#endif
+
+private:
+	uint8_t  _Frame[COUNT * 3];		///< Colors in wire order, green, red, blue per led.
+	uint16_t _Scale;				///< brightness + 1, a wire byte is color * _Scale / 256.
+#ifndef __AVR__
+	std::vector<uint8_t> _Stream;	///< SPI bytes of the last show().
+#endif
+};
+
+#endif // PE1MEW_NEOPIXELSPI_H
@@ -0,0 +1,151 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_positionsensor.cpp
+ /// \brief Position sensor class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Linearisation table, the filter is replaced by the fusion in PE1MEW_RotorControl.
+ /// \version 1.2	Stall detection.
+
+#include "pe1mew_positionsensor.h"
+
+#include "Arduino.h"
+#include "pe1mew_rotorcontrol.h"
+
+#include <avr/pgmspace.h>
+#ifdef __AVR__
+#include <util/atomic.h>
+#endif
+
+const sSensorTable SENSOR_TABLE_LINEAR PROGMEM =
+{
+	{ 0, 512, 1023, 1534, 2046, 2558, 3069, 3580, 4092, 4604, 5115, 5626, 6138, 6650, 7161, 7672, 8184 }
+};
+
+SENSOR_SHARED uint16_t PE1MEW_PositionSensor::_SampleSum = 0;
+SENSOR_SHARED uint8_t  PE1MEW_PositionSensor::_SampleCount = 0;
+
+PE1MEW_PositionSensor::PE1MEW_PositionSensor():
+	_Table(&SENSOR_TABLE_LINEAR),
+	_Value(0),
+	_Variance(SENSOR_VARIANCE),
+	_Valid(false),
+	_StallDirection(0),
+	_StallCounter(0)
+{
+	_SampleSum = 0;
+	_SampleCount = 0;
+}
+
+void PE1MEW_PositionSensor::Initialize(void)
+{
+#ifdef __AVR__
+	ADMUX = (1 << REFS0) | SENSOR_CHANNEL;						// AVcc reference, right adjusted
+	ADCSRB = 0;													// free running
+	DIDR0 |= (1 << SENSOR_CHANNEL);								// no digital input on the channel
+	ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE)
+		   | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);		// ADC clock / 128, start
+#endif
+}
+
+void PE1MEW_PositionSensor::addSample(uint16_t sample)
+{
+	if (_SampleCount < SENSOR_SAMPLE_MAX)	// Process() was delayed: keep the samples summed so far
+	{
+		_SampleSum += sample;
+		_SampleCount++;
+	}
+}
+
+bool PE1MEW_PositionSensor::Process(void)
+{
+	uint16_t sum;
+	uint8_t count;
+	
+#ifdef __AVR__
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+	{
+		sum = _SampleSum;
+		count = _SampleCount;
+		_SampleSum = 0;
+		_SampleCount = 0;
+	}
+	
+	if (count == 0)
+	{
+		return _Valid;
+	}
+	
+	// Decimate: the mean with SENSOR_EXTRA_BITS more bits. The noise of the potentiometer and the ADC
+	// dithers the samples, so the extra bits hold information.
+	_Value = (uint16_t)(((uint32_t)sum << SENSOR_EXTRA_BITS) / count);
+	_Valid = true;
+	return true;
+}
+
+bool PE1MEW_PositionSensor::isStalled(bool running)
+{
+	uint16_t direction = getDirection();
+	
+	if (!running || direction > _StallDirection + SENSOR_STALL_DELTA || direction + SENSOR_STALL_DELTA < _StallDirection)
+	{
+		_StallDirection = direction;
+		_StallCounter = 0;
+		return false;
+	}
+	
+	if (_StallCounter < SENSOR_STALL_TICKS)
+	{
+		_StallCounter++;
+	}
+	return _StallCounter >= SENSOR_STALL_TICKS;
+}
+
+uint16_t PE1MEW_PositionSensor::getDirection(void)
+{
+	int32_t value = _Value;
+	int32_t low = pgm_read_word(&_Table->value[0]);
+	bool reversed = (int32_t)pgm_read_word(&_Table->value[SENSOR_TABLE_SIZE - 1]) < low;
+	
+	// Find the segment of the table that holds the value and interpolate.
+	for (uint8_t i = 1; i < SENSOR_TABLE_SIZE; i++)
+	{
+		int32_t high = pgm_read_word(&_Table->value[i]);
+		
+		if ((reversed ? (value >= high) : (value <= high)) || i == SENSOR_TABLE_SIZE - 1)
+		{
+			int32_t direction = (i - 1) * SENSOR_TABLE_STEP;
+			
+			if (high != low)
+			{
+				direction += (value - low) * SENSOR_TABLE_STEP / (high - low);
+			}
+			if (direction < 0)
+			{
+				return 0;
+			}
+			if (direction > TOTALDEGREES)
+			{
+				return TOTALDEGREES;
+			}
+			return (uint16_t)direction;
+		}
+		low = high;
+	}
+	return 0;
+}
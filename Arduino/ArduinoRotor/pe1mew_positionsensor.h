@@ -0,0 +1,121 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_positionsensor.h
+ /// \brief Position sensor class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Linearisation table, the filter is replaced by the fusion in PE1MEW_RotorControl.
+ /// \version 1.2	Stall detection.
+
+#ifndef PE1MEW_POSITIONSENSOR_H
+#define PE1MEW_POSITIONSENSOR_H
+
+#include <stdint.h>
+
+static const uint8_t  SENSOR_CHANNEL = 0;			///< ADC channel of the feedback potentiometer, A0.
+static const uint8_t  SENSOR_SAMPLE_MAX = 64;		///< Samples summed per tick, 64 * 1023 fits in 16 bits.
+static const uint8_t  SENSOR_EXTRA_BITS = 3;		///< Bits gained by oversampling, 10 bit samples give 13 bit values.
+static const uint16_t SENSOR_FULL_SCALE = 1023 << SENSOR_EXTRA_BITS;	///< Largest value after decimation.
+static const uint8_t  SENSOR_DEADBAND = 15;		///< Deadband of the rotor in tenths of degrees, larger than the coast after the relay is released.
+static const uint16_t SENSOR_VARIANCE = 1 << 8;	///< Default variance of getDirection() in tenths of degrees squared with 8 fractional bits, see PE1MEW_RotorControl::fusePosition().
+static const uint8_t  SENSOR_STALL_DELTA = 5;		///< Tenths of degrees the rotor shall turn in SENSOR_STALL_TICKS while the motor runs.
+static const uint8_t  SENSOR_STALL_TICKS = 20;		///< Ticks in which the rotor shall turn SENSOR_STALL_DELTA, longer than the spin-up of the motor.
+static const uint8_t  SENSOR_TABLE_SIZE = 17;		///< Points of the linearisation table, one every 22.5 degrees.
+static const uint16_t SENSOR_TABLE_STEP = 3600 / (SENSOR_TABLE_SIZE - 1);	///< Tenths of degrees between the points of the linearisation table.
+
+/// \brief linearisation table of a potentiometer, in flash.
+/// The decimated value (0 to SENSOR_FULL_SCALE) at 0, 22.5, 45 ... 360 degrees. The values shall
+/// increase, or decrease when the potentiometer is wired reversed. Between the points the
+/// direction is interpolated linearly.
+struct sSensorTable
+{
+	uint16_t value[SENSOR_TABLE_SIZE];	///< Decimated value at each point.
+};
+
+/// \brief table of a linear potentiometer over the full range of the ADC.
+extern const sSensorTable SENSOR_TABLE_LINEAR;
+
+#ifdef __AVR__
+#define SENSOR_SHARED volatile		///< Written by the ADC interrupt.
+#else
+#define SENSOR_SHARED thread_local	///< The simulator runs a controller per thread.
+#endif
+
+/// \class PE1MEW_PositionSensor
+/// \brief Reads the direction of the rotor from a feedback potentiometer.
+///
+/// The ADC converts the potentiometer continuously in free running mode. At 8 MHz with the
+/// ADC clock divided by 128 a conversion takes 208 uS, so about 48 samples are summed by the ADC
+/// interrupt in a tick of 10 mS. At each tick Process() decimates the sum to a 13 bit value.
+/// The value is converted to tenths of degrees with the linearisation table of the rotor.
+/// On the host the simulator adds the samples of a simulated ADC with addSample().
+class PE1MEW_PositionSensor
+{
+public:
+	/// \brief Default constructor
+	PE1MEW_PositionSensor();
+	
+	/// \brief start the ADC in free running mode with interrupt.
+	void Initialize(void);
+	
+	/// \brief decimate the samples of the last tick, at each sys tick.
+	/// \return true when there were samples and getDirection() is valid.
+	bool Process(void);
+	
+	/// \brief set the linearisation table of the potentiometer.
+	/// \param table table in flash, SENSOR_TABLE_LINEAR at construction.
+	void setTable(const sSensorTable* table){_Table = table;}
+	
+	/// \brief set the variance of the measured direction.
+	/// The noise of a potentiometer of N ADC steps per sample gives a variance of about (N * 3.5 / sqrt(48))^2.
+	/// \param variance in tenths of degrees squared with 8 fractional bits, SENSOR_VARIANCE at construction.
+	void setVariance(uint16_t variance){_Variance = variance;}
+	
+	/// \brief get the variance of the measured direction.
+	/// \return variance in tenths of degrees squared with 8 fractional bits.
+	uint16_t getVariance(void){return _Variance;}
+	
+	/// \brief get the decimated value of the potentiometer.
+	/// \return value from 0 to SENSOR_FULL_SCALE.
+	uint16_t getValue(void){return _Value;}
+	
+	/// \brief get the direction of the rotor.
+	/// \return direction in tenths of degrees (0-3600).
+	uint16_t getDirection(void);
+	
+	/// \brief detect a rotor that does not turn while the motor runs, at an end stop or jammed.
+	/// Called at each sys tick after Process().
+	/// \param running the motor relay is active.
+	/// \return true when the direction changed less than SENSOR_STALL_DELTA in the last SENSOR_STALL_TICKS ticks.
+	bool isStalled(bool running);
+	
+	/// \brief add a sample, called by the ADC interrupt in ArduinoRotor.ino.
+	/// \param sample 10 bit result of the ADC.
+	static void addSample(uint16_t sample);
+
+private:
+	static SENSOR_SHARED uint16_t _SampleSum;	///< Sum of the samples since the last Process().
+	static SENSOR_SHARED uint8_t  _SampleCount;	///< Number of samples in _SampleSum.
+	const sSensorTable* _Table;					///< Linearisation table in flash.
+	uint16_t _Value;							///< Decimated value of the last tick with samples.
+	uint16_t _Variance;							///< Variance of getDirection() in tenths of degrees squared with 8 fractional bits.
+	bool	 _Valid;							///< _Value holds a value.
+	uint16_t _StallDirection;					///< Direction at the start of the stall detection.
+	uint8_t  _StallCounter;						///< Ticks the direction stayed within SENSOR_STALL_DELTA of _StallDirection.
+};
+
+#endif // PE1MEW_POSITIONSENSOR_H
@@ -0,0 +1,103 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_rammonitor.cpp
+ /// \brief RAM monitor class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+
+#include "pe1mew_rammonitor.h"
+
+#ifdef __AVR__
+
+extern uint8_t _end;				///< End of .bss, start of the heap (linker symbol).
+extern uint8_t __stack;				///< Top of the stack, RAMEND (linker symbol).
+extern uint8_t __heap_start;		///< Start of the heap (linker symbol).
+extern void*   __brkval;			///< End of the heap, 0 when malloc() was never used (avr-libc).
+
+/// \brief paint free RAM with STACK_CANARY.
+/// Placed in .init1 so it runs before the stack pointer is used and before the constructors.
+/// Written in assembly because the zero register is not initialized yet in .init1.
+void PaintStack(void) __attribute__ ((naked)) __attribute__ ((used)) __attribute__ ((section (".init1")));
+
+void PaintStack(void)
+{
+	__asm volatile ("    ldi r30,lo8(_end)\n"
+					"    ldi r31,hi8(_end)\n"
+					"    ldi r24,lo8(0xC5)\n"		// STACK_CANARY
+					"    ldi r25,hi8(__stack)\n"
+					"    rjmp .cmp\n"
+					".loop:\n"
+					"    st Z+,r24\n"
+					".cmp:\n"
+					"    cpi r30,lo8(__stack)\n"
+					"    cpc r31,r25\n"
+					"    brlo .loop\n"
+					"    breq .loop" ::);
+}
+
+PE1MEW_RamMonitor::PE1MEW_RamMonitor()
+{
+}
+
+uint16_t PE1MEW_RamMonitor::getFreeRam(void)
+{
+	uint8_t stackTop;
+	uint8_t* heapEnd = (__brkval == 0) ? &__heap_start : (uint8_t*)__brkval;
+	return (uint16_t)(&stackTop - heapEnd);
+}
+
+uint16_t PE1MEW_RamMonitor::getStackUnused(void)
+{
+	const uint8_t* p = (__brkval == 0) ? &_end : (const uint8_t*)__brkval;
+	uint16_t returnValue = 0;
+	
+	while (p <= &__stack && *p == STACK_CANARY)
+	{
+		p++;
+		returnValue++;
+	}
+	return returnValue;
+}
+
+uint16_t PE1MEW_RamMonitor::getStackPeak(void)
+{
+	const uint8_t* p = (__brkval == 0) ? &_end : (const uint8_t*)__brkval;
+	return (uint16_t)(&__stack - p) + 1 - getStackUnused();
+}
+
+#else
+
+PE1MEW_RamMonitor::PE1MEW_RamMonitor()
+{
+}
+
+uint16_t PE1MEW_RamMonitor::getFreeRam(void)
+{
+	return 0;
+}
+
+uint16_t PE1MEW_RamMonitor::getStackUnused(void)
+{
+	return 0;
+}
+
+uint16_t PE1MEW_RamMonitor::getStackPeak(void)
+{
+	return 0;
+}
+
+#endif // __AVR__
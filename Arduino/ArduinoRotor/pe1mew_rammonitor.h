@@ -0,0 +1,57 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_rammonitor.h
+ /// \brief RAM monitor class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+
+#ifndef PE1MEW_RAMMONITOR_H
+#define PE1MEW_RAMMONITOR_H
+
+#include <stdint.h>
+
+static const uint8_t STACK_CANARY = 0xC5;	///< Value written to all free RAM at startup.
+
+/// \class PE1MEW_RamMonitor
+/// \brief Reports free RAM and the stack high-water mark.
+///
+/// At startup, before the constructors run, all RAM between the end of .bss and the top of the
+/// stack is painted with STACK_CANARY (see PaintStack() in pe1mew_rammonitor.cpp). The heap and
+/// the stack overwrite the canary when they grow, so the canary bytes that are left over are the
+/// smallest free RAM since power-up.
+/// On other targets than AVR all functions return 0.
+class PE1MEW_RamMonitor
+{
+public:
+	/// \brief Default constructor
+	PE1MEW_RamMonitor();
+	
+	/// \brief get free RAM between the heap and the stack at this moment.
+	/// \return free RAM in bytes.
+	uint16_t getFreeRam(void);
+	
+	/// \brief get free RAM between the heap and the deepest point the stack reached since power-up.
+	/// The RAM is scanned for canary bytes, this takes about 1 uS per free byte.
+	/// \return never used RAM in bytes.
+	uint16_t getStackUnused(void);
+	
+	/// \brief get the deepest point the stack reached since power-up.
+	/// \return maximum stack size in bytes.
+	uint16_t getStackPeak(void);
+};
+
+#endif // PE1MEW_RAMMONITOR_H
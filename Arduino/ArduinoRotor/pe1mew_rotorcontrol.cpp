@@ -20,6 +20,16 @@
  /// \version 1.0
  /// \version 1.1	Optimized code, removed unnecessary usage of floats, corrected evaluation of current direction in processIDLEState().
  /// \version 1.2	Limited the _RunTimeCounter value to the maximum of 0xFFFF. this equals (65536 * 0,01 sec) / 60 seconds = 10,92 minutes to turn 360 degrees.
+ /// \version 1.3	Directions in tenths of degrees, replaced floats by fixed point with 16 fractional bits.
+ /// \version 1.4	Added deadband in processIDLEState(), stop at the tick closest to the next direction to prevent hunting,
+ ///				relays released in the tick the rotor reaches the next direction.
+ /// \version 1.5	Added fusePosition().
+ /// \version 1.6	Moves into the end stops with an end stop detector.
+ /// \version 1.7	Re-synchronisation at an end stop after accumulated travel.
+ /// \version 1.8	Search of an end stop, jammed rotor and uncertain direction.
+ /// \version 1.9	Commit delay of a moving next direction.
+ /// \version 1.10	The measured direction is taken at the middle of its tenth of a degree.
+ /// \version 1.11	A runtime of 0, from a corrupted EEPROM, no longer divides by zero.
 
  #include "pe1mew_rotorcontrol.h"
 
@@ -29,13 +39,31 @@ PE1MEW_RotorControl::PE1MEW_RotorControl(void)
     :
     _CurrentState(IDLE),
     _NextState(IDLE),
-    _CurrentDirection(0.0),
+    _CurrentDirection(0),
     _NextDirection(0),
     _RotatingState(IDLE),
     _RotatingDirection(IDLE),
 	_RunTime(3600),	// 360 seconds to go 360 degrees in 10 mS steps
 	_RunTimeCounter(0),
-	_CalibratingMode(false)
+	_CalibratingMode(false),
+	_Deadband(0),
+	_Variance(0xFFFF),
+	_CoastCounter(0),
+	_EndStopDetection(false),
+	_FromEndStop(false),
+	_MoveTicks(0),
+	_TravelTicks(0),
+	_ResyncTravel(RESYNC_TRAVEL),
+	_ResyncOverdrive(RESYNC_OVERDRIVE),
+	_OverdriveCounter(0),
+	_Resync(false),
+	_Seek(false),
+	_SeekDirection(CW),
+	_Uncertain(false),
+	_CommitDelay(0),
+	_TargetAge(TARGET_AGE_MAX),
+	_TargetInterval(TARGET_AGE_MAX),
+	_TargetStep(0)
 {
 	Initialize();
 }
@@ -49,34 +77,157 @@ void PE1MEW_RotorControl::Initialize(void)
 	digitalWrite(REL1_PIN, RELAY_REST);
 	digitalWrite(REL2_PIN, RELAY_REST);
 	
-	_degreesPerTick = TOTALDEGREES / static_cast<float>(_RunTime);
+	_degreesPerTick = ((int32_t)TOTALDEGREES << 16) / _RunTime;
 }
 
 void PE1MEW_RotorControl::Initialize(uint16_t angle, uint16_t runtime)
 {
-	_CurrentDirection = static_cast<float>(angle);
+	_CurrentDirection = (int32_t)angle << 16;
 	_NextDirection = angle;
-	_RunTime = runtime;
 	//debugPrint(runtime);
-	_degreesPerTick = TOTALDEGREES / static_cast<float>(_RunTime);
+	setRunTime(runtime);
+	_FromEndStop = false;
+	_TravelTicks = 0;		// synchronised by the synchronize or test and calibration mode
+	_Resync = false;
+	_Seek = false;
+	_Uncertain = false;
+}
+
+void PE1MEW_RotorControl::seekEndStop(eState direction)
+{
+	if (_CurrentState != IDLE)		// the search starts from standstill
+	{
+		setRotorStop();
+		_CurrentState = IDLE;
+		_NextState = IDLE;
+		_Resync = false;
+		_FromEndStop = false;
+	}
+	_Seek = true;
+	_SeekDirection = direction;
+}
+
+bool PE1MEW_RotorControl::setJammed(void)
+{
+	// At the start of a move the rotor may still coast in the other direction, and a rotor leaving
+	// an end stop may not yet be seen to turn by a saturated position sensor.
+	uint16_t leaving = (uint32_t)ENDSTOP_OVERRUN * _RunTime / TOTALDEGREES;
+	
+	if (_MoveTicks < FUSION_COAST_TICKS || (_MoveTicks < leaving &&
+		((_CurrentState == CW && _CurrentDirection <= ((int32_t)ENDSTOP_OVERRUN << 16)) ||
+		 (_CurrentState == CCW && _CurrentDirection >= ((int32_t)(TOTALDEGREES - ENDSTOP_OVERRUN) << 16)))))
+	{
+		return false;
+	}
+	
+	setRotorStop();
+	_CurrentState = IDLE;
+	_NextState = IDLE;
+	_NextDirection = getDirection();
+	_TargetAge = TARGET_AGE_MAX;		// no prediction into the jam
+	_Resync = false;
+	_Seek = false;
+	_FromEndStop = false;
+	_Uncertain = true;
+	return true;
+}
+
+uint16_t PE1MEW_RotorControl::getTravel(void)
+{
+	uint32_t travel = _TravelTicks * (TOTALDEGREES / 10) / _RunTime;
+	return (travel > 0xFFFF) ? 0xFFFF : (uint16_t)travel;
+}
+
+void PE1MEW_RotorControl::setRunTime(uint16_t runtime)
+{
+	_RunTime = (runtime == 0) ? RUNTIME_DEFAULT : runtime;
+	_degreesPerTick = ((int32_t)TOTALDEGREES << 16) / _RunTime;
+}
+
+uint16_t PE1MEW_RotorControl::setEndStopReached(void)
+{
+	uint16_t returnValue = 0;
+	uint16_t end = _Resync ? ((_CurrentState == CW) ? TOTALDEGREES : 0) : _NextDirection;
+	
+	// Only a stall in the last ENDSTOP_OVERRUN of a move to an end is the end stop, 
+	// searching an end stop any stall is.
+	if ((_Seek && _CurrentState != IDLE) ||
+		(_CurrentState == CW && end == TOTALDEGREES && _CurrentDirection >= ((int32_t)(TOTALDEGREES - ENDSTOP_OVERRUN) << 16)) ||
+		(_CurrentState == CCW && end == 0 && _CurrentDirection <= ((int32_t)ENDSTOP_OVERRUN << 16)))
+	{
+		setRotorStop();
+		_CurrentState = IDLE;
+		_NextState = IDLE;
+		_CurrentDirection = (int32_t)end << 16;
+		_TravelTicks = 0;
+		_Resync = false;
+		_Seek = false;
+		_Uncertain = false;
+		
+		if (_FromEndStop)				// From end stop to end stop: the runtime as measured by TCS6
+		{
+			returnValue = _MoveTicks;
+		}
+		_FromEndStop = true;
+	}
+	return returnValue;
 }
 
 	
 uint16_t PE1MEW_RotorControl::setDirection(uint16_t direction)
 {
-    if ((float)direction > TOTALDEGREES)
-    {
-        _NextDirection = TOTALDEGREES;
-    }
-    else
+    if (direction > TOTALDEGREES)
     {
-        _NextDirection = direction;
+        direction = TOTALDEGREES;
     }
+	if (direction != _NextDirection)
+	{
+		_TargetStep = (int16_t)direction - (int16_t)_NextDirection;
+		_TargetInterval = _TargetAge;
+		_TargetAge = 0;
+	}
+    _NextDirection = direction;
     return _NextDirection;
 }
 
+int32_t PE1MEW_RotorControl::getTarget(void)
+{
+	int32_t target = (int32_t)_NextDirection << 16;
+	
+	// A next direction that moved in steps within the commit delay is expected to move on at the 
+	// same rate, the rotor turns on to where it will be after the commit delay. The rotor is started
+	// again when the next direction itself passed it, see processIDLEState(): it then runs for about
+	// the commit delay instead of stopping at every step.
+	if (_TargetAge < _CommitDelay && _TargetInterval < _CommitDelay)
+	{
+		int32_t rate = ((int32_t)_TargetStep << 16) / (_TargetInterval + 1);
+		rate = (rate > _degreesPerTick) ? _degreesPerTick : ((rate < -_degreesPerTick) ? -_degreesPerTick : rate);
+		target += rate * _CommitDelay;
+		target = (target < 0) ? 0 : ((target > ((int32_t)TOTALDEGREES << 16)) ? ((int32_t)TOTALDEGREES << 16) : target);
+	}
+	return target;
+}
+
+uint16_t PE1MEW_RotorControl::getDirection(void)
+{
+	if (_CurrentDirection < 0)							// Overshoot below 0 at the last tick
+	{
+		return 0;
+	}
+	if (_CurrentDirection > ((int32_t)TOTALDEGREES << 16))	// Overshoot above 3600 at the last tick
+	{
+		return TOTALDEGREES;
+	}
+	return (uint16_t)(_CurrentDirection >> 16);
+}
+
 void PE1MEW_RotorControl::Process(void)
 {
+	if (_TargetAge < TARGET_AGE_MAX)
+	{
+		_TargetAge++;
+	}
+	
     switch(_CurrentState)
     {
     case IDLE:
@@ -99,6 +250,39 @@ void PE1MEW_RotorControl::Process(void)
     _CurrentState = _NextState;
 }
 
+void PE1MEW_RotorControl::fusePosition(uint16_t direction, uint16_t variance)
+{
+	// A Kalman filter with one state. Process() predicts the direction from the runtime, the 
+	// variance of this prediction grows fast while the motor runs or coasts (spin-up, wind) and 
+	// slowly while the rotor stands still. The measurement corrects the prediction with gain
+	// variance / (variance + measurement variance): while running the measurement is followed 
+	// without lag, standing still the noise of the measurement is averaged out.
+	if (_RotatingState)
+	{
+		_CoastCounter = FUSION_COAST_TICKS;
+	}
+	else if (_CoastCounter > 0)
+	{
+		_CoastCounter--;
+	}
+	
+	// The measured direction is truncated to a tenth of a degree and getDirection() truncates again:
+	// take the measurement at the middle of its tenth, or the fused direction lags by half a tenth.
+	int32_t innovation = ((int32_t)direction << 16) + 0x8000 - _CurrentDirection;
+	uint32_t predicted = (uint32_t)_Variance + ((_CoastCounter > 0) ? FUSION_NOISE_RUNNING : FUSION_NOISE_IDLE);
+	
+	// At power-up or after the modes turned the rotor by time, the counted direction is lost.
+	if (predicted > 0xFFFF || innovation > ((int32_t)FUSION_RESET << 16) || innovation < -((int32_t)FUSION_RESET << 16))
+	{
+		predicted = 0xFFFF;
+	}
+	
+	uint16_t gain = (uint16_t)((predicted << 8) / (predicted + variance));		// 8 fractional bits
+	
+	_CurrentDirection += (innovation >> 8) * gain;
+	_Variance = (uint16_t)((predicted * (256 - gain)) >> 8);
+}
+
 void PE1MEW_RotorControl::processIDLEState(void)
 {
     if(_RotatingState == true)
@@ -106,13 +290,38 @@ void PE1MEW_RotorControl::processIDLEState(void)
 	    setRotorStop();
     }
 	
-	if (_NextDirection > ceil(_CurrentDirection))			/// Round to first int lower than current value of float
+	// The rotor stops within half a tick from the next direction, see processCWState().
+	// It is started again only when the next direction is further away than half a tick, 
+	// or half a tenth of a degree when a tick is smaller, plus the deadband.
+	int32_t error = ((int32_t)_NextDirection << 16) - _CurrentDirection;
+	int32_t band = ((int32_t)_Deadband << 16) + ((_degreesPerTick > 0x10000) ? (_degreesPerTick >> 1) : 0x8000);
+	
+	// After a long travel a next direction close to an end starts with a re-synchronisation at that end,
+	// with an uncertain direction any next direction does.
+	if (_Seek)
+	{
+		_NextState = _SeekDirection;
+		_Resync = true;
+		_OverdriveCounter = 0;
+		_MoveTicks = 0;
+	}
+	else if ((error > band || error < -band) && _ResyncTravel != 0 && (_Uncertain || (getTravel() >= _ResyncTravel &&
+		(_NextDirection <= RESYNC_WINDOW || _NextDirection >= TOTALDEGREES - RESYNC_WINDOW))))
+	{
+		_NextState = (_NextDirection < TOTALDEGREES / 2) ? CCW : CW;
+		_Resync = true;
+		_OverdriveCounter = 0;
+		_MoveTicks = 0;
+	}
+	else if (error > band)
     {
         _NextState = CW;
+		_MoveTicks = 0;
     }
-    else if (_NextDirection < floor(_CurrentDirection))		/// Round to first int higher than current value of float
+    else if (error < -band)
     {
         _NextState = CCW;
+		_MoveTicks = 0;
     }
     else
     {
@@ -127,9 +336,21 @@ void PE1MEW_RotorControl::processCWState(void)
         setRotorTurn(CW);
     }
 	
-	if (_CurrentDirection > _NextDirection)
+	countTravel();
+	if (_Resync)
+	{
+		processResync(CW);
+		return;
+	}
+	
+	// A move to 360 degrees with an end stop detector continues until the end stop is detected.
+	int32_t stop = (_EndStopDetection && _NextDirection == TOTALDEGREES) ? (int32_t)(TOTALDEGREES + ENDSTOP_OVERRUN) << 16 : getTarget();
+	
+	if (_CurrentDirection + (_degreesPerTick >> 1) >= stop)	// next tick would be further away
     {
+        setRotorStop();		// relays released now: the rotor ran one tick per increment
         _NextState = IDLE;
+		_FromEndStop = false;
     }
 	else
 	{
@@ -144,9 +365,20 @@ void PE1MEW_RotorControl::processCCWState(void)
         setRotorTurn(CCW);
     }
 
-	if (_CurrentDirection < _NextDirection)
+	countTravel();
+	if (_Resync)
+	{
+		processResync(CCW);
+		return;
+	}
+	
+	int32_t stop = (_EndStopDetection && _NextDirection == 0) ? -((int32_t)ENDSTOP_OVERRUN << 16) : getTarget();
+	
+	if (_CurrentDirection - (_degreesPerTick >> 1) <= stop)	// next tick would be further away
     {
+        setRotorStop();		// relays released now: the rotor ran one tick per increment
         _NextState = IDLE;
+		_FromEndStop = false;
     }
 	else
 	{
@@ -154,6 +386,60 @@ void PE1MEW_RotorControl::processCCWState(void)
 	}
 }
 
+void PE1MEW_RotorControl::countTravel(void)
+{
+	if (_MoveTicks < 0xFFFF)
+	{
+		_MoveTicks++;
+	}
+	if (_TravelTicks < 0x7FFFFF)		// getTravel() multiplies by 360
+	{
+		_TravelTicks++;
+	}
+}
+
+void PE1MEW_RotorControl::processResync(eState direction)
+{
+	int32_t end = (direction == CW) ? ((int32_t)TOTALDEGREES << 16) : 0;
+	
+	if (_Seek)
+	{
+		// Searching, only the end stop detector ends the move.
+		if (_MoveTicks < _RunTime + (_RunTime >> SEEK_TIMEOUT_SHIFT))
+		{
+			_CurrentDirection += (direction == CW) ? _degreesPerTick : -_degreesPerTick;
+		}
+		else
+		{
+			setRotorStop();
+			_NextState = IDLE;
+			_NextDirection = getDirection();
+			_TargetAge = TARGET_AGE_MAX;
+			_Resync = false;
+			_Seek = false;
+			_Uncertain = true;
+		}
+	}
+	else if ((direction == CW) ? (_CurrentDirection + (_degreesPerTick >> 1) < end) : (_CurrentDirection - (_degreesPerTick >> 1) > end))
+	{
+		_CurrentDirection += (direction == CW) ? _degreesPerTick : -_degreesPerTick;
+	}
+	else if (_OverdriveCounter < _ResyncOverdrive)
+	{
+		_OverdriveCounter++;			// counted at the end, the rotor is driven into the end stop
+	}
+	else
+	{
+		setRotorStop();
+		_NextState = IDLE;				// the next direction is taken from here
+		_CurrentDirection = end;
+		_TravelTicks = 0;
+		_Resync = false;
+		_FromEndStop = false;
+		_Uncertain = false;
+	}
+}
+
 void PE1MEW_RotorControl::setRotorTurn(eState direction)
 {
     setRotateDirection(direction);
@@ -18,6 +18,15 @@
  /// \date 20-7-2016
  /// \author Remko Welling (PE1MEW)
  /// \version 1.0
+ /// \version 1.1	Directions in tenths of degrees, position kept in fixed point.
+ /// \version 1.2	Added deadband around the current direction.
+ /// \version 1.3	Added setPosition() for a position sensor.
+ /// \version 1.4	setPosition() replaced by fusePosition(), fusion of the counted and the measured direction.
+ /// \version 1.5	Moves into the end stops with an end stop detector, runtime of full range moves.
+ /// \version 1.6	Re-synchronisation at an end stop after accumulated travel.
+ /// \version 1.7	Search of an end stop, jammed rotor and uncertain direction.
+ /// \version 1.8	Commit delay of a moving next direction.
+ /// \version 1.9	A runtime of 0 is replaced by RUNTIME_DEFAULT.
 
 #ifndef PE1MEW_ROTORCONTROLCHANNELMASTER_H
 #define PE1MEW_ROTORCONTROLCHANNELMASTER_H
@@ -26,15 +35,27 @@
 
 #include "pe1mew_rotorcontrol.h"
 
-static uint8_t RELAY_REST   = 0x01;	///< set bit
-static uint8_t RELAY_ACTIVE = 0x00;	///< reset bit
+static const uint8_t RELAY_REST   = 0x01;	///< set bit
+static const uint8_t RELAY_ACTIVE = 0x00;	///< reset bit
 
-static uint8_t REL1_PIN	= 4;		///< Pin to which the relay 1 is connected.
-static uint8_t REL2_PIN	= 5;		///< Pin to which the relay 2 is connected.
+static const uint8_t REL1_PIN	= 4;		///< Pin to which the relay 1 is connected.
+static const uint8_t REL2_PIN	= 5;		///< Pin to which the relay 2 is connected.
 
-#define TOTALDEGREES	360.0		///< Total number of degrees in on a compass card.
+#define TOTALDEGREES	3600		///< Total number of tenths of degrees in on a compass card.
 // \todo move define to static within scope of class?
 
+static const uint16_t RUNTIME_DEFAULT = 36000;			///< Runtime in ticks of a new EEPROM, used instead of a runtime of 0.
+static const uint16_t FUSION_NOISE_RUNNING = 16;	///< Growth of the variance of the counted direction per tick while the motor runs or coasts, tenths of degrees squared with 8 fractional bits.
+static const uint16_t FUSION_NOISE_IDLE = 1;			///< Growth of the variance per tick while the rotor stands still.
+static const uint8_t  FUSION_COAST_TICKS = 50;			///< Ticks the rotor may coast after the relay is released.
+static const uint8_t  FUSION_RESET = 50;				///< Difference in tenths of degrees at which the counted direction is replaced by the measured direction.
+static const uint16_t ENDSTOP_OVERRUN = 200;			///< Tenths of degrees the rotor is turned past 0 or 360 degrees to reach the end stop.
+static const uint16_t RESYNC_TRAVEL = 3600;				///< Default degrees travelled after which the rotor is re-synchronised at an end stop.
+static const uint16_t RESYNC_OVERDRIVE = 200;			///< Default ticks the rotor is driven into the end stop when re-synchronised.
+static const uint16_t RESYNC_WINDOW = 100;				///< Tenths of degrees from 0 or 360 degrees in which a next direction starts a re-synchronisation.
+static const uint8_t  SEEK_TIMEOUT_SHIFT = 1;			///< The search of an end stop fails after the runtime plus 1/2.
+static const uint8_t  TARGET_AGE_MAX = 0xFF;			///< Ticks since the next direction changed, saturated.
+
 /// \brief status of rotor control
 enum eState { IDLE = 0, 	///< motor is not running, current Direction == next Direction
 			  CW, 			///< motor is running clock wise (west-bound)
@@ -57,14 +78,86 @@ public:
 	/// - During calibration process
 	/// \todo verify usage
 	/// \todo reconsider naming of function.
-	/// \param direction in the degrees (0-360)
+	/// \param direction in tenths of degrees (0-3600)
 	/// \return direction set
 	uint16_t setDirection(uint16_t direction);
 	
 	/// \brief get current (actual) direction of the rotor.
-	/// \return current direction registered by rotor control
-    uint16_t getDirection(void){return (uint16_t)_CurrentDirection;}
+	/// \return current direction registered by rotor control in tenths of degrees (0-3600)
+    uint16_t getDirection(void);
 	
+	/// \brief combine the counted direction with a direction measured by a position sensor.
+	/// Called at each sys tick before Process(). See the function implementation for a description.
+	/// \param direction measured direction in tenths of degrees (0-3600)
+	/// \param variance variance of the measurement in tenths of degrees squared with 8 fractional bits.
+	void fusePosition(uint16_t direction, uint16_t variance);
+
+	/// \brief enable moves into the end stops.
+	/// With an end stop detector a move to 0 or 360 degrees is not stopped at the counted direction
+	/// but continues up to ENDSTOP_OVERRUN further, until the detector calls setEndStopReached().
+	/// \param detection true when an end stop detector is connected, false at construction.
+	void setEndStopDetection(bool detection){_EndStopDetection = detection;}
+
+	/// \brief the end stop detector found the rotor stalled.
+	/// In a move to 0 or 360 degrees within ENDSTOP_OVERRUN of the end the rotor is stopped and 
+	/// the direction is set to the end stop.
+	/// \return ticks of the move when it started at the other end stop, the runtime of the full range, else 0.
+	uint16_t setEndStopReached(void);
+
+	/// \brief configure the re-synchronisation at the end stops.
+	/// When the rotor travelled more than travel degrees since the last synchronisation and the 
+	/// next direction is within RESYNC_WINDOW of 0 or 360 degrees, the rotor is first turned to 
+	/// that end and overdrive ticks further into the end stop. The direction is then set to the
+	/// end and the rotor turns to the next direction. The rotor shall stop at the end stops.
+	/// \param travel degrees, RESYNC_TRAVEL at construction, 0 disables the re-synchronisation.
+	/// \param overdrive ticks, RESYNC_OVERDRIVE at construction.
+	void setResync(uint16_t travel, uint16_t overdrive){_ResyncTravel = travel; _ResyncOverdrive = overdrive;}
+
+	/// \brief turn the rotor into an end stop, whatever the counted direction.
+	/// The rotor turns until the end stop detector calls setEndStopReached(), the direction is then 
+	/// set to the end stop. Without a detection within the runtime plus 1/2 the rotor is stopped and 
+	/// the direction is uncertain. Requires setEndStopDetection(true).
+	/// \param direction CW to search the end stop at 360 degrees, CCW at 0 degrees.
+	void seekEndStop(eState direction);
+
+	/// \brief get the state of the search of an end stop.
+	/// \return true while the rotor searches an end stop.
+	bool getSeeking(void){return _Seek;}
+
+	/// \brief the end stop detector found the rotor stalled, but not in a move to an end stop.
+	/// The rotor is stopped, the next direction is set to the counted direction and the direction
+	/// is uncertain. A stall in the first FUSION_COAST_TICKS of a move, or in the first ENDSTOP_OVERRUN
+	/// of a move away from an end stop, is ignored.
+	/// \return true when the rotor is stopped as jammed.
+	bool setJammed(void);
+
+	/// \brief get the certainty of the direction.
+	/// An uncertain direction is synchronised at an end stop at the next move, see setResync().
+	/// \return true after a jam or a failed search of an end stop, until the next synchronisation.
+	bool getUncertain(void){return _Uncertain;}
+
+	/// \brief get the travel since the last synchronisation.
+	/// \return degrees.
+	uint16_t getTravel(void);
+
+	/// \brief set the runtime without changing the direction.
+	/// \param runtime The time it takes to turn the antenna 360 degrees in ticks, RUNTIME_DEFAULT when 0.
+	void setRunTime(uint16_t runtime);
+
+	/// \brief set the deadband of the rotor.
+	/// The rotor is not started when the next direction is within the deadband around the current direction.
+	/// \param deadband in tenths of degrees, 0 at construction.
+	void setDeadband(uint8_t deadband){_Deadband = deadband;}
+
+	/// \brief set the commit delay of a next direction that moves in steps, as while a button is held.
+	/// While the next direction changed within the commit delay the rotor turns to where it is predicted
+	/// to be after the commit delay, from the last step and the ticks between the last two steps. The rotor
+	/// is started as soon as the next direction passed it and then runs about the commit delay ahead, instead of
+	/// stopping at every step. The stop is decided on the next direction itself when it did not change for the
+	/// commit delay.
+	/// \param ticks commit delay, 0 at construction switches the prediction off.
+	void setCommitDelay(uint8_t ticks){_CommitDelay = ticks;}
+
 	/// \brief  get state of rotor
 	/// \return true = running, false = stop.
     bool getIsRotorRunning(void){return _RotatingState;}
@@ -73,8 +166,8 @@ public:
 	/// Overloaded function form the private function Initialize()
 	/// This function is used to initialize the rotor control with settings from memory
 	/// Also this function is used to configure the class with new runtime settings.
-	/// \param[in] angle direction of the antenna. This can be the last known direction stored in memory.
-	/// \param[in] runtime The time it takes to turn the antenna 360 degrees.
+	/// \param[in] angle direction of the antenna in tenths of degrees. This can be the last known direction stored in memory.
+	/// \param[in] runtime The time it takes to turn the antenna 360 degrees, RUNTIME_DEFAULT when 0.
 	void Initialize(uint16_t angle, uint16_t runtime);
 
 	/// \brief function to start a timer to measure the time it takes to turn the antenna 360 degrees
@@ -99,14 +192,32 @@ public:
 private:
     uint8_t  _CurrentState;			///< Current state of the state machine that keeps track of the rotor
     uint8_t  _NextState;			///< Next state the state machine will have
-    float	 _CurrentDirection;		///< Current or actual direction of rotor
-    uint16_t _NextDirection;        ///< Value with direction where rotor shall rotate to
+    int32_t	 _CurrentDirection;		///< Current or actual direction of rotor in tenths of degrees with 16 fractional bits
+    uint16_t _NextDirection;        ///< Value with direction in tenths of degrees where rotor shall rotate to
 	uint16_t _RunTime;				///< Value to store time required to rotate from 0 to 360 degrees.
 	uint16_t _RunTimeCounter;		///< Value for counting time while calibrating
 	bool	 _CalibratingMode;		///< Value to indicate calibration process is running
-	float    _degreesPerTick;		///< Degrees that the antenna is turned during the time between two sys ticks.
+	uint8_t  _Deadband;				///< Deadband around the current direction in tenths of degrees
+	int32_t  _degreesPerTick;		///< Tenths of degrees with 16 fractional bits that the antenna is turned during the time between two sys ticks.
     bool     _RotatingState;		///< Indicator to tell if the rotor is running (true) or not (false)
     eState   _RotatingDirection;	///< Status of the state machine of the rotor to keep track of the direction see eState enum
+	uint16_t _Variance;				///< Variance of _CurrentDirection in tenths of degrees squared with 8 fractional bits, see fusePosition().
+	uint8_t  _CoastCounter;			///< Ticks since the relay was released, up to FUSION_COAST_TICKS.
+	bool	 _EndStopDetection;		///< Moves to 0 and 360 degrees continue into the end stop.
+	bool	 _FromEndStop;			///< The move started at an end stop found by the end stop detector.
+	uint16_t _MoveTicks;			///< Ticks since the start of the move.
+	uint32_t _TravelTicks;			///< Ticks the motor ran since the last synchronisation.
+	uint16_t _ResyncTravel;			///< Degrees of travel after which the rotor is re-synchronised.
+	uint16_t _ResyncOverdrive;		///< Ticks the rotor is driven into the end stop when re-synchronised.
+	uint16_t _OverdriveCounter;		///< Ticks the rotor was driven into the end stop.
+	bool	 _Resync;				///< The rotor is turned to an end stop to re-synchronise.
+	bool	 _Seek;					///< The rotor searches an end stop, see seekEndStop().
+	eState	 _SeekDirection;		///< Direction of the end stop searched.
+	bool	 _Uncertain;			///< The direction is uncertain, see getUncertain().
+	uint8_t  _CommitDelay;			///< Ticks a next direction shall be stable before the rotor stops at it, see setCommitDelay().
+	uint8_t  _TargetAge;			///< Ticks since the next direction changed.
+	uint8_t  _TargetInterval;		///< Ticks between the last two changes of the next direction.
+	int16_t  _TargetStep;			///< Last change of the next direction in tenths of degrees.
 
 	/// \brief helper function to initialize variables en calculate values for these variables in the constructor of the classes.
 	/// Functions are called that cannot be handled by the C++ default initializers
@@ -124,6 +235,17 @@ private:
 	/// See the function implementation for a description
     void processCCWState(void);
 
+	/// \brief function executed in CW or CCW state while the rotor is re-synchronised.
+	/// \param direction CW to re-synchronise at 360 degrees, CCW at 0 degrees.
+	void processResync(eState direction);
+
+	/// \brief get the direction the rotor turns to.
+	/// \return next direction, or the predicted next direction while it moves, in tenths of degrees with 16 fractional bits.
+	int32_t getTarget(void);
+
+	/// \brief count the ticks of the move and the travel, in CW or CCW state.
+	void countTravel(void);
+
 	/// \brief function to be executed in CW or CCW state when calibrating ie executed 
 	/// when _CalibratingMode = true the timer counter is incremented.
 	void ProcessCalibration(void);
@@ -19,24 +19,224 @@
  /// \author Remko Welling (PE1MEW)
  /// \version 1.0
  /// \version 1.1	Modified turn direction in initialization phase of calibration process
+ /// \version 1.2	Directions in tenths of degrees, next direction can be set by serial command.
+ /// \version 1.3	Replaced the switch statements of the modes by a transition table in flash.
+ /// \version 1.4	Added serial command to report RAM usage.
+ /// \version 1.5	Added input recorder and serial command to export the recording.
+ /// \version 1.6	Direction measured by the position sensor when POSITIONSENSOR is defined.
+ /// \version 1.7	Measured direction fused with the counted direction.
+ /// \version 1.8	Runtime adapted from moves between the end stops, found by the stall detection of the position sensor.
+ /// \version 1.9	Stall detection by the motor current, jammed rotor and automatic calibration.
+ /// \version 1.10	Journal of the direction while the rotor turns, power warning.
+ /// \version 1.11	Move log and serial command to export it.
+ /// \version 1.12	Relay cycle counters and motor hour meter.
+ /// \version 1.13	Watchdog reset from a healthy tick.
+ /// \version 1.14	Tick budget for the frame, the EEPROM bytes and the serial reports.
+ /// \version 1.15	EEPROM self-test in the ticks without other EEPROM writes.
+ /// \version 1.16	Messages of the debug logger sent at the end of the tick.
+ /// \version 1.17	Reports that wait for the tick budget do not block the other commands.
+ /// \version 1.18	Jam and calibration notices sent as reports, not during a binary export.
+ /// \version 1.19	A runtime of 0 in EEPROM or from the calibration is not used.
+ /// \version 1.20	Margin of the motor time in getHealthy() documented.
+ /// \version 1.21	Commit delay of the next direction set in Initialize().
+ /// \version 1.22	Display layers and preset directions, display benchmark in the memory report.
+ /// \version 1.23	Reports and log messages wait for the export of the input recording too.
+ /// \version 1.24	The tick measured once by the watchdog, the tick budget reads it.
+ /// \version 1.25	First row of each mode state found at compile time, rainbow test shown with showLed().
 
  #include "pe1mew_rotorcontroller.h"
 
+#include <avr/pgmspace.h>
+#if defined(POWERWARNING) && defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+/// \brief transition table of set brightness, synchronize and test and calibration mode.
+/// Rows of a state are grouped and EVENT_TICK rows are placed before the button rows.
+/// The first row of each state is found at compile time for modeFirstRow.
+static constexpr sModeTransition modeTable[] PROGMEM = {
+//	  state			event			guard			action					memory			pattern					next
+	// Set brightness
+	{ SBINIT,		EVENT_TICK,		GUARD_ALWAYS,	ACTION_BRIGHTNESS_START,MEMORY_KEEP,	PATTERN_SB_START,		SB },			//  0
+	{ SB,			EVENT_TICK,		GUARD_ALWAYS,	ACTION_SHOW_BRIGHTNESS,	MEMORY_KEEP,	PATTERN_ROW,			MODE_SAME },	//  1
+	{ SB,			BUTTON_1,		GUARD_ALWAYS,	ACTION_BRIGHTNESS_STEP,	MEMORY_SET,		PATTERN_ROW,			MODE_SAME },
+	{ SB,			BUTTON_2,		GUARD_MEMORY,	ACTION_NONE,			MEMORY_KEEP,	PATTERN_ROW,			SBFINISH },
+	{ SBFINISH,		EVENT_TICK,		GUARD_ALWAYS,	ACTION_BRIGHTNESS_SAVE,	MEMORY_KEEP,	PATTERN_ROW,			MODE_EXIT },	//  4
+	// Synchronize
+	{ SYNCINIT,		EVENT_TICK,		GUARD_ALWAYS,	ACTION_NONE,			MEMORY_KEEP,	PATTERN_ROW,			SYNC1 },		//  5
+	{ SYNC1,		EVENT_TICK,		GUARD_MEMORY,	ACTION_ROTATE,			MEMORY_KEEP,	PATTERN_ROW,			MODE_SAME },	//  6
+	{ SYNC1,		BUTTON_NONE,	GUARD_ALWAYS,	ACTION_SYNC_CCW,		MEMORY_SET,		PATTERN_ROW,			MODE_SAME },
+	{ SYNC1,		BUTTON_BOTH,	GUARD_ALWAYS,	ACTION_NONE,			MEMORY_CLEAR,	PATTERN_ROW,			SYNCFINISH },
+	{ SYNC1,		BUTTON_1,		GUARD_STOPPED,	ACTION_SHOW_BRIGHTNESS,	MEMORY_CLEAR,	PATTERN_SYNC_START,		SYNC2 },
+	{ SYNC1,		BUTTON_2,		GUARD_STOPPED,	ACTION_SHOW_BRIGHTNESS,	MEMORY_CLEAR,	PATTERN_SYNC_START,		SYNC2 },
+	{ SYNC1,		BUTTON_1,		GUARD_NOMEMORY,	ACTION_SHOW_BRIGHTNESS,	MEMORY_KEEP,	PATTERN_SYNC_START,		MODE_SAME },
+	{ SYNC1,		BUTTON_2,		GUARD_NOMEMORY,	ACTION_SHOW_BRIGHTNESS,	MEMORY_KEEP,	PATTERN_SYNC_START,		MODE_SAME },
+	{ SYNC2,		EVENT_TICK,		GUARD_MEMORY,	ACTION_ROTATE,			MEMORY_KEEP,	PATTERN_ROW,			MODE_SAME },	// 13
+	{ SYNC2,		BUTTON_NONE,	GUARD_ALWAYS,	ACTION_SYNC_CW,			MEMORY_SET,		PATTERN_ROW,			MODE_SAME },
+	{ SYNC2,		BUTTON_BOTH,	GUARD_ALWAYS,	ACTION_NONE,			MEMORY_CLEAR,	PATTERN_ROW,			SYNCFINISH },
+	{ SYNC2,		BUTTON_1,		GUARD_STOPPED,	ACTION_NONE,			MEMORY_CLEAR,	PATTERN_ROW,			SYNCFINISH },
+	{ SYNC2,		BUTTON_2,		GUARD_STOPPED,	ACTION_NONE,			MEMORY_CLEAR,	PATTERN_ROW,			SYNCFINISH },
+	{ SYNCFINISH,	EVENT_TICK,		GUARD_ALWAYS,	ACTION_SYNC_FINISH,		MEMORY_KEEP,	PATTERN_ROW,			MODE_EXIT },	// 18
+	// Test and calibration
+	{ TCSINIT,		EVENT_TICK,		GUARD_ALWAYS,	ACTION_SHOW_BRIGHTNESS,	MEMORY_KEEP,	PATTERN_TCS1_START,		TCS1 },			// 19
+	{ TCS1,			EVENT_TICK,		GUARD_MEMORY,	ACTION_RAINBOW,			MEMORY_KEEP,	PATTERN_ROW,			MODE_SAME },	// 20
+	{ TCS1,			BUTTON_1,		GUARD_ALWAYS,	ACTION_NONE,			MEMORY_SET,		PATTERN_ROW,			MODE_SAME },
+	{ TCS1,			BUTTON_BOTH,	GUARD_MEMORY,	ACTION_NONE,			MEMORY_CLEAR,	PATTERN_TCS2_START,		TCS2 },
+	{ TCS2,			BUTTON_1,		GUARD_ALWAYS,	ACTION_NONE,			MEMORY_SET,		PATTERN_SWITCH1_ON,		MODE_SAME },	// 23
+	{ TCS2,			BUTTON_2,		GUARD_ALWAYS,	ACTION_NONE,			MEMORY_SET,		PATTERN_SWITCH2_ON,		MODE_SAME },
+	{ TCS2,			BUTTON_NONE,	GUARD_ALWAYS,	ACTION_NONE,			MEMORY_KEEP,	PATTERN_SWITCH_OFF,		MODE_SAME },
+	{ TCS2,			BUTTON_BOTH,	GUARD_MEMORY,	ACTION_NONE,			MEMORY_CLEAR,	PATTERN_TCS3_START,		TCS3 },
+	{ TCS3,			BUTTON_1,		GUARD_ALWAYS,	ACTION_RELAY1,			MEMORY_SET,		PATTERN_RELAY1_ON,		MODE_SAME },	// 27
+	{ TCS3,			BUTTON_2,		GUARD_ALWAYS,	ACTION_RELAY2,			MEMORY_SET,		PATTERN_RELAY2_ON,		MODE_SAME },
+	{ TCS3,			BUTTON_NONE,	GUARD_ALWAYS,	ACTION_RELAYS_REST,		MEMORY_KEEP,	PATTERN_RELAY_OFF,		MODE_SAME },
+	{ TCS3,			BUTTON_BOTH,	GUARD_MEMORY,	ACTION_RELAYS_REST,		MEMORY_CLEAR,	PATTERN_TCS4_START,		TCS4 },
+	{ TCS4,			EVENT_TICK,		GUARD_MEMORY,	ACTION_MEMORY_RESULT,	MEMORY_KEEP,	PATTERN_ROW,			MODE_SAME },	// 31
+	{ TCS4,			BUTTON_1,		GUARD_NOMEMORY,	ACTION_MEMORY_TEST,		MEMORY_SET,		PATTERN_ROW,			MODE_SAME },
+	{ TCS4,			BUTTON_BOTH,	GUARD_MEMORY,	ACTION_NONE,			MEMORY_CLEAR,	PATTERN_TCS5_START,		TCS5 },
+	{ TCS5,			BUTTON_1,		GUARD_ALWAYS,	ACTION_ROTATE_CW,		MEMORY_SET,		PATTERN_ROTATE,			MODE_SAME },	// 34
+	{ TCS5,			BUTTON_2,		GUARD_ALWAYS,	ACTION_ROTATE_STOP,		MEMORY_SET,		PATTERN_STOP,			MODE_SAME },
+	{ TCS5,			BUTTON_NONE,	GUARD_ALWAYS,	ACTION_ROTATE_STOP,		MEMORY_KEEP,	PATTERN_STOP,			MODE_SAME },
+	{ TCS5,			BUTTON_BOTH,	GUARD_MEMORY,	ACTION_ROTATE_STOP,		MEMORY_CLEAR,	PATTERN_STOP,			TCS6 },
+	{ TCS6,			EVENT_TICK,		GUARD_MEMORY,	ACTION_ROTATE,			MEMORY_KEEP,	PATTERN_ROW,			MODE_SAME },	// 38
+	{ TCS6,			BUTTON_1,		GUARD_NOMEMORY,	ACTION_CALIBRATE_START,	MEMORY_SET,		PATTERN_ROW,			MODE_SAME },
+	{ TCS6,			BUTTON_2,		GUARD_MEMORY,	ACTION_CALIBRATE_STOP,	MEMORY_KEEP,	PATTERN_ROW,			MODE_SAME },
+	{ TCS6,			BUTTON_BOTH,	GUARD_MEMORY,	ACTION_CALIBRATE_SAVE,	MEMORY_CLEAR,	PATTERN_TCS7_START,		TCS7 },
+	{ TCS7,			BUTTON_1,		GUARD_ALWAYS,	ACTION_NONE,			MEMORY_SET,		PATTERN_ROW,			MODE_SAME },	// 42
+	{ TCS7,			BUTTON_2,		GUARD_ALWAYS,	ACTION_NONE,			MEMORY_SET,		PATTERN_ROW,			MODE_SAME },
+	{ TCS7,			BUTTON_NONE,	GUARD_MEMORY,	ACTION_NONE,			MEMORY_CLEAR,	PATTERN_ROW,			MODE_EXIT }
+};
+
+/// \brief serial commands that send a report or start an export, they wait in _PendingReports for a tick
+/// in which getReportAllowed().
+static const uint8_t REPORT_COMMANDS[] PROGMEM = { COMMAND_MEMORY, COMMAND_MAINTENANCE, COMMAND_WATCHDOG, COMMAND_BUDGET,
+												   COMMAND_RECORDING, COMMAND_LOG };
+
+static const uint8_t MODE_ROWS = sizeof(modeTable) / sizeof(modeTable[0]);	///< Number of rows in the transition table.
+
+/// \brief get the first row of a state in modeTable, at compile time.
+/// \param state eModeState
+/// \param row first row to search.
+/// \return row, MODE_ROWS when the state has no rows.
+static constexpr uint8_t getFirstRow(uint8_t state, uint8_t row = 0)
+{
+	return (row >= MODE_ROWS || modeTable[row].state == state) ? row : getFirstRow(state, row + 1);
+}
+
+/// \brief check at compile time that the rows of each state are grouped in modeTable.
+/// \param row first row to check.
+/// \return true when each row that starts a state is the first row of that state.
+static constexpr bool getRowsGrouped(uint8_t row = 1)
+{
+	return (row >= MODE_ROWS) ||
+		   ((modeTable[row].state == modeTable[row - 1].state || getFirstRow(modeTable[row].state) == row) && getRowsGrouped(row + 1));
+}
+
+static_assert(getRowsGrouped(), "the rows of a state shall be grouped in modeTable");
+
+/// \brief first row in modeTable of each eModeState.
+static const uint8_t modeFirstRow[] PROGMEM = {
+	getFirstRow(MODE_EXIT),		// MODE_EXIT has no rows
+	getFirstRow(SBINIT),
+	getFirstRow(SB),
+	getFirstRow(SBFINISH),
+	getFirstRow(SYNCINIT),
+	getFirstRow(SYNC1),
+	getFirstRow(SYNC2),
+	getFirstRow(SYNCFINISH),
+	getFirstRow(TCSINIT),
+	getFirstRow(TCS1),
+	getFirstRow(TCS2),
+	getFirstRow(TCS3),
+	getFirstRow(TCS4),
+	getFirstRow(TCS5),
+	getFirstRow(TCS6),
+	getFirstRow(TCS7)
+};
+
+static_assert(sizeof(modeFirstRow) == TCS7 + 1, "modeFirstRow shall have a row for each eModeState");
+static_assert(getFirstRow(MODE_EXIT) == MODE_ROWS, "MODE_EXIT shall have no rows in modeTable");
+
+/// \brief led patterns.
+/// A pattern is a list of PATTERN_LED() entries ended by PATTERN_END. PATTERN_CLEAR clears all leds.
+#define PATTERN_LED(led, color)	(uint8_t)(((led) << 2) | (color))	///< Led number (0-62) and index in patternColors.
+#define PATTERN_CLEAR			0xFE								///< Clear all leds.
+#define PATTERN_END				0xFF								///< End of pattern.
+
+static const uint32_t patternColors[] PROGMEM = { BLUE, GREEN, RED, 0x00FFFFFF };	///< Colors of the led patterns.
+#define PB	0	///< Blue
+#define PG	1	///< Green
+#define PR	2	///< Red
+#define PW	3	///< White
+
+static const uint8_t patternSbStart[]	PROGMEM = { PATTERN_CLEAR, PATTERN_LED(0, PW), PATTERN_END };
+static const uint8_t patternSyncStart[]	PROGMEM = { PATTERN_CLEAR, PATTERN_LED(0, PB), PATTERN_END };
+static const uint8_t patternTcs1Start[]	PROGMEM = { PATTERN_CLEAR, PATTERN_LED(1, PB), PATTERN_END };
+static const uint8_t patternTcs2Start[]	PROGMEM = { PATTERN_CLEAR, PATTERN_LED(0, PB), PATTERN_LED(1, PG), PATTERN_LED(2, PB), PATTERN_LED(3, PB), PATTERN_END };
+static const uint8_t patternSwitch1On[]	PROGMEM = { PATTERN_LED(2, PG), PATTERN_END };
+static const uint8_t patternSwitch2On[]	PROGMEM = { PATTERN_LED(3, PG), PATTERN_END };
+static const uint8_t patternSwitchOff[]	PROGMEM = { PATTERN_LED(2, PB), PATTERN_LED(3, PB), PATTERN_END };
+static const uint8_t patternTcs3Start[]	PROGMEM = { PATTERN_LED(2, PB), PATTERN_LED(3, PB), PATTERN_LED(4, PB), PATTERN_LED(5, PB), PATTERN_END };
+static const uint8_t patternRelay1On[]	PROGMEM = { PATTERN_LED(4, PG), PATTERN_END };
+static const uint8_t patternRelay2On[]	PROGMEM = { PATTERN_LED(5, PG), PATTERN_END };
+static const uint8_t patternRelayOff[]	PROGMEM = { PATTERN_LED(4, PB), PATTERN_LED(5, PB), PATTERN_END };
+static const uint8_t patternTcs4Start[]	PROGMEM = { PATTERN_LED(4, PB), PATTERN_LED(5, PB), PATTERN_LED(6, PB), PATTERN_END };
+static const uint8_t patternMemoryOk[]	PROGMEM = { PATTERN_LED(6, PG), PATTERN_END };
+static const uint8_t patternMemoryFail[]PROGMEM = { PATTERN_LED(6, PR), PATTERN_END };
+static const uint8_t patternTcs5Start[]	PROGMEM = { PATTERN_LED(6, PB), PATTERN_LED(7, PB), PATTERN_END };
+static const uint8_t patternRotate[]	PROGMEM = { PATTERN_LED(7, PR), PATTERN_END };
+static const uint8_t patternStop[]		PROGMEM = { PATTERN_LED(7, PB), PATTERN_END };
+static const uint8_t patternTcs7Start[]	PROGMEM = { PATTERN_CLEAR, PATTERN_LED(0, PB), PATTERN_LED(1, PB), PATTERN_LED(2, PB), PATTERN_LED(3, PB),
+													PATTERN_LED(4, PB), PATTERN_LED(5, PB), PATTERN_LED(6, PB), PATTERN_LED(7, PG), PATTERN_END };
+
+/// \brief led patterns in order of eLedPattern.
+static const uint8_t* const ledPatterns[] PROGMEM = {
+	0,					// PATTERN_ROW
+	patternSbStart,
+	patternSyncStart,
+	patternTcs1Start,
+	patternTcs2Start,
+	patternSwitch1On,
+	patternSwitch2On,
+	patternSwitchOff,
+	patternTcs3Start,
+	patternRelay1On,
+	patternRelay2On,
+	patternRelayOff,
+	patternTcs4Start,
+	patternMemoryOk,
+	patternMemoryFail,
+	patternTcs5Start,
+	patternRotate,
+	patternStop,
+	patternTcs7Start
+};
+
 PE1MEW_RotorController::PE1MEW_RotorController():
 	_RunState(NORMAL),
+	_ModeState(MODE_EXIT),
 	_Brightness(200),
 	_FunctionMemory(false),
-	_CurrentDirection(15),
+	_EepromReport(false),
+	_Notices(0),
+	_PresetIndex(0),
+	_PendingReports(0),
+#ifdef CURRENTSENSOR
+	_AutoCalibration(AUTO_OFF),
+#endif
+	_CurrentDirection(150),
 	_NextDirection(0),
 	_RotorRunning(false),
 	_RunTimeCounter(36000.0),
-	_TestCalibrationState(TCSINIT),
+	_JournalCounter(0),
+#ifdef WATCHDOG
+	_MotorTicks(0),
+#endif
+#ifdef POWERWARNING
+	_PowerFailDirection(0),
+#endif
 	_rainbowCycleI(0),
 	_rainbowCycleJ(0),
-	_SynchronizationState(SYNCINIT),
-	_SetBrightnessState(SBINIT),
-	_SetBrightIncrement(true),
-	_MemorytestOnce(false)
+	_SetBrightIncrement(true)
 {
 	Initialize();
 }
@@ -45,29 +245,62 @@ void PE1MEW_RotorController::Initialize(void)
 {
 	/// Read variables from EEprom
 	_RunTimeCounter = Memory.readRunTimeCounter();
+	if (_RunTimeCounter == 0)		// Corrupted EEPROM: the rotor would not move and the watchdog would reset.
+	{
+		_RunTimeCounter = RUNTIME_DEFAULT;
+	}
 	_CurrentDirection = Memory.readDirection();
 	_Brightness = Memory.readBrightness();
 	
 	/// Set Rotor
-	Rotor.Initialize(_CurrentDirection, (float)_RunTimeCounter);
+	Rotor.Initialize(_CurrentDirection, _RunTimeCounter);
+	Rotor.setCommitDelay(COMMIT_DELAY);
 	Steering.initialize(_CurrentDirection);
+#ifdef ROTARYENCODER
+	Steering.initializeEncoder();
+#endif
 	
 	/// set Display
 	Display.setBrightness(_Brightness);
+	Display.setLayers(DISPLAY_LAYERS);
+	
+#ifdef POSITIONSENSOR
+	Sensor.Initialize();
+	Rotor.setDeadband(SENSOR_DEADBAND);		// The measured coast would start the rotor in the other direction.
+	Rotor.setEndStopDetection(true);
+	Rotor.setResync(0, 0);					// The measured direction does not drift.
+#endif
+#ifdef CURRENTSENSOR
+	Current.Initialize();
+	Rotor.setEndStopDetection(true);
+#endif
+#ifdef POWERWARNING
+	_PowerFailDirection = _CurrentDirection;
+#ifdef __AVR__
+	ACSR = (1 << ACBG) | (1 << ACI) | (1 << ACIE) | (1 << ACIS1) | (1 << ACIS0);	// bandgap against AIN1, interrupt when AIN1 drops below it
+	DIDR1 = (1 << AIN1D);
+#endif
+#endif
+#ifdef INPUTRECORDER
+	Recorder.Initialize(Steering.getButtons(), _CurrentDirection, _RunTimeCounter, _Brightness);
+#endif
 
 	/// Read startup-state from buttons to select the initial mode of operation
 	switch (Steering.getButtons())
 	{
 		case BUTTON_1:					/// Button 1 (CCW) is pressed:
 			_RunState = SYNCHRONIZE;	/// Synchronize mode: Turn rotor 36 degrees CW an CCW to synchronize bot motor unit and display.
+			_ModeState = SYNCINIT;
 			break;
 		
 		case BUTTON_2:					/// Button 2  (CW) is pressed:
 			_RunState = SET_INTENSITY;	/// Set the intensity of the leds and store in to memory
+			_ModeState = SBINIT;
 			break;
 		
 		case BUTTON_BOTH:				/// Both buttons are pressed:
 			_RunState = TEST_CALIBRATE;	/// Test and Calibration mode.
+			_ModeState = TCSINIT;
 			break;
 
 		default:						/// No buttons are pressed:
@@ -78,6 +311,48 @@ void PE1MEW_RotorController::Initialize(void)
 
 void PE1MEW_RotorController::Process(void)
 {
+#ifdef WATCHDOG
+	Watchdog.startTick();
+#endif
+#ifdef TICKBUDGET
+	Budget.startTick(Watchdog.getTickStart());
+#endif
+#ifdef INPUTRECORDER
+	Recorder.recordButtons(Steering.getButtons());
+#endif
+#ifdef POSITIONSENSOR
+	// The modes turn the rotor to the end stops by time, in normal operation the sensor is used.
+	if (Sensor.Process() && _RunState == NORMAL)
+	{
+		Rotor.fusePosition(Sensor.getDirection(), Sensor.getVariance());
+		if (Sensor.isStalled(Rotor.getIsRotorRunning()))
+		{
+			processStall();
+		}
+	}
+#endif
+#ifdef CURRENTSENSOR
+	if (Current.Process() && _RunState == NORMAL && Current.isStalled(Rotor.getIsRotorRunning()))
+	{
+		processStall();
+	}
+#endif
+	
+	bool written = ProcessMemory();
+#ifdef MOVELOG
+	written |= Log.Process(digitalRead(REL1_PIN) == RELAY_ACTIVE, digitalRead(REL2_PIN) == RELAY_ACTIVE, getWriteAllowed(Log.getPending(), written));
+#endif
+#ifdef MAINTENANCECOUNTER
+	written |= Maintenance.Process(digitalRead(REL1_PIN) == RELAY_ACTIVE, digitalRead(REL2_PIN) == RELAY_ACTIVE, getWriteAllowed(Maintenance.getPending(), written));
+#endif
+	
+	// The self-test of the EEPROM reads or writes in the ticks without other EEPROM writes.
+	if (!written)
+	{
+		written = Memory.ProcessTest(getWriteAllowed(Memory.getTestWrite(), written));
+	}
+	(void)written;
+	
 	switch(_RunState)
 	{
 		case NORMAL:
@@ -85,31 +360,107 @@ void PE1MEW_RotorController::Process(void)
 			break;
 		
 		case SYNCHRONIZE:
-			RunSynchronize();
-			break;
-		
 		case SET_INTENSITY:
-			RunSetBrightness();
-			break;
-		
 		case TEST_CALIBRATE:
-			RunTestCalibrate();
+			RunMode();
 			break;
 		
 		default:
 			RunDebug();
 			break;	
 	}
+	
+#ifdef INPUTRECORDER
+	Recorder.Process(digitalRead(REL1_PIN) == RELAY_ACTIVE, digitalRead(REL2_PIN) == RELAY_ACTIVE);
+#endif
+#ifdef DEBUGLOG
+	if (!getExporting())						// The messages wait for the end of the export.
+	{
+		PE1MEW_DebugLog::Process();
+	}
+#endif
+#ifdef WATCHDOG
+	Watchdog.endTick(_RunState, getHealthy());
+#endif
+}
+
+bool PE1MEW_RotorController::ProcessMemory(void)
+{
+#ifdef TICKBUDGET
+	// The saved direction and the journal first, as many bytes as the budget of the tick allows.
+	bool written = false;
+	while (Memory.getPending() && Budget.request(TASK_EEPROM, COST_EEPROM_BYTE))
+	{
+		written |= Memory.Process();
+	}
+	return written;
+#else
+	return Memory.Process();
+#endif
+}
+
+bool PE1MEW_RotorController::getWriteAllowed(bool pending, bool written)
+{
+#ifdef TICKBUDGET
+	(void)written;
+	return pending && Budget.request(TASK_EEPROM, COST_EEPROM_BYTE);
+#else
+	// The log and the counters write in the ticks the journal does not, so the sys tick waits for at most one EEPROM write.
+	(void)pending;
+	return !written;
+#endif
+}
+
+bool PE1MEW_RotorController::getExporting(void)
+{
+#ifdef MOVELOG
+	if (Log.getExporting())
+	{
+		return true;
+	}
+#endif
+#ifdef INPUTRECORDER
+	if (Recorder.getExporting())
+	{
+		return true;
+	}
+#endif
+	return false;
+}
+
+bool PE1MEW_RotorController::getReportAllowed(void)
+{
+	if (getExporting())
+	{
+		return false;						// The text would be inserted in the export.
+	}
+#ifdef TICKBUDGET
+	return Budget.request(TASK_SERIAL, PE1MEW_TickBudget::getSerialCost(REPORT_LENGTH));
+#else
+	return true;
+#endif
 }
 
 void PE1MEW_RotorController::RunNormal(void)
 {
 	Rotor.Process();
+#ifdef TICKBUDGET
+	Display.Process(Budget.request(TASK_FRAME, DISPLAY_SHOW_TIME));
+#else
 	Display.Process();
+#endif
 	Steering.Process();
+	Terminal.Process();
+	ProcessCommand();
 		
 	_RotorRunning = Rotor.getIsRotorRunning();
 	Display.setRotorRunning(_RotorRunning);
+#ifdef CURRENTSENSOR
+	if (_AutoCalibration != AUTO_OFF && !Rotor.getSeeking())	// the end stop was not found in time
+	{
+		finishAutoCalibration(0);
+	}
+#endif
 
 	_NextDirection = Steering.getNextDirection();		// Get target direction from steering unit
 	Rotor.setDirection(_NextDirection);					// Set rotor with target direction
@@ -117,570 +468,655 @@ void PE1MEW_RotorController::RunNormal(void)
 	Display.setCurrentDirection(_CurrentDirection);		// Send actual direction to LED display
 	Display.setNextDirection(_NextDirection);			// Send target direction to LED display
 
+#ifdef POWERWARNING
+#ifdef __AVR__
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+	{
+		_PowerFailDirection = _CurrentDirection;
+	}
+#endif
+	
 	if(_RotorRunning)
 	{
+		if (!_FunctionMemory)
+		{
+			DEBUG_LOG2(MOVE_START, _CurrentDirection, _NextDirection);
+#ifdef MOVELOG
+			Log.startMove(_CurrentDirection);
+#endif
+		}
 		_FunctionMemory = true;
+		
+		// Journal entries while turning, so the direction is known when the power is lost.
+		if (++_JournalCounter >= JOURNAL_INTERVAL && Memory.writeCheckpoint(_CurrentDirection))
+		{
+			_JournalCounter = 0;
+		}
 	}
 	if(!_RotorRunning && _FunctionMemory)
 	{
+		DEBUG_LOG1(MOVE_END, _CurrentDirection);
+#ifdef TICKBUDGET
+		Memory.queueDirection(_CurrentDirection);
+#else
 		Memory.writeDirection(_CurrentDirection);
+#endif
+		_JournalCounter = 0;
+#ifdef MOVELOG
+		Log.endMove(_NextDirection, _CurrentDirection);
+#endif
+		
+		// The runtime adapted by adaptRunTime() is saved when it changed enough, to spare the EEPROM.
+		uint16_t saved = Memory.readRunTimeCounter();
+		uint16_t difference = (saved > _RunTimeCounter) ? saved - _RunTimeCounter : _RunTimeCounter - saved;
+		if (difference > (saved >> RUNTIME_SAVE_SHIFT))
+		{
+#ifdef TICKBUDGET
+			Memory.queueRunTimeCounter(_RunTimeCounter);
+#else
+			Memory.writeRunTimeCounter(_RunTimeCounter);
+#endif
+		}
 		_FunctionMemory = false;
 	}
 }
 
-void PE1MEW_RotorController::RunSetBrightness(void)
+void PE1MEW_RotorController::processStall(void)
 {
-	switch(_SetBrightnessState)
+	uint16_t runtime = Rotor.setEndStopReached();
+	DEBUG_LOG2(STALL, Rotor.getDirection(), runtime);
+	
+	if (Rotor.getIsRotorRunning())				// Not at an end stop: jammed
 	{
-		case SBINIT:
-			Display.showLedClear();					/// Clear all led information
-			Display.showLedColor(0,0x00ffffff);		/// Set color of the led to white.
-			_Brightness = 200;						/// Set brightness starting point at 200 of 255
-			_SetBrightnessState = SB;				/// Set state machine of brightness calibration process to next state (SB)
-			break;
-		
-		case SB:
-			BrightnessProcess();
-			break;
+		if (Rotor.setJammed())
+		{
+			DEBUG_LOG1(JAMMED, Rotor.getDirection());
+			Steering.setNextDirection(Rotor.getDirection());	// The rotor is not started into the jam again.
+			_Notices |= NOTICE_JAMMED;
+		}
+		return;
+	}
+	
+#ifdef CURRENTSENSOR
+	switch (_AutoCalibration)
+	{
+		case AUTO_CCW:							// At the CCW end stop, measure the runtime to the CW end stop
+			Rotor.seekEndStop(CW);
+			_AutoCalibration = AUTO_CW;
+			return;
 		
-		case SBFINISH:
-			Memory.writeBrightness(_Brightness);	/// Write brightness to memory
-			Display.setBrightness(_Brightness);		/// Write brightness to display to make new settings active in following RUN mode
-			_RunState = NORMAL;
-		break;
+		case AUTO_CW:
+			finishAutoCalibration(runtime);
+			return;
 		
 		default:
 			break;
 	}
-	Display.showLedBrightness(_Brightness);
+#endif
+	adaptRunTime(runtime);
 }
 
-void PE1MEW_RotorController::RunTestCalibrate(void)
+#ifdef CURRENTSENSOR
+void PE1MEW_RotorController::finishAutoCalibration(uint16_t runtime)
 {
-	switch(_TestCalibrationState)
+	_AutoCalibration = AUTO_OFF;
+	if (runtime == 0)
 	{
-		case TCSINIT:
-			TCSINITProcess();
-			break;
-		
-		case TCS1:			// Test Leds
-			TCS1Process();
-			break;
-			
-		case TCS2:			// Test Switches 1 and 2
-			TCS2Process();
-			break;
-			
-		case TCS3:			// Test relay 1 and 2
-			TCS3Process();
-			break;
-			
-		case TCS4:			// rotate Rotor CCW until stop
-			TCS4Process();
-			break;
-			
-		case TCS5:			// rotate Rotor CW until stop and measure time
-			TCS5Process();
-			break;
-		
-		case TCS6:			// rotate Rotor CCW until stop and measure time
-			TCS6Process();
-			break;
-		
-		case TCS7:			// rotate Rotor CCW until stop and measure time
-			TCS7Process();
-			break;
-		
-		case TCSFINISH:
-			_RunState = NORMAL;
-			break;
-			
-		default:
-			break;
+		_Notices |= NOTICE_CALIBRATION_FAILED;
+		return;
 	}
+	
+	// As the test and calibration mode: the runtime from end stop to end stop replaces the runtime.
+	_RunTimeCounter = runtime;
+	Rotor.setRunTime(runtime);
+#ifdef TICKBUDGET
+	Memory.queueRunTimeCounter(runtime);
+#else
+	Memory.writeRunTimeCounter(runtime);
+#endif
+	_Notices |= NOTICE_RUNTIME;
 }
+#endif
 
-void PE1MEW_RotorController::RunDebug(void)
+#ifdef POWERWARNING
+void PE1MEW_RotorController::powerFail(void)
 {
-		Display.showLedClear();
-		Display.showLedColor(0,RED);
-		
-		// Do something every second
-		if (_debugCounter == 100)
-		{
-			// Put someting to do here
-			
-			_debugCounter = 0;
-		}
-		_debugCounter++;
-		
-		// Do something once
-		if (_bMemory1)
-		{
-			// Put someting to do here
-
-			_bMemory1 = false;
-		}
+	digitalWrite(REL1_PIN, RELAY_REST);			// The motor takes the charge the controller needs.
+	digitalWrite(REL2_PIN, RELAY_REST);
+	Memory.commitCheckpoint(_PowerFailDirection);
+#ifdef WATCHDOG
+	Watchdog.setRestart();
+#endif
 }
+#endif
 
-void PE1MEW_RotorController::BrightnessProcess(void)
+#ifdef WATCHDOG
+bool PE1MEW_RotorController::getHealthy(void)
 {
-	// Read state from buttons
-	switch (Steering.getButtons())
+	// A run state or mode state out of its range would run RunDebug() or no row of the transition table
+	// and leave the relays as they are.
+	if (_RunState > TEST_CALIBRATE || (_ModeState > TCS7 && _ModeState != MODE_SAME))
 	{
-		case BUTTON_1:
-			if(_SetBrightIncrement)
-			{
-				if (_Brightness < 254)
-				{
-					_Brightness++;
-				}
-				else
-				{
-					_SetBrightIncrement = false;
-				}
-			}
-			else
-			{
-				if (_Brightness > 1)
-				{
-					_Brightness--;
-				}
-				else
-				{
-					_SetBrightIncrement = true;
-				}
-			}
-
-			_FunctionMemory = true;
-			break;
-					
-			case BUTTON_2:
-			if(_FunctionMemory)
-			{
-				_SetBrightnessState = SBFINISH;
-			}
-			break;
+		return false;
+	}
+	
+	// The longest move in normal operation, the search of an end stop, takes 1.5 times the runtime.
+	// The motor may run twice the runtime (WATCHDOG_MOTOR_SHIFT), a margin of 1/2 runtime. The runtime
+	// is never 0, see Initialize().
+	if (_RunState == NORMAL && digitalRead(REL1_PIN) == RELAY_ACTIVE)
+	{
+		_MotorTicks = (_MotorTicks < 0xFFFF) ? _MotorTicks + 1 : _MotorTicks;
+	}
+	else
+	{
+		_MotorTicks = 0;
+	}
+	return _MotorTicks <= ((uint32_t)_RunTimeCounter << WATCHDOG_MOTOR_SHIFT);
+}
+#endif
 
-		default:
-			break;
+void PE1MEW_RotorController::adaptRunTime(uint16_t runtime)
+{
+	int32_t difference = (int32_t)runtime - _RunTimeCounter;
+	int32_t limit = _RunTimeCounter >> RUNTIME_STEP_SHIFT;
+	
+	// Moves stopped by hand or by a jam are not a measurement of the runtime.
+	if (runtime == 0 || difference > (_RunTimeCounter >> RUNTIME_OUTLIER_SHIFT) || -difference > (_RunTimeCounter >> RUNTIME_OUTLIER_SHIFT))
+	{
+		return;
 	}
+	
+	difference >>= RUNTIME_GAIN_SHIFT;
+	if (difference > limit)
+	{
+		difference = limit;
+	}
+	if (difference < -limit)
+	{
+		difference = -limit;
+	}
+	_RunTimeCounter += difference;
+	Rotor.setRunTime(_RunTimeCounter);
 }
 
-void PE1MEW_RotorController::TCSINITProcess(void)
+void PE1MEW_RotorController::sendNotices(void)
 {
-	Display.showLedClear();
-	Display.showLedBrightness(_Brightness);
-	Display.showLedColor(1,BLUE);
-	_TestCalibrationState = TCS1;
+	if (_Notices == 0 || !getReportAllowed())
+	{
+		return;
+	}
+	if (_Notices & NOTICE_JAMMED)
+	{
+		Serial.println(F("jammed"));
+	}
+	if (_Notices & NOTICE_CALIBRATION_FAILED)
+	{
+		Serial.println(F("calibration failed"));
+	}
+	if (_Notices & NOTICE_RUNTIME)
+	{
+		Serial.print(F("runtime "));
+		Serial.println(_RunTimeCounter);
+	}
+	_Notices = 0;
 }
 
-void PE1MEW_RotorController::TCS1Process(void)
+void PE1MEW_RotorController::ProcessCommand(void)
 {
-	if(_FunctionMemory)
+	sendNotices();
+	
+	if (_EepromReport && !Memory.getTestRunning() && getReportAllowed())
+	{
+		Memory.report();
+		_EepromReport = false;
+	}
+	
+	uint8_t received = Terminal.getCommand();
+	if (received != COMMAND_NONE)
+	{
+		DEBUG_LOG2(COMMAND, received, Terminal.getArgument());
+	}
+	
+#ifdef MAINTENANCECOUNTER
+	// The counter is cleared at once, only the report may wait.
+	if (received == COMMAND_MAINTENANCE && Terminal.getArgument() != 0)
 	{
-		if (_rainbowCycleJ < LEDCOUNT)
+		Maintenance.clearCounter((Terminal.getArgument() == 10) ? COUNTER_RELAY1 : COUNTER_RELAY2);
+	}
+#endif
+	
+	// A report waits in _PendingReports for a tick with time to send it and for the end of an export, the
+	// other commands are served meanwhile.
+	for (uint8_t i = 0; i < sizeof(REPORT_COMMANDS); i++)
+	{
+		if (received == pgm_read_byte(&REPORT_COMMANDS[i]))
 		{
-			Display.showLedColor(_rainbowCycleJ, TCS1Rainbow(((_rainbowCycleI * 256 / LEDCOUNT) + _rainbowCycleJ) & 255));
-			_rainbowCycleJ++;
+			_PendingReports |= 1 << i;
+			received = COMMAND_NONE;
 		}
-		else
+	}
+	if (received == COMMAND_NONE && _PendingReports != 0 && getReportAllowed())
+	{
+		uint8_t i = 0;
+		while (!(_PendingReports & (1 << i)))
 		{
-			_rainbowCycleJ = 0;
+			i++;
 		}
-		_rainbowCycleI++;
+		_PendingReports &= ~(1 << i);
+		received = pgm_read_byte(&REPORT_COMMANDS[i]);
 	}
-
-	// Read state from buttons
-	switch (Steering.getButtons())
+	
+	switch (received)
 	{
-		case BUTTON_1:
-			_FunctionMemory = true;
+		case COMMAND_DIRECTION:
+			Steering.setNextDirection(Terminal.getArgument());	// Serial command overrides direction set by buttons
+#ifdef INPUTRECORDER
+			Recorder.recordDirection(Terminal.getArgument());
+#endif
+			break;
+		
+		case COMMAND_MEMORY:
+			Serial.print(F("RAM free "));
+			Serial.print(Ram.getFreeRam());
+			Serial.print(F(" stack peak "));
+			Serial.print(Ram.getStackPeak());
+			Serial.print(F(" never used "));
+#ifdef DISPLAYBENCHMARK
+			Serial.print(Ram.getStackUnused());
+			Serial.print(F(" display legacy "));
+			Serial.print(Display.getLegacyTime());
+			Serial.print(F(" compose "));
+			Serial.print(Display.getComposeTime());
+			Serial.println(F(" us"));
+#else
+			Serial.println(Ram.getStackUnused());
+#endif
 			break;
 		
-		case BUTTON_BOTH:
-			if(_FunctionMemory)
+		case COMMAND_PRESET:
+			if (Terminal.getArgument() == ARGUMENT_NONE)
+			{
+				for (uint8_t i = 0; i < PRESETCOUNT; i++)
+				{
+					Display.setPresetDirection(i, PRESET_UNUSED);
+				}
+				_PresetIndex = 0;
+			}
+			else
 			{
-				Display.showLedClear();
-				Display.showLedColor(0,BLUE);	// Indicate testing process
-				Display.showLedColor(1,GREEN);	// Indicate first test finished
-				Display.showLedColor(2,BLUE);	// Indicate second test running
-				Display.showLedColor(3,BLUE);	// Indicate third test running
-				_TestCalibrationState++;
-				_FunctionMemory = false;
+				Display.setPresetDirection(_PresetIndex, Terminal.getArgument());	// The oldest preset is replaced.
+				_PresetIndex = (_PresetIndex + 1) % PRESETCOUNT;
 			}
 			break;
 		
+#ifdef INPUTRECORDER
+		case COMMAND_RECORDING:
+			Recorder.startExport();
+			break;
+#endif
+		
+#ifdef MOVELOG
+		case COMMAND_LOG:
+			Log.startExport();
+			break;
+#endif
+		
+#ifdef MAINTENANCECOUNTER
+		case COMMAND_MAINTENANCE:
+			Serial.print(F("relay1 "));
+			Serial.print(Maintenance.getCounter(COUNTER_RELAY1));
+			Serial.print(F(" relay2 "));
+			Serial.print(Maintenance.getCounter(COUNTER_RELAY2));
+			Serial.print(F(" motor "));
+			Serial.print(Maintenance.getCounter(COUNTER_MOTOR));
+			Serial.println(F(" s"));
+			break;
+#endif
+		
+#ifdef WATCHDOG
+		case COMMAND_WATCHDOG:
+			Watchdog.report();
+			break;
+#endif
+		
+#ifdef TICKBUDGET
+		case COMMAND_BUDGET:
+			Budget.report(Watchdog.getLongestTick(), Watchdog.getOverruns());
+			break;
+#endif
+		
+		case COMMAND_EEPROM:
+			Memory.startTest();
+			_EepromReport = true;
+			break;
+		
+#ifdef CURRENTSENSOR
+		case COMMAND_CALIBRATE:
+			Rotor.seekEndStop(CCW);
+			_AutoCalibration = AUTO_CCW;
+			break;
+#endif
+		
 		default:
 			break;
-	}	
+	}
 }
 
-/*
-Input a value 0 to 255 to get a color value.
-The colours are a transition r - g - b - back to r.
-copied form Aruino neopixel driver code
-*/
+void PE1MEW_RotorController::RunMode(void)
+{
+	sModeTransition transition;
+	uint8_t state = _ModeState;
+	uint8_t buttons = Steering.getButtons();
+	bool guard = false;
+	
+	for (uint8_t row = pgm_read_byte(&modeFirstRow[state]); row < MODE_ROWS; row++)
+	{
+		memcpy_P(&transition, &modeTable[row], sizeof(transition));
+		if (transition.state != state)
+		{
+			break;					// All rows of the state are evaluated.
+		}
+		
+		if (transition.event != EVENT_TICK && transition.event != buttons)
+		{
+			continue;
+		}
+		
+		switch (transition.guard)
+		{
+			case GUARD_MEMORY:
+				guard = _FunctionMemory;
+				break;
+			
+			case GUARD_NOMEMORY:
+				guard = !_FunctionMemory;
+				break;
+			
+			case GUARD_STOPPED:
+				guard = _FunctionMemory && !Rotor.getIsRotorRunning();
+				break;
+			
+			default:
+				guard = true;
+				break;
+		}
+		
+		if (guard)
+		{
+			RunModeTransition(transition);
+			if (transition.event != EVENT_TICK || transition.next != MODE_SAME)
+			{
+				break;				// Only one button row per tick, a state change ends the tick.
+			}
+		}
+	}
+}
 
-uint32_t PE1MEW_RotorController::TCS1Rainbow(byte WheelPos) 
+void PE1MEW_RotorController::RunModeTransition(const sModeTransition& transition)
 {
-	WheelPos = 255 - WheelPos;
-	if(WheelPos < 85) 
+	uint8_t pattern = RunModeAction(transition.action);
+	
+	if (pattern == PATTERN_ROW)
 	{
-		return ((uint32_t)(255 - WheelPos * 3) << 16) | ((uint32_t)0 <<  8) | WheelPos * 3;
+		pattern = transition.pattern;
 	}
-	if(WheelPos < 170) 
+	
+	if (transition.memory == MEMORY_SET)
 	{
-		WheelPos -= 85;
-		return ((uint32_t)0 << 16) | ((uint32_t)(WheelPos * 3) <<  8) | (255 - WheelPos * 3);
+		_FunctionMemory = true;
+	}
+	else if (transition.memory == MEMORY_CLEAR)
+	{
+		_FunctionMemory = false;
+	}
+	
+	showPattern(pattern);
+	
+	if (transition.next != MODE_SAME)
+	{
+		_ModeState = transition.next;
+		if (_ModeState == MODE_EXIT)
+		{
+			_RunState = NORMAL;
+		}
 	}
-	WheelPos -= 170;
-	return ((uint32_t)(WheelPos * 3) << 16) | ((uint32_t)(255 - WheelPos * 3) <<  8) | 0;
 }
 
-void PE1MEW_RotorController::TCS2Process(void)
+uint8_t PE1MEW_RotorController::RunModeAction(uint8_t action)
 {
-	// Read state from buttons
-	switch (Steering.getButtons())
+	uint8_t returnValue = PATTERN_ROW;
+	
+	switch (action)
 	{
-		case BUTTON_1:
-			Display.showLedColor(2,GREEN);
-			_FunctionMemory = true;
+		case ACTION_SHOW_BRIGHTNESS:
+			Display.showLedBrightness(_Brightness);
 			break;
 		
-		case BUTTON_2:
-			Display.showLedColor(3,GREEN);
-			_FunctionMemory = true;
+		case ACTION_BRIGHTNESS_START:
+			_Brightness = 200;							/// Set brightness starting point at 200 of 255
+			Display.showLedBrightness(_Brightness);
 			break;
-
-		case BUTTON_NONE:
-			Display.showLedColor(2,BLUE);
-			Display.showLedColor(3,BLUE);
+		
+		case ACTION_BRIGHTNESS_STEP:
+			BrightnessProcess();
 			break;
 		
-		case BUTTON_BOTH:
-			if(_FunctionMemory)
-			{
-				Display.showLedColor(2,BLUE);
-				Display.showLedColor(3,BLUE);
-				Display.showLedColor(4,BLUE);
-				Display.showLedColor(5,BLUE);
-				_TestCalibrationState++;
-				_FunctionMemory = false;
-			}
+		case ACTION_BRIGHTNESS_SAVE:
+			Memory.writeBrightness(_Brightness);		/// Write brightness to memory
+			Display.setBrightness(_Brightness);			/// Write brightness to display to make new settings active in following RUN mode
+			Display.showLedBrightness(_Brightness);
 			break;
 		
-		default:
+		case ACTION_RAINBOW:
+			TCS1Process();
 			break;
-	}
-}
-
-void PE1MEW_RotorController::TCS3Process(void)
-{
-	// Read state from buttons
-	switch (Steering.getButtons())
-	{
-		case BUTTON_1:
-			Display.showLedColor(4,GREEN);
+		
+		case ACTION_RELAY1:
 			digitalWrite(REL1_PIN, RELAY_ACTIVE);
-
-			_FunctionMemory = true;
 			break;
 		
-		case BUTTON_2:
-			Display.showLedColor(5,GREEN);
+		case ACTION_RELAY2:
 			digitalWrite(REL2_PIN, RELAY_ACTIVE);
-		
-			_FunctionMemory = true;
 			break;
-
-		case BUTTON_NONE:
-			Display.showLedColor(4,BLUE);
-			Display.showLedColor(5,BLUE);
+		
+		case ACTION_RELAYS_REST:
 			digitalWrite(REL1_PIN, RELAY_REST);
 			digitalWrite(REL2_PIN, RELAY_REST);
-
 			break;
 		
-		case BUTTON_BOTH:
-			if(_FunctionMemory)
-			{
-				Display.showLedColor(4,BLUE);
-				Display.showLedColor(5,BLUE);
-				Display.showLedColor(6,BLUE);
-				_TestCalibrationState++;
-				_FunctionMemory = false;
-			}
+		case ACTION_MEMORY_TEST:
+			Memory.startTest();
 			break;
 		
-		default:
-			break;
-	}
-}
-
-void PE1MEW_RotorController::TCS4Process(void)
-{
-	if(_MemorytestOnce)
-	{
-		_MemorytestOnce = false;
-		if(Memory.memoryTest())
-		{
-			Display.showLedColor(6,GREEN);
-		}
-		else
-		{
-			Display.showLedColor(6,RED);
-		}
-	}
-
-	switch (Steering.getButtons())
-	{
-		case BUTTON_1:
-			if(!_FunctionMemory)
+		case ACTION_MEMORY_RESULT:
+			if (!Memory.getTestRunning())
 			{
-				_MemorytestOnce = true;
+				returnValue = (Memory.getHealth() == 0) ? PATTERN_MEMORY_OK : PATTERN_MEMORY_FAIL;
 			}
-			_FunctionMemory = true;
 			break;
 		
-		case BUTTON_BOTH:
-		if(_FunctionMemory)
-		{
-			Display.showLedColor(6,BLUE);
-			Display.showLedColor(7,BLUE);
-			_TestCalibrationState++;
-			_FunctionMemory = false;
-		}
-		break;
-	
-	default:
-		break;
-	}
-}
-
-void PE1MEW_RotorController::TCS5Process(void)
-{
-	// Read state from buttons
-	switch (Steering.getButtons())
-	{
-		case BUTTON_1:
-			_FunctionMemory = true;
+		case ACTION_ROTATE_CW:
 			Rotor.setRotorTurn(CW);
-			Display.showLedColor(7,RED);
-		break;
+			break;
 		
-		case BUTTON_2:
-			_FunctionMemory = true;
+		case ACTION_ROTATE_STOP:
 			Rotor.setRotorStop();
-			Display.showLedColor(7,BLUE);
-		break;
+			break;
 		
-		case BUTTON_BOTH:
-			if(_FunctionMemory)
-			{
-				Display.showLedColor(7,BLUE);
-				_TestCalibrationState++;
-				_FunctionMemory = false;
-			}
+		case ACTION_ROTATE:
+			RotateProcess();
 			break;
 		
-		default:
-			Rotor.setRotorStop();
-			Display.showLedColor(7,BLUE);
+		case ACTION_CALIBRATE_START:
+			Rotor.calibrateRunTimeCounter();			// set rotorcontrol to calibration mode.
+			Rotor.Initialize(3600, 0xFFFF);				// Set direction 360 degrees and rotation time of 10,92 minutes
+			_NextDirection = 0;							// Set rotor with target direction 0 degrees
+			Rotor.setDirection(_NextDirection);
+			Display.setRotorRunning(true);				// tell displaycontrol that rotor is running to indicate read and blue leds.
 			break;
-	}
-}
-
-void PE1MEW_RotorController::TCS6Process(void)
-{
-	if(_FunctionMemory)
-	{
-		Rotor.Process();
-		Display.Process();
-		Steering.Process();
 		
-		_CurrentDirection = Rotor.getDirection();			// Get actual direction form rotor
-		Display.setCurrentDirection(_CurrentDirection);		// Send actual direction to LED display
-	}
-	
-	// Read state from buttons
-	switch (Steering.getButtons())
-	{
-		case BUTTON_1:
-			if (!_FunctionMemory)
-			{
-				Rotor.calibrateRunTimeCounter();		// set rotorcontrol to calibration mode.
-				Rotor.Initialize(360, 0xFFFF);			// Set direction 360 degrees and rotation time of 10,92 minutes
-				Rotor.setDirection(0);					// Set rotor with target direction 0 degrees
-				Display.setRotorRunning(true);			// tell displaycontrol that rotor is running to indicate read and blue leds.
-			}
-			_FunctionMemory = true;
+		case ACTION_CALIBRATE_STOP:
+			_RunTimeCounter = Rotor.getRunTimeCounter();
+			Display.setRotorRunning(false);				// tell displaycontrol that rotor is not running to indicate a green led.
 			break;
 		
-		case BUTTON_2:
-			if (_FunctionMemory)
+		case ACTION_CALIBRATE_SAVE:
+			if (_RunTimeCounter == 0)						// Stopped at once: no measurement, keep the saved runtime.
 			{
-				_RunTimeCounter = (uint16_t)Rotor.getRunTimeCounter();
-				Display.setRotorRunning(false);			// tell displaycontrol that rotor is not running to indicate a green led.
+				_RunTimeCounter = Memory.readRunTimeCounter();
+				_RunTimeCounter = (_RunTimeCounter == 0) ? RUNTIME_DEFAULT : _RunTimeCounter;
 			}
-			break;
-		
-		case BUTTON_BOTH:
-			if(_FunctionMemory)
+			else
 			{
 				Memory.writeRunTimeCounter(_RunTimeCounter);	// write to memory
-				Rotor.Initialize(1, _RunTimeCounter);			// initialize rotorcontrol with new RunTimeCounter value.
-				Steering.initialize(0);
-				
-				Display.showLedClear();
-				Display.showLedColor(0,BLUE);	// Indicate testing process
-				Display.showLedColor(1,BLUE);	// Indicate first test finished
-				Display.showLedColor(2,BLUE);	// Indicate second test running
-				Display.showLedColor(3,BLUE);	// Indicate third test running
-				Display.showLedColor(4,BLUE);
-				Display.showLedColor(5,BLUE);
-				Display.showLedColor(6,BLUE);
-				Display.showLedColor(7,GREEN);
-				_TestCalibrationState++;
-				_FunctionMemory = false;
 			}
+			Rotor.Initialize(10, _RunTimeCounter);			// initialize rotorcontrol with new RunTimeCounter value.
+			Steering.initialize(0);
 			break;
-			
+		
+		case ACTION_SYNC_CCW:
+			_NextDirection = 0;							// Set CCW to 0
+			Display.setRotorRunning(false);
+			break;
+		
+		case ACTION_SYNC_CW:
+			_NextDirection = 3600;						// Set CW to 360 degrees
+			Display.setRotorRunning(false);
+			break;
+		
+		case ACTION_SYNC_FINISH:
+			Steering.initialize(_NextDirection);
+			break;
+		
 		default:
 			break;
 	}
+	return returnValue;
 }
 
-void PE1MEW_RotorController::TCS7Process(void)
+void PE1MEW_RotorController::showPattern(uint8_t pattern)
 {
-	// Read state from buttons
-	switch (Steering.getButtons())
+	const uint8_t* entry;
+	uint8_t code;
+	
+	if (pattern == PATTERN_ROW)
 	{
-		case BUTTON_1:
-			_FunctionMemory = true;
-			break;
-			
-		case BUTTON_2:
-			_FunctionMemory = true;
-			break;
-
-		case BUTTON_NONE:
-			if(_FunctionMemory)
-			{
-				_TestCalibrationState++;
-				_FunctionMemory = false;
-			}
-			break;
-			
-		default:
-			break;
+		return;
 	}
+	
+	entry = (const uint8_t*)pgm_read_ptr(&ledPatterns[pattern]);
+	while ((code = pgm_read_byte(entry++)) != PATTERN_END)
+	{
+		if (code == PATTERN_CLEAR)
+		{
+			Display.setLedClear();
+		}
+		else
+		{
+			Display.setLedColor(code >> 2, pgm_read_dword(&patternColors[code & 0x03]));
+		}
+	}
+	Display.showLed();
 }
 
-void PE1MEW_RotorController::RunSynchronize(void)
+void PE1MEW_RotorController::RotateProcess(void)
 {
-	switch(_SynchronizationState)
-	{
-		case SYNCINIT:
-			_SynchronizationState++;
-			break;
-			
-		case SYNC1:			
-			SyncStep1();
-			break;
-			
-		case SYNC2:			
-			SyncStep2();
-			break;
+	Rotor.Process();
+#ifdef TICKBUDGET
+	Display.Process(Budget.request(TASK_FRAME, DISPLAY_SHOW_TIME));
+#else
+	Display.Process();
+#endif
+	Steering.Process();
+	
+	Rotor.setDirection(_NextDirection);					// Set rotor with target direction
+	_CurrentDirection = Rotor.getDirection();			// Get actual direction form rotor
+	Display.setCurrentDirection(_CurrentDirection);		// Send actual direction to LED display
+}
+
+void PE1MEW_RotorController::RunDebug(void)
+{
+		Display.showLedClear();
+		Display.showLedColor(0,RED);
+		
+		// Do something every second
+		if (_debugCounter == 100)
+		{
+			// Put someting to do here
 			
-		case SYNCFINISH:
-			Steering.initialize(_NextDirection);
-			_RunState = NORMAL;
-			break;
+			_debugCounter = 0;
+		}
+		_debugCounter++;
 		
-		default:
-			break;
-	}
+		// Do something once
+		if (_bMemory1)
+		{
+			// Put someting to do here
+
+			_bMemory1 = false;
+		}
 }
 
-void PE1MEW_RotorController::SyncStep1(void)
+void PE1MEW_RotorController::BrightnessProcess(void)
 {
-	if(_FunctionMemory)
+	if(_SetBrightIncrement)
 	{
-		Rotor.Process();
-		Display.Process();
-		Steering.Process();
-		
-		Display.setRotorRunning(false);
-		
-		Rotor.setDirection(_NextDirection);					// Set rotor with target direction
-		_CurrentDirection = Rotor.getDirection();			// Get actual direction form rotor
-		Display.setCurrentDirection(_CurrentDirection);		// Send actual direction to LED display
+		if (_Brightness < 254)
+		{
+			_Brightness++;
+		}
+		else
+		{
+			_SetBrightIncrement = false;
+		}
 	}
-	
-	// Read state from buttons
-	switch (Steering.getButtons())
+	else
 	{
-		case BUTTON_NONE:
-			_FunctionMemory = true;
-			_NextDirection = 0;								// Set CCW to 0
-			break;
-			
-		case BUTTON_BOTH:
-			_SynchronizationState=SYNCFINISH;
-			_FunctionMemory = false;
-			break;
-		
-		default:
-			if(_FunctionMemory && !Rotor.getIsRotorRunning())
-			{
-				_SynchronizationState++;
-				_FunctionMemory = false;
-			}
-			if(!_FunctionMemory)
-			{
-				Display.showLedClear();
-				Display.showLedBrightness(_Brightness);
-				Display.showLedColor(0,BLUE);	// Indicate testing process
-			}
-			break;
+		if (_Brightness > 1)
+		{
+			_Brightness--;
+		}
+		else
+		{
+			_SetBrightIncrement = true;
+		}
 	}
 }
 
-void PE1MEW_RotorController::SyncStep2(void)
+void PE1MEW_RotorController::TCS1Process(void)
 {
-	if(_FunctionMemory)
+	if (_rainbowCycleJ < LEDCOUNT)
 	{
-		Rotor.Process();
-		Display.Process();
-		Steering.Process();
-		
-		Display.setRotorRunning(false);
-		
-		Rotor.setDirection(_NextDirection);					// Set rotor with target direction
-		_CurrentDirection = Rotor.getDirection();			// Get actual direction form rotor
-		Display.setCurrentDirection(_CurrentDirection);		// Send actual direction to LED display
+		Display.setLedColor(_rainbowCycleJ, TCS1Rainbow(((_rainbowCycleI * 256 / LEDCOUNT) + _rainbowCycleJ) & 255));
+		Display.showLed();
+		_rainbowCycleJ++;
 	}
-	
-	// Read state from buttons
-	switch (Steering.getButtons())
+	else
 	{
-		case BUTTON_NONE:
-			_FunctionMemory = true;
-			_NextDirection = 360;							// Set CCW to 0
-			break;
+		_rainbowCycleJ = 0;
+	}
+	_rainbowCycleI++;
+}
 
-		case BUTTON_BOTH:
-			_SynchronizationState=SYNCFINISH;
-			_FunctionMemory = false;
-			break;
-		
-		default:
-			if(_FunctionMemory && !Rotor.getIsRotorRunning())
-			{
-				_SynchronizationState++;
-				_FunctionMemory = false;
-			}
-			break;
+/*
+Input a value 0 to 255 to get a color value.
+The colours are a transition r - g - b - back to r.
+copied form Aruino neopixel driver code
+*/
+
+uint32_t PE1MEW_RotorController::TCS1Rainbow(byte WheelPos) 
+{
+	WheelPos = 255 - WheelPos;
+	if(WheelPos < 85) 
+	{
+		return ((uint32_t)(255 - WheelPos * 3) << 16) | ((uint32_t)0 <<  8) | WheelPos * 3;
+	}
+	if(WheelPos < 170) 
+	{
+		WheelPos -= 85;
+		return ((uint32_t)0 << 16) | ((uint32_t)(WheelPos * 3) <<  8) | (255 - WheelPos * 3);
 	}
-}
\ No newline at end of file
+	WheelPos -= 170;
+	return ((uint32_t)(WheelPos * 3) << 16) | ((uint32_t)(255 - WheelPos * 3) <<  8) | 0;
+}
@@ -18,6 +18,33 @@
  /// \date 20-7-2016
  /// \author Remko Welling (PE1MEW)
  /// \version 1.0
+ /// \version 1.1	Directions in tenths of degrees, added serial commands.
+ /// \version 1.2	Added RAM monitor.
+ /// \version 1.3	Added getters for the simulator.
+ /// \version 1.4	Added steering profile and deadband settings.
+ /// \version 1.5	Added input recorder.
+ /// \version 1.6	Added Process() path markers for the cycle benchmark.
+ /// \version 1.7	Added position sensor.
+ /// \version 1.8	Added linearisation table of the position sensor.
+ /// \version 1.9	Runtime adapted from moves between the end stops.
+ /// \version 1.10	Added re-synchronisation settings.
+ /// \version 1.11	Added motor current sensor and automatic calibration.
+ /// \version 1.12	Added journal of the direction and power warning.
+ /// \version 1.13	Added move log.
+ /// \version 1.14	Added maintenance counters.
+ /// \version 1.15	Added watchdog.
+ /// \version 1.16	Added commit delay of the next direction.
+ /// \version 1.17	Added rotary encoder.
+ /// \version 1.18	Switch of the rotary encoder on A2.
+ /// \version 1.19	Added tick budget.
+ /// \version 1.20	EEPROM self-test in the background, result in test mode and by serial command.
+ /// \version 1.21	Debug logger.
+ /// \version 1.22	Reports that wait for the tick budget latched in _PendingReports.
+ /// \version 1.23	Jam and calibration notices sent as reports, not during a binary export.
+ /// \version 1.24	Commit delay of the next direction set to COMMIT_DELAY.
+ /// \version 1.25	Display layers DISPLAY_LAYERS, preset directions set by the serial command P.
+ /// \version 1.26	Added getExporting(), no reports or log messages during the export of the input recording.
+ /// \version 1.27	TICKBUDGET plans from the tick measured by WATCHDOG.
 
 #ifndef PE1MEW_ROTORCONTROLLER_H
 #define PE1MEW_ROTORCONTROLLER_H
@@ -26,6 +53,76 @@
 #include "pe1mew_displaycontrol.h"
 #include "pe1mew_rotorsteering.h"
 #include "pe1mew_memorycontrol.h"
+#include "pe1mew_serialcontrol.h"
+#include "pe1mew_rammonitor.h"
+#include "pe1mew_inputrecorder.h"
+#include "pe1mew_movelog.h"
+#include "pe1mew_maintenance.h"
+#include "pe1mew_watchdog.h"
+#include "pe1mew_tickbudget.h"
+#include "pe1mew_debuglog.h"
+#include "pe1mew_positionsensor.h"
+#include "pe1mew_currentsensor.h"
+
+/// \brief Comment out to remove the input recorder and the serial command R.
+/// The recorder uses RECORDER_SIZE + 22 bytes of RAM.
+#define INPUTRECORDER
+
+/// \brief Comment out to remove the move log and the serial command L.
+/// The log uses EEPROM from LOG_START and 34 bytes of RAM.
+#define MOVELOG
+
+/// \brief Comment out to remove the relay cycle counters and motor hour meter and the serial command W.
+/// The counters use EEPROM from MAINTENANCE_START and 38 bytes of RAM.
+#define MAINTENANCECOUNTER
+
+/// \brief Comment out to remove the watchdog and the serial command T.
+/// After a watchdog reset the watchdog keeps running: the bootloader shall stop it, as Optiboot does.
+#define WATCHDOG
+
+/// \brief Comment out to remove the tick budget and the serial command B.
+/// The frame, the EEPROM bytes and the serial reports run in the ticks that have time for them, and
+/// the direction saved at the end of a move is written one byte at a time. Needs WATCHDOG, that measures the tick.
+#define TICKBUDGET
+
+/// \brief Uncomment to mark every Process() call in GPIOR0 and GPIOR1 for the cycle benchmark
+/// in Arduino/Benchmark. The benchmark build script defines it on the command line.
+//#define CYCLEBENCHMARK
+
+/// \brief Uncomment when a rotary encoder with push switch is connected to pin 8, 9 and A2 next to the buttons.
+/// Detents turned fast take larger steps, with the push switch held a detent steps 10 degrees.
+//#define ROTARYENCODER
+
+/// \brief Uncomment when the rotor has a feedback potentiometer on A0.
+/// The direction is then measured at each tick instead of counted from the runtime.
+//#define POSITIONSENSOR
+
+/// \brief Uncomment when the current of the motor is measured on A1, see pe1mew_currentsensor.h.
+/// A stall at an end stop or by a jam stops the rotor and the serial command C calibrates the runtime.
+//#define CURRENTSENSOR
+
+/// \brief Uncomment when a divider from the unregulated supply is connected to AIN1 (pin 7).
+/// The analog comparator interrupts when it drops below the 1.1 V bandgap and the direction is written
+/// in the journal at once. The supply shall hold up the controller for 20 mS after the warning.
+//#define POWERWARNING
+
+#if defined(POSITIONSENSOR) && defined(CURRENTSENSOR)
+#error "POSITIONSENSOR and CURRENTSENSOR both use the ADC in free running mode"
+#endif
+
+#if defined(TICKBUDGET) && !defined(WATCHDOG)
+#error "TICKBUDGET plans from the tick measured by WATCHDOG"
+#endif
+
+static const uint8_t RUNTIME_GAIN_SHIFT = 2;		///< A measured runtime corrects the runtime by 1/4 of the difference.
+static const uint8_t RUNTIME_STEP_SHIFT = 6;		///< Largest correction by one measurement, 1/64 of the runtime.
+static const uint8_t RUNTIME_OUTLIER_SHIFT = 3;		///< Measurements that differ more than 1/8 of the runtime are ignored.
+static const uint8_t RUNTIME_SAVE_SHIFT = 8;		///< The runtime is written in EEPROM when it differs 1/256 from the saved runtime.
+static const uint8_t WATCHDOG_MOTOR_SHIFT = 1;		///< In normal operation the motor does not run longer than twice the runtime at once.
+static const uint8_t COMMIT_DELAY = 100;			///< Ticks a next direction shall be stable before the rotor stops at it, 0 is off, see PE1MEW_RotorControl::setCommitDelay().
+static const uint8_t DISPLAY_LAYERS = LAYER_DEFAULT | LAYER_CARDINAL | LAYER_PRESET;	///< eDisplayLayer flags of the layers shown on the compass card in normal operation.
+static const uint8_t REPORT_LENGTH = 96;			///< Longest answer of a serial report command in characters.
+static const uint8_t JOURNAL_INTERVAL = 100;		///< Ticks between the journal entries while the rotor turns, 64 entries of 1 S wear the EEPROM in 1700 hours of turning.
 
 /// \brief states in which the rotor controller can operate.
 enum eRunState { NORMAL = 0,		///< Normal operation
@@ -33,29 +130,107 @@ enum eRunState { NORMAL = 0,		///< Normal operation
 				 SYNCHRONIZE,		///< Synchronize mode: synchronize rotor unit and Rotor Controller
 				 TEST_CALIBRATE };	///< Test and calibration mode
 
-/// \brief states for Test and Calibration Mode
-/// \todo modify to move sync to separate enum and mode.
-enum eTestCalState { TCSINIT = 0,
-					 TCS1,			///< Test leds
-					 TCS2,			///< Test Switches
-					 TCS3,			///< Test Relays
-					 TCS4,			///< Calibrate Rotor: set CCW until stop
-					 TCS5,			///< Rotate CW until stop 
-					 TCS6,			///< Rotate CCW until stop
-					 TCS7,			///< Rotate CCW until stop
-					 TCSFINISH		///< Save rotor calibration and exit to normal operation
-					 };
-
-/// \brief states for synchronising rotor controller and unit
-enum eSyncState { SYNCINIT = 0,		///< Calibrate Rotor: set CCW until stop
-				  SYNC1,            ///< Rotate CW until stop 
-				  SYNC2,            ///< Rotate CCW until stop
-				  SYNCFINISH};		///< End mode.
-
-/// \brief states for set brightness mode
-enum eSetBrightState { SBINIT = 0,	///< Make preparations for setting brightness
-					   SB,			///< Set brightness
-					   SBFINISH };	///< Save set brightness and exit to normal operation
+/// \brief steps of the automatic calibration by serial command C.
+enum eAutoCalibration { AUTO_OFF = 0,	///< No calibration
+						AUTO_CCW,		///< Search the CCW end stop
+						AUTO_CW };		///< Measure the runtime to the CW end stop
+
+/// \brief states of the modes Set brightness, Synchronize and Test and calibration.
+/// Each state has its rows in the transition table in pe1mew_rotorcontroller.cpp.
+enum eModeState { MODE_EXIT = 0,	///< Leave mode and continue in normal operation
+				  SBINIT,			///< Make preparations for setting brightness
+				  SB,				///< Set brightness
+				  SBFINISH,			///< Save set brightness and exit to normal operation
+				  SYNCINIT,			///< Prepare synchronization
+				  SYNC1,			///< Rotate CCW until stop
+				  SYNC2,			///< Rotate CW until stop
+				  SYNCFINISH,		///< End mode.
+				  TCSINIT,			///< Prepare test and calibration
+				  TCS1,				///< Test leds
+				  TCS2,				///< Test Switches
+				  TCS3,				///< Test Relays
+				  TCS4,				///< Test memory
+				  TCS5,				///< Calibrate Rotor: rotate CW until stop
+				  TCS6,				///< Rotate CCW until stop and measure time
+				  TCS7,				///< Save rotor calibration and exit to normal operation
+				  MODE_SAME = 0xFF	///< Next state in a transition: stay in the current state
+				  };
+
+/// \brief events in the transition table next to the eButtonState values.
+enum eModeEvent { EVENT_TICK = 0x10 };	///< Row is executed at every sys tick before the buttons are evaluated.
+
+/// \brief conditions that shall be met to execute a row of the transition table.
+enum eModeGuard { GUARD_ALWAYS = 0,		///< No condition
+				  GUARD_MEMORY,			///< _FunctionMemory is set
+				  GUARD_NOMEMORY,		///< _FunctionMemory is not set
+				  GUARD_STOPPED };		///< _FunctionMemory is set and the rotor is not running
+
+/// \brief notices of the controller on the serial port, sent as a report in a later tick.
+enum eNotice { NOTICE_JAMMED = 0x01,				///< "jammed"
+			   NOTICE_CALIBRATION_FAILED = 0x02,	///< "calibration failed"
+			   NOTICE_RUNTIME = 0x04 };				///< "runtime <ticks>" of the automatic calibration
+
+/// \brief update of _FunctionMemory when a row of the transition table is executed.
+enum eModeMemory { MEMORY_KEEP = 0,		///< Leave _FunctionMemory unchanged
+				   MEMORY_SET,			///< Set _FunctionMemory
+				   MEMORY_CLEAR };		///< Clear _FunctionMemory
+
+/// \brief actions in the transition table. See RunModeAction() for the implementation.
+enum eModeAction { ACTION_NONE = 0,			///< No action
+				   ACTION_SHOW_BRIGHTNESS,	///< Show leds at _Brightness
+				   ACTION_BRIGHTNESS_START,	///< Start setting brightness at 200
+				   ACTION_BRIGHTNESS_STEP,	///< Step brightness up or down
+				   ACTION_BRIGHTNESS_SAVE,	///< Save brightness to memory and display
+				   ACTION_RAINBOW,			///< Show next rainbow color
+				   ACTION_RELAY1,			///< Activate relay 1
+				   ACTION_RELAY2,			///< Activate relay 2
+				   ACTION_RELAYS_REST,		///< Release both relays
+				   ACTION_MEMORY_TEST,		///< Start the write test of the memory
+				   ACTION_MEMORY_RESULT,	///< Show the result of the memory test when it has finished
+				   ACTION_ROTATE_CW,		///< Turn rotor CW
+				   ACTION_ROTATE_STOP,		///< Stop rotor
+				   ACTION_ROTATE,			///< Rotate to _NextDirection and show current direction
+				   ACTION_CALIBRATE_START,	///< Start measuring time from 360 to 0 degrees
+				   ACTION_CALIBRATE_STOP,	///< Stop measuring time
+				   ACTION_CALIBRATE_SAVE,	///< Save measured time to memory and rotor control
+				   ACTION_SYNC_CCW,			///< Set _NextDirection to 0 degrees
+				   ACTION_SYNC_CW,			///< Set _NextDirection to 360 degrees
+				   ACTION_SYNC_FINISH };	///< Set steering to _NextDirection
+
+/// \brief led patterns in the transition table. See ledPatterns in pe1mew_rotorcontroller.cpp.
+enum eLedPattern { PATTERN_ROW = 0,			///< No pattern, or in the return value of RunModeAction() the pattern of the row
+				   PATTERN_SB_START,		///< Led 0 white
+				   PATTERN_SYNC_START,		///< Led 0 blue
+				   PATTERN_TCS1_START,		///< Led 1 blue
+				   PATTERN_TCS2_START,		///< Led 1 green, leds 0, 2, 3 blue
+				   PATTERN_SWITCH1_ON,		///< Led 2 green
+				   PATTERN_SWITCH2_ON,		///< Led 3 green
+				   PATTERN_SWITCH_OFF,		///< Leds 2, 3 blue
+				   PATTERN_TCS3_START,		///< Leds 2 - 5 blue
+				   PATTERN_RELAY1_ON,		///< Led 4 green
+				   PATTERN_RELAY2_ON,		///< Led 5 green
+				   PATTERN_RELAY_OFF,		///< Leds 4, 5 blue
+				   PATTERN_TCS4_START,		///< Leds 4 - 6 blue
+				   PATTERN_MEMORY_OK,		///< Led 6 green
+				   PATTERN_MEMORY_FAIL,		///< Led 6 red
+				   PATTERN_TCS5_START,		///< Leds 6, 7 blue
+				   PATTERN_ROTATE,			///< Led 7 red
+				   PATTERN_STOP,			///< Led 7 blue
+				   PATTERN_TCS7_START };	///< Leds 0 - 6 blue, led 7 green
+
+/// \brief row of the transition table of the modes.
+/// A row is executed when the controller is in \p state, \p event occurs and \p guard is met.
+/// Executing a row runs \p action, updates _FunctionMemory, shows \p pattern and moves to \p next.
+struct sModeTransition
+{
+	uint8_t state;		///< eModeState in which the row is valid
+	uint8_t event;		///< eButtonState or EVENT_TICK
+	uint8_t guard;		///< eModeGuard condition
+	uint8_t action;		///< eModeAction to execute
+	uint8_t memory;		///< eModeMemory update of _FunctionMemory
+	uint8_t pattern;	///< eLedPattern to show
+	uint8_t next;		///< eModeState after the row is executed
+};
 
 /// \class PE1MEW_RotorController
 /// \brief Main controller class.
@@ -74,39 +249,148 @@ public:
 	/// - Display controller, Controls the display of the rotor
 	/// - Steering controller, reads buttons
 	void Process(void);
+	
+	/// \brief get the direction of the antenna as registered by the rotor controller.
+	/// \return direction in tenths of degrees.
+	uint16_t getCurrentDirection(void){return _CurrentDirection;}
+	
+	/// \brief get the state of the rotor motor.
+	/// \return true = running, false = stop.
+	bool getRotorRunning(void){return _RotorRunning;}
+	
+	/// \brief get the state in which the rotor controller operates.
+	/// \return state as eRunState.
+	uint8_t getRunState(void){return _RunState;}
+
+	/// \brief get the runtime used by the rotor control.
+	/// \return runtime in ticks per 360 degrees.
+	uint16_t getRunTime(void){return _RunTimeCounter;}
+
+	/// \brief get the next direction set by the buttons or a serial command.
+	/// \return direction in tenths of degrees.
+	uint16_t getNextDirection(void){return _NextDirection;}
+
+#ifdef POSITIONSENSOR
+	/// \brief set the linearisation table of the feedback potentiometer.
+	/// \param table table in flash, see PE1MEW_PositionSensor::setTable().
+	void setSensorTable(const sSensorTable* table){Sensor.setTable(table);}
+
+	/// \brief set the variance of the direction measured by the feedback potentiometer.
+	/// \param variance see PE1MEW_PositionSensor::setVariance().
+	void setSensorVariance(uint16_t variance){Sensor.setVariance(variance);}
+
+	/// \brief get the direction measured by the position sensor alone.
+	/// \return direction in tenths of degrees.
+	uint16_t getSensorDirection(void){return Sensor.getDirection();}
+#endif
+
+	/// \brief get the certainty of the direction.
+	/// \return true after a jam, until the rotor is synchronised at an end stop.
+	bool getUncertain(void){return Rotor.getUncertain();}
+
+#ifdef WATCHDOG
+	/// \brief start the watchdog, at the end of setup().
+	/// \param resetCause MCUSR at the start, see PE1MEW_Watchdog::Initialize().
+	void startWatchdog(uint8_t resetCause){Watchdog.Initialize(resetCause);}
+#endif
+
+#ifdef POWERWARNING
+	/// \brief release the relays and write the direction in the journal at once.
+	/// Called by the analog comparator interrupt when the supply drops.
+	void powerFail(void);
+#endif
+
+#ifdef CURRENTSENSOR
+	/// \brief get the step of the automatic calibration.
+	/// \return step as eAutoCalibration.
+	uint8_t getAutoCalibration(void){return _AutoCalibration;}
+#endif
+
+#ifdef CYCLEBENCHMARK
+	/// \brief get the path Process() takes at the next sys tick.
+	/// \return eRunState in bit 7-5, in normal operation the rotor running in bit 0, else the eModeState in bit 4-0.
+	uint8_t getProcessPath(void){return (_RunState << 5) | ((_RunState == NORMAL) ? (uint8_t)_RotorRunning : _ModeState);}
+#endif
+
+	/// \brief select the timing of the buttons.
+	/// \param profile steering profile in flash, see PE1MEW_RotorSteering::setProfile().
+	void setSteeringProfile(const sSteeringProfile* profile){Steering.setProfile(profile);}
+
+	/// \brief set the deadband in which the rotor is not started.
+	/// \param deadband in tenths of degrees.
+	void setDeadband(uint8_t deadband){Rotor.setDeadband(deadband);}
+
+	/// \brief set the time the next direction shall be stable before the rotor stops at it.
+	/// \param ticks commit delay, 0 stops the rotor at every step of the buttons.
+	void setCommitDelay(uint8_t ticks){Rotor.setCommitDelay(ticks);}
+
+	/// \brief set the re-synchronisation at the end stops.
+	/// \param travel degrees, 0 disables the re-synchronisation.
+	/// \param overdrive ticks, see PE1MEW_RotorControl::setResync().
+	void setResync(uint16_t travel, uint16_t overdrive){Rotor.setResync(travel, overdrive);}
 
 private:
     PE1MEW_RotorControl Rotor = PE1MEW_RotorControl();			///< Rotor control object controls the rotor trough relays.
     PE1MEW_DisplayControl Display = PE1MEW_DisplayControl();	///< Display control object controls the Neopixel leds of the compass card
 	PE1MEW_RotorSteering Steering = PE1MEW_RotorSteering();		///< Object that control the switches (buttons)
 	PE1MEW_MemoryControl Memory = PE1MEW_MemoryControl();		///< Memory object for all memory operation. is not included in sys tick.
+	PE1MEW_SerialControl Terminal = PE1MEW_SerialControl();		///< Serial command object, reads commands from the serial port.
+	PE1MEW_RamMonitor Ram = PE1MEW_RamMonitor();				///< RAM monitor object, reports free RAM and stack peak.
+#ifdef POSITIONSENSOR
+	PE1MEW_PositionSensor Sensor = PE1MEW_PositionSensor();	///< Measures the direction with the feedback potentiometer.
+#endif
+#ifdef CURRENTSENSOR
+	PE1MEW_CurrentSensor Current = PE1MEW_CurrentSensor();		///< Detects a stalled rotor from the motor current.
+#endif
+#ifdef INPUTRECORDER
+	PE1MEW_InputRecorder Recorder = PE1MEW_InputRecorder();	///< Records the inputs and relays for replay in the simulator.
+#endif
+#ifdef MOVELOG
+	PE1MEW_MoveLog Log = PE1MEW_MoveLog();						///< Logs the completed moves in EEPROM.
+#endif
+#ifdef MAINTENANCECOUNTER
+	PE1MEW_MaintenanceCounter Maintenance = PE1MEW_MaintenanceCounter();	///< Counts the relay cycles and the motor hours.
+#endif
+#ifdef WATCHDOG
+	PE1MEW_Watchdog Watchdog = PE1MEW_Watchdog();				///< Resets the controller when a tick does not end healthy.
+#endif
+#ifdef TICKBUDGET
+	PE1MEW_TickBudget Budget = PE1MEW_TickBudget();			///< Plans the expensive tasks of a tick.
+#endif
 
 	// General variables
 	uint8_t _RunState;
+	uint8_t _ModeState;					///< eModeState of the running mode, not used in normal operation.
 	uint8_t _Brightness;
 	bool	_FunctionMemory;
+	bool	_EepromReport;				///< Report the EEPROM health when the write test has finished.
+	uint8_t _Notices;					///< eNotice bits of the notices that wait for a tick with time.
+	uint8_t _PresetIndex;				///< Preset of the display set by the next serial command P.
+	uint8_t _PendingReports;			///< Bits of the report commands in REPORT_COMMANDS that wait for a tick with time, see getReportAllowed().
+#ifdef CURRENTSENSOR
+	uint8_t _AutoCalibration;			///< eAutoCalibration step of the automatic calibration.
+#endif
 	
 	/// Normal running state variables
-	uint16_t _CurrentDirection;			///< Temporary variable for the exchange between rotor control and display control
-	uint16_t _NextDirection;			///< Temporary variable for the exchange between rotor control and display control
+	uint16_t _CurrentDirection;			///< Temporary variable for the exchange between rotor control and display control in tenths of degrees
+	uint16_t _NextDirection;			///< Temporary variable for the exchange between rotor control and display control in tenths of degrees
 	bool	 _RotorRunning;				///< Temporary variable for the exchange between rotor control and display control
 	uint16_t _RunTimeCounter;			///< Temporary variable to keep value in initialization and calibration process.
+	uint8_t  _JournalCounter;			///< Ticks the rotor turned since the last journal entry.
+#ifdef WATCHDOG
+	uint16_t _MotorTicks;				///< Ticks the motor runs without a stop in normal operation.
+#endif
+#ifdef POWERWARNING
+	volatile uint16_t _PowerFailDirection;	///< Direction of the last tick for powerFail(), written atomically.
+#endif
 
 	// Test and Calibration state variables
-	uint8_t  _TestCalibrationState;		///< variable to keep track of the test and calibration process.
 	uint16_t _rainbowCycleI;			///< \todo revise?
 	uint16_t _rainbowCycleJ;
 	
-	// Synchronization variables
-	uint8_t _SynchronizationState;
-	
 	// Set brightness state variables
-	uint8_t _SetBrightnessState;		///< variable to keep track of the test and set brightness process.
 	bool	_SetBrightIncrement;		///< variable to keep register in- or decrement of the brightness setting.
 	
-	// Memory test variables
-	bool _MemorytestOnce;
-	
 	// Debug running state variables
 	int _debugCounter = 0;				///< \todo shall be removed
 	bool _bMemory1 = true;				///< \todo shall be removed
@@ -117,29 +401,76 @@ private:
 
 	/// \brief all functions to be executed at sys tick interval in Normal mode
 	void RunNormal(void);
+
+	/// \brief correct the runtime with the runtime measured by a move between the end stops.
+	/// \param runtime measured runtime in ticks, 0 when nothing was measured.
+	void adaptRunTime(uint16_t runtime);
+
+	/// \brief the end stop detector found the rotor stalled, at an end stop or jammed.
+	void processStall(void);
+
+#ifdef CURRENTSENSOR
+	/// \brief save the runtime measured by the automatic calibration.
+	/// \param runtime measured runtime in ticks, 0 when the calibration failed.
+	void finishAutoCalibration(uint16_t runtime);
+#endif
+
+#ifdef WATCHDOG
+	/// \brief check the state of the controller at the end of a tick.
+	/// \return false when the state is invalid or the motor runs too long in normal operation.
+	bool getHealthy(void);
+#endif
 	
-	/// \brief all functions to be executed at sys tick interval  in set brightness mode
-	void RunSetBrightness(void);
-	/// \brief helper function in set brightness mode for state SB
-	void BrightnessProcess(void);
-		 
-	/// \brief all functions to be executed at sys tick interval for synchronizing
-	void RunSynchronize(void);
-	void SyncStep1(void);
-	void SyncStep2(void);
+	/// \brief write the queued bytes of the memory object.
+	/// \return true when a byte was written in this tick.
+	bool ProcessMemory(void);
+	
+	/// \brief tell if the log or the counters may write a byte in this tick.
+	/// \param pending the log or the counters have a byte to write.
+	/// \param written a byte was written in this tick.
+	bool getWriteAllowed(bool pending, bool written);
+	
+	/// \brief tell if the move log or the input recording is exported on the serial port.
+	bool getExporting(void);
+	
+	/// \brief tell if a report may be sent on the serial port in this tick.
+	/// Not during an export, with TICKBUDGET when the budget has time for it.
+	bool getReportAllowed(void);
+	
+	/// \brief send the notices in _Notices when a report is allowed.
+	void sendNotices(void);
 	
+	/// \brief execute a command received by the serial port in Normal mode
+	void ProcessCommand(void);
 	
-	/// \brief all functions to be executed at sys tick interval for test and calibration
-	void RunTestCalibrate(void);
-	void TCSINITProcess(void);
+	/// \brief all functions to be executed at sys tick interval in set brightness, synchronize and
+	/// test and calibration mode.
+	/// Interpreter of the transition table: first all EVENT_TICK rows of the current state are executed,
+	/// then the first row that matches the buttons.
+	void RunMode(void);
+	
+	/// \brief execute a row of the transition table.
+	/// \param transition row copied from the transition table.
+	void RunModeTransition(const sModeTransition& transition);
+	
+	/// \brief execute an action of the transition table.
+	/// \param action eModeAction to execute.
+	/// \return eLedPattern to show instead of the pattern of the row, PATTERN_ROW to show the pattern of the row.
+	uint8_t RunModeAction(uint8_t action);
+	
+	/// \brief show a led pattern from flash on the display.
+	/// \param pattern eLedPattern to show.
+	void showPattern(uint8_t pattern);
+	
+	/// \brief helper function in set brightness mode to step brightness up and down.
+	void BrightnessProcess(void);
+	
+	/// \brief helper function in test and calibration mode to show the next color of a rainbow.
 	void TCS1Process(void);
 	uint32_t TCS1Rainbow(byte WheelPos);
-	void TCS2Process(void);
-	void TCS3Process(void);
-	void TCS4Process(void);
-	void TCS5Process(void);
-	void TCS6Process(void);
-	void TCS7Process(void);
+	
+	/// \brief helper function for rotation in test and calibration and in synchronize mode.
+	void RotateProcess(void);
 
 	void RunDebug(void);
 
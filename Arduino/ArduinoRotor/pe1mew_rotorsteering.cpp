@@ -19,12 +19,35 @@
  /// \author Remko Welling (PE1MEW)
  /// \version 1.0
  /// \version 1.1 changed buttons CW and CCW
+ /// \version 1.2 Directions in tenths of degrees.
+ /// \version 1.3 Speed step thresholds taken from a steering profile in flash.
+ /// \version 1.4 Rotary encoder.
 
 #include "pe1mew_rotorsteering.h"
 
 #include "Arduino.h"
+#include <avr/pgmspace.h>
+
+#ifdef __AVR__
+#include <util/atomic.h>
+#endif
+
+const sSteeringProfile STEERING_PROFILE_DEFAULT PROGMEM =
+{
+	{PRESS_COUNTER_TRESHOLD1, PRESS_COUNTER_TRESHOLD2, PRESS_COUNTER_TRESHOLD3, PRESS_COUNTER_TRESHOLD4},
+	{PRESS_COUNTER_STEP1_TRESHOLD, PRESS_COUNTER_STEP2_TRESHOLD, PRESS_COUNTER_STEP3_TRESHOLD, PRESS_COUNTER_STEP4_TRESHOLD},
+	INCREMENT_DEFAULT
+};
+
+/// \brief edges by the levels of output A and B, index is the previous levels in bit 3-2 and the new in bit 1-0.
+/// CW is A before B: 00, 01, 11, 10.
+static const int8_t ENCODER_TRANSITIONS[16] PROGMEM = { 0, 1, -1, 0, -1, 0, 0, 1, 1, 0, 0, -1, 0, -1, 1, 0 };
+
+ENCODER_SHARED uint8_t PE1MEW_RotorSteering::_EncoderLevels = 0;
+ENCODER_SHARED int8_t  PE1MEW_RotorSteering::_EncoderEdges = 0;
 
 PE1MEW_RotorSteering::PE1MEW_RotorSteering():
+	_Profile(&STEERING_PROFILE_DEFAULT),
 	_ProcessVariableIncrement(INCREMENT_DEFAULT),
 	_NextDirection(0),
 	_CurrentButtonSpeedState(STEP1),
@@ -32,7 +55,9 @@ PE1MEW_RotorSteering::PE1MEW_RotorSteering():
 	_SpeedStateCounter(0),
 	_ButtonSpeedHoldCounter(0),
 	_PressMemory(false),
-	_PressCounter(PRESS_COUNTER_MAX)
+	_PressCounter(PRESS_COUNTER_MAX),
+	_Encoder(false),
+	_EncoderRate(0)
 {
 	initialize();
 }
@@ -50,10 +75,50 @@ void PE1MEW_RotorSteering::initialize(uint16_t direction)
 	_NextDirection = direction;
 }
 
+void PE1MEW_RotorSteering::setProfile(const sSteeringProfile* profile)
+{
+	_Profile = profile;
+	_ProcessVariableIncrement = pgm_read_byte(&_Profile->increment);
+}
+
+void PE1MEW_RotorSteering::initializeEncoder(void)
+{
+	pinMode(ENCODER_A_PIN, INPUT_PULLUP);
+	pinMode(ENCODER_B_PIN, INPUT_PULLUP);
+	pinMode(ENCODER_SWITCH_PIN, INPUT_PULLUP);
+	
+	_EncoderLevels = ((digitalRead(ENCODER_A_PIN) == HIGH) ? 0x01 : 0x00) | ((digitalRead(ENCODER_B_PIN) == HIGH) ? 0x02 : 0x00);
+	_EncoderEdges = 0;
+	_EncoderRate = 0;
+	_Encoder = true;
+	
+#ifdef __AVR__
+	PCMSK0 |= (1 << PCINT0) | (1 << PCINT1);
+	PCIFR = (1 << PCIF0);
+	PCICR |= (1 << PCIE0);
+#endif
+}
+
+void PE1MEW_RotorSteering::addEncoderEdge(uint8_t levels)
+{
+	int8_t edge = (int8_t)pgm_read_byte(&ENCODER_TRANSITIONS[(_EncoderLevels << 2) | levels]);
+	
+	if ((edge > 0 && _EncoderEdges < INT8_MAX) || (edge < 0 && _EncoderEdges > INT8_MIN))
+	{
+		_EncoderEdges += edge;
+	}
+	_EncoderLevels = levels;
+}
+
 void PE1MEW_RotorSteering::Process(void)
 {
 	// test for button press
 	buttonTest();
+	
+	if (_Encoder)
+	{
+		encoderTest();
+	}
 }
 
 void PE1MEW_RotorSteering::buttonTest(void)
@@ -78,88 +143,31 @@ void PE1MEW_RotorSteering::buttonTest(void)
 			_ButtonSpeedHoldCounter++;		
 		}
 		
-		switch (_CurrentButtonSpeedState)
+		// Each speed step waits holdTicks between increments and takes stepCount increments
+		// before going to the next, faster, step. The last step is kept while a button is held.
+		if (pgm_read_byte(&_Profile->holdTicks[_CurrentButtonSpeedState]) < _ButtonSpeedHoldCounter)
 		{
-			case STEP1:
-				if (PRESS_COUNTER_TRESHOLD1 < _ButtonSpeedHoldCounter)
-				{
-					if (_SpeedStateCounter < PRESS_COUNTER_STEP1_TRESHOLD)
-					{
-						_SpeedStateCounter++;
-					}
-					else
-					{
-						_SpeedStateCounter = 0;
-						_NextButtonSpeedState = STEP2;
-						//_ProcessVariableIncrement = 1;
-					}
-					ProcessButtons(inputVariable);
-					_ButtonSpeedHoldCounter = 0;
-				}
-				break;
-			
-			case STEP2:
-				if (PRESS_COUNTER_TRESHOLD2 < _ButtonSpeedHoldCounter)
-				{
-					if (_SpeedStateCounter < PRESS_COUNTER_STEP2_TRESHOLD)
-					{
-						_SpeedStateCounter++;
-					}
-					else
-					{
-						_SpeedStateCounter = 0;
-						_NextButtonSpeedState = STEP3;
-						//_ProcessVariableIncrement = 1;
-					}
-					ProcessButtons(inputVariable);
-					_ButtonSpeedHoldCounter = 0;
-				}
-				break;
-				
-			case STEP3:
-				if (PRESS_COUNTER_TRESHOLD3 < _ButtonSpeedHoldCounter)
+			if (_SpeedStateCounter < pgm_read_byte(&_Profile->stepCount[_CurrentButtonSpeedState]))
+			{
+				_SpeedStateCounter++;
+			}
+			else
+			{
+				_SpeedStateCounter = 0;
+				if (_CurrentButtonSpeedState < STEP4)
 				{
-					if (_SpeedStateCounter < PRESS_COUNTER_STEP3_TRESHOLD)
-					{
-						_SpeedStateCounter++;
-					}
-					else
-					{
-						_SpeedStateCounter = 0;
-						_NextButtonSpeedState = STEP4;
-						//_ProcessVariableIncrement = 1;
-					}
-					ProcessButtons(inputVariable);
-					_ButtonSpeedHoldCounter = 0;
+					_NextButtonSpeedState = _CurrentButtonSpeedState + 1;
 				}
-				break;
-			
-			case STEP4:
-				if (PRESS_COUNTER_TRESHOLD4 < _ButtonSpeedHoldCounter)
-				{
-					if (_SpeedStateCounter < PRESS_COUNTER_STEP4_TRESHOLD)
-					{
-						_SpeedStateCounter++;
-					}
-					else
-					{
-						_SpeedStateCounter = 0;
-					}
-					ProcessButtons(inputVariable);
-					_ButtonSpeedHoldCounter = 0;
-				}
-				break;
-				
-			default:
-				break;
+			}
+			ProcessButtons(inputVariable);
+			_ButtonSpeedHoldCounter = 0;
 		}
-		
 	}
 	else
 	{
 		_ButtonSpeedHoldCounter = 0;
 		_NextButtonSpeedState = STEP1;
-		_ProcessVariableIncrement = INCREMENT_DEFAULT;
+		_ProcessVariableIncrement = pgm_read_byte(&_Profile->increment);
 	}
 	_CurrentButtonSpeedState = _NextButtonSpeedState;
 }
@@ -204,15 +212,54 @@ void PE1MEW_RotorSteering::ProcessButtons(uint8_t inputVariable)
 	// validation check of input
 	_NextDirection = checkDegreeResult(processVariable);
 }
+
+void PE1MEW_RotorSteering::encoderTest(void)
+{
+	int8_t detents;
+	
+	// Edges of a detent that is not completed are kept, the encoder rests between detents.
+#ifdef __AVR__
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+	{
+		detents = _EncoderEdges / (int8_t)ENCODER_EDGES;
+		_EncoderEdges -= detents * (int8_t)ENCODER_EDGES;
+	}
+	
+	uint8_t count = (detents < 0) ? -detents : detents;
+	
+	// The step is set by the rate before these detents, a single detent after a rest steps ENCODER_INCREMENT.
+	int16_t step = ENCODER_INCREMENT;
+	if (digitalRead(ENCODER_SWITCH_PIN) == LOW)
+	{
+		step = ENCODER_INCREMENT_PUSHED;
+	}
+	else if (_EncoderRate > ENCODER_RATE_THRESHOLD)
+	{
+		uint8_t fast = _EncoderRate - ENCODER_RATE_THRESHOLD;
+		step += ((uint16_t)fast * fast) >> ENCODER_ACCELERATION_SHIFT;
+		step = (step > ENCODER_STEP_MAX) ? ENCODER_STEP_MAX : step;
+	}
+	
+	// The decay is rounded up so the rate returns to 0 at rest.
+	uint16_t rate = _EncoderRate - ((_EncoderRate + (1 << ENCODER_RATE_SHIFT) - 1) >> ENCODER_RATE_SHIFT) + (uint16_t)count * ENCODER_RATE_DETENT;
+	_EncoderRate = (rate > UINT8_MAX) ? UINT8_MAX : rate;
+	
+	if (detents != 0)
+	{
+		_NextDirection = checkDegreeResult((int16_t)_NextDirection + detents * step);
+	}
+}
+
 int16_t PE1MEW_RotorSteering::checkDegreeResult(int16_t degrees)
 {
 	if (degrees < 0)
 	{
 		degrees = 0;
 	}
-	if (360 <= degrees)
+	if (MAX_DIRECTION <= degrees)
 	{
-		degrees = 360;
+		degrees = MAX_DIRECTION;
 	}
 	return degrees;
 }
\ No newline at end of file
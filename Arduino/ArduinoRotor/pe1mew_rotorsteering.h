@@ -18,29 +18,57 @@
  /// \date 20-7-2016
  /// \author Remko Welling (PE1MEW)
  /// \version 1.0
+ /// \version 1.1	Directions in tenths of degrees.
+ /// \version 1.2	Speed step thresholds in a selectable steering profile.
+ /// \version 1.3	Rotary encoder.
+/// \version 1.4	Switch of the rotary encoder moved to A2, pin 10 is SS of the SPI.
 
 #ifndef PE1MEW_ROTORSTEERING_H_H
 #define PE1MEW_ROTORSTEERING_H_H
 
 #include <stdint.h>
 
-static uint8_t SW1_PIN = 2;							///< Pin on which switch 1 is connected
-static uint8_t SW2_PIN = 3;							///< Pin on which switch 2 is connected
-
-static uint8_t INCREMENT_DEFAULT = 4;				///< Default increment step for direction in degrees.
-
-static uint8_t PRESS_COUNTER_MAX = 100;				///< maximum number of steps for the increment counter
-
-/// \brief variables for dynamic increment settings.
-static uint8_t PRESS_COUNTER_TRESHOLD1 = 20;	// n * 1 mS wait before next increment
-static uint8_t PRESS_COUNTER_TRESHOLD2 = 9;
-static uint8_t PRESS_COUNTER_TRESHOLD3 = 3;
-static uint8_t PRESS_COUNTER_TRESHOLD4 = 1;
-
-static uint8_t PRESS_COUNTER_STEP1_TRESHOLD	= 10;
-static uint8_t PRESS_COUNTER_STEP2_TRESHOLD	= 10;
-static uint8_t PRESS_COUNTER_STEP3_TRESHOLD	= 10;
-static uint8_t PRESS_COUNTER_STEP4_TRESHOLD	= 0;
+static const uint8_t SW1_PIN = 2;							///< Pin on which switch 1 is connected
+static const uint8_t SW2_PIN = 3;							///< Pin on which switch 2 is connected
+static const uint8_t ENCODER_A_PIN = 8;						///< Pin of output A of the rotary encoder, PB0 with pin change interrupt PCINT0
+static const uint8_t ENCODER_B_PIN = 9;						///< Pin of output B of the rotary encoder, PB1 with pin change interrupt PCINT1
+static const uint8_t ENCODER_SWITCH_PIN = 16;				///< Pin of the push switch of the rotary encoder, A2, closed to ground
+
+static const uint8_t INCREMENT_DEFAULT = 40;				///< Default increment step for direction in tenths of degrees.
+static const int16_t MAX_DIRECTION = 3600;				///< Maximum direction in tenths of degrees.
+
+static const uint8_t PRESS_COUNTER_MAX = 100;				///< maximum number of steps for the increment counter
+
+/// \brief variables for dynamic increment settings, used by STEERING_PROFILE_DEFAULT.
+static const uint8_t PRESS_COUNTER_TRESHOLD1 = 20;	// n * 10 mS wait before next increment
+static const uint8_t PRESS_COUNTER_TRESHOLD2 = 9;
+static const uint8_t PRESS_COUNTER_TRESHOLD3 = 3;
+static const uint8_t PRESS_COUNTER_TRESHOLD4 = 1;
+
+static const uint8_t PRESS_COUNTER_STEP1_TRESHOLD	= 10;
+static const uint8_t PRESS_COUNTER_STEP2_TRESHOLD	= 10;
+static const uint8_t PRESS_COUNTER_STEP3_TRESHOLD	= 10;
+static const uint8_t PRESS_COUNTER_STEP4_TRESHOLD	= 0;
+
+/// \brief variables of the rotary encoder.
+/// Each detent adds ENCODER_RATE_DETENT to the rate of turning, which decays by 1/16 per tick. The step
+/// above ENCODER_INCREMENT grows with the square of the rate above ENCODER_RATE_THRESHOLD: a detent
+/// turned slower than about 8 per second steps 1 degree, at 15 detents per second about 8 degrees and
+/// from 20 per second ENCODER_STEP_MAX.
+static const uint8_t ENCODER_EDGES = 4;					///< Edges of output A and B per detent
+static const uint8_t ENCODER_INCREMENT = 10;			///< Step per detent turned slowly in tenths of degrees
+static const uint8_t ENCODER_INCREMENT_PUSHED = 100;	///< Step per detent with the push switch held in tenths of degrees
+static const uint8_t ENCODER_STEP_MAX = 200;			///< Largest step per detent in tenths of degrees
+static const uint8_t ENCODER_RATE_DETENT = 32;			///< Rate of turning added by each detent
+static const uint8_t ENCODER_RATE_SHIFT = 4;			///< The rate of turning decays by 1/16 per tick
+static const uint8_t ENCODER_RATE_THRESHOLD = 24;		///< Rate of turning above which the step grows
+static const uint8_t ENCODER_ACCELERATION_SHIFT = 4;	///< Step above ENCODER_INCREMENT is the rate above the threshold squared / 16
+
+#ifdef __AVR__
+#define ENCODER_SHARED volatile		///< Written by the pin change interrupt.
+#else
+#define ENCODER_SHARED thread_local	///< The simulator runs a controller per thread.
+#endif
 
 /// \brief defines states when reading buttons.
 enum eButtonState { BUTTON_NONE = 0x00,		///< No button is pressed
@@ -55,6 +83,18 @@ enum eSetButtonSpeedState { STEP1 = 0,	///< Speed step 1, slowest setting speed
 							STEP3,		///< Speed step 1
 							STEP4 };	///< Speed step 1, fastest setting speed
 
+/// \brief steering profile, the timing of the buttons.
+/// Profiles are placed in flash (PROGMEM) and read with pgm_read_byte().
+struct sSteeringProfile
+{
+	uint8_t holdTicks[STEP4 + 1];	///< Ticks a button is held before the next increment, per speed step
+	uint8_t stepCount[STEP4 + 1];	///< Increments in a speed step before the next speed step is taken
+	uint8_t increment;				///< Increment of the next direction in tenths of degrees
+};
+
+/// \brief default steering profile in flash.
+extern const sSteeringProfile STEERING_PROFILE_DEFAULT;
+
 /// \class PE1MEW_RotorSteering
 /// \brief Rotor steering class
 class PE1MEW_RotorSteering
@@ -63,9 +103,18 @@ public:
 	/// \brief Default constructor
     PE1MEW_RotorSteering();
 	
-	/// \brief Get next direction in degrees from user settings
-	/// \return next direction in degrees.
+	/// \brief Get next direction from user settings
+	/// \return next direction in tenths of degrees.
 	uint16_t getNextDirection(void){return _NextDirection;}
+	
+	/// \brief Set next direction from an other source than the buttons, for example a serial command.
+	/// \param direction in tenths of degrees, limited to 0-3600.
+	void setNextDirection(uint16_t direction){_NextDirection = (direction > (uint16_t)MAX_DIRECTION) ? MAX_DIRECTION : direction;}
+
+	/// \brief select the steering profile.
+	/// The profile is not copied, it shall stay in flash (PROGMEM) for the lifetime of the steering.
+	/// \param profile steering profile, STEERING_PROFILE_DEFAULT at construction.
+	void setProfile(const sSteeringProfile* profile);
 		
 	/// \brief get button state
 	/// This function is not private because it is used as input to the test functions.
@@ -76,21 +125,38 @@ public:
 	/// \brief helper function to initialize variables en calculate values for these variables in the constructor of the classes.
 	/// Overloaded function form the private function Initialize()
 	/// This function is used to initialize the steering control with settings from memory
-	/// \param direction in degrees.
+	/// \param direction in tenths of degrees.
 	void initialize(uint16_t direction);
 			
 	/// \brief at sys tick executed function for housekeeping of the Rotor control.
 	void Process(void);
 
+	/// \brief use a rotary encoder next to the buttons.
+	/// The outputs A and B and the push switch are read with the internal pull-ups. The pin change
+	/// interrupt of A and B is enabled, its ISR shall call addEncoderEdge().
+	void initializeEncoder(void);
+
+	/// \brief add an edge of the rotary encoder, called from the pin change interrupt.
+	/// Edges are decoded by the transition from the previous levels: a bouncing contact adds and removes
+	/// the same edge, a transition of both outputs at once is ignored. The detents are taken at the next tick.
+	/// \param levels level of output A in bit 0 and of output B in bit 1.
+	static void addEncoderEdge(uint8_t levels);
+
 private:
+	const sSteeringProfile* _Profile;		///< Steering profile in flash
 	uint8_t  _ProcessVariableIncrement;		///< Step size at increment of a direction
-	uint16_t _NextDirection;				///< Next direction in degrees
+	uint16_t _NextDirection;				///< Next direction in tenths of degrees
 	uint8_t	 _CurrentButtonSpeedState;		///< Variable for variable speed setting
 	uint8_t  _NextButtonSpeedState;			///< Variable for variable speed setting
 	uint8_t  _SpeedStateCounter;			///< Variable for variable speed setting
 	uint8_t  _ButtonSpeedHoldCounter;		///< Variable for variable speed setting
 	bool	 _PressMemory;					///< Variable for variable speed setting
 	uint8_t  _PressCounter;					///< Variable for variable speed setting
+	bool	 _Encoder;						///< A rotary encoder is used, see initializeEncoder()
+	uint8_t  _EncoderRate;					///< Rate of turning of the rotary encoder, see ENCODER_RATE_SHIFT
+	
+	static ENCODER_SHARED uint8_t _EncoderLevels;	///< Levels of output A and B at the last edge
+	static ENCODER_SHARED int8_t  _EncoderEdges;	///< Edges since the last detent taken, positive CW
 	
 	/// \brief helper function to initialize variables en calculate values for these variables in the constructor of the classes.
 	/// Functions are called that cannot be handled by the C++ default initializers
@@ -103,9 +169,13 @@ private:
 	/// \brief 
 	void	ProcessButtons(uint8_t inputVariable);
 	
-	/// \brief Verify angle to fit between 0 and 360 degrees.
-	/// \param degrees direction in degrees
-	/// \return degrees checked direction in degrees.
+	/// \brief function to take the detents of the rotary encoder and in- or decrement next direction.
+	/// Function executed at sys tick from process() func
+	void	encoderTest(void);
+	
+	/// \brief Verify angle to fit between 0 and 3600 tenths of degrees.
+	/// \param degrees direction in tenths of degrees
+	/// \return degrees checked direction in tenths of degrees.
 	int16_t checkDegreeResult(int16_t degrees);
 
 };
@@ -0,0 +1,174 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_serialcontrol.cpp
+ /// \brief Serial command class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Added command to export the input recording.
+ /// \version 1.2	Added command to calibrate with the current sensor.
+ /// \version 1.3	Added command to export the move log.
+ /// \version 1.4	Added maintenance command.
+ /// \version 1.5	Added watchdog report command.
+ /// \version 1.6	Added tick budget report command.
+ /// \version 1.7	Added EEPROM self-test command.
+ /// \version 1.8	Overlong line dropped by _Overflow, the terminator stays in _Buffer.
+ /// \version 1.9	Preset direction command, ARGUMENT_NONE without an argument.
+
+#include "pe1mew_serialcontrol.h"
+
+#include "Arduino.h"
+
+PE1MEW_SerialControl::PE1MEW_SerialControl():
+	_BufferLength(0),
+	_Overflow(false),
+	_Command(COMMAND_NONE),
+	_Argument(0)
+{
+}
+
+void PE1MEW_SerialControl::Process(void)
+{
+	while (Serial.available() > 0)
+	{
+		char character = (char)Serial.read();
+		
+		if (character == '\r' || character == '\n')
+		{
+			if (_Overflow)
+			{
+				Serial.println("?");		// Line too long, dropped
+			}
+			else if (_BufferLength > 0)
+			{
+				_Buffer[_BufferLength] = '\0';
+				if (!parseLine())
+				{
+					Serial.println("?");	// Report invalid command
+				}
+			}
+			_BufferLength = 0;
+			_Overflow = false;
+		}
+		else if (_BufferLength < COMMAND_BUFFER_SIZE - 1)
+		{
+			_Buffer[_BufferLength++] = character;
+		}
+		else
+		{
+			_Overflow = true;				// Line too long, ignore until end of line.
+		}
+	}
+}
+
+uint8_t PE1MEW_SerialControl::getCommand(void)
+{
+	uint8_t returnValue = _Command;
+	_Command = COMMAND_NONE;
+	return returnValue;
+}
+
+bool PE1MEW_SerialControl::parseLine(void)
+{
+	uint16_t argument = 0;
+	
+	switch (_Buffer[0])
+	{
+		case COMMAND_DIRECTION:
+			if (!parseTenths(&_Buffer[1], argument) || argument > 3600)
+			{
+				return false;
+			}
+			break;
+		
+		case COMMAND_MAINTENANCE:
+			if (_Buffer[1] != '\0' && (!parseTenths(&_Buffer[1], argument) || (argument != 10 && argument != 20)))
+			{
+				return false;
+			}
+			break;
+		
+		case COMMAND_PRESET:
+			if (_Buffer[1] == '\0')
+			{
+				argument = ARGUMENT_NONE;
+			}
+			else if (!parseTenths(&_Buffer[1], argument) || argument > 3600)
+			{
+				return false;
+			}
+			break;
+		
+		case COMMAND_MEMORY:
+		case COMMAND_RECORDING:
+		case COMMAND_CALIBRATE:
+		case COMMAND_LOG:
+		case COMMAND_WATCHDOG:
+		case COMMAND_BUDGET:
+		case COMMAND_EEPROM:
+			if (_Buffer[1] != '\0')
+			{
+				return false;
+			}
+			break;
+		
+		default:
+			return false;
+	}
+	
+	_Command = _Buffer[0];
+	_Argument = argument;
+	return true;
+}
+
+bool PE1MEW_SerialControl::parseTenths(const char* text, uint16_t& value)
+{
+	uint32_t tenths = 0;
+	uint8_t digits = 0;
+	
+	// Integer part
+	while (*text >= '0' && *text <= '9')
+	{
+		tenths = tenths * 10 + (*text++ - '0');
+		if (++digits > 4)
+		{
+			return false;
+		}
+	}
+	tenths *= 10;
+	
+	// Optional decimal, further decimals are ignored
+	if (*text == '.')
+	{
+		text++;
+		if (*text >= '0' && *text <= '9')
+		{
+			tenths += *text - '0';
+			digits++;
+		}
+		while (*text >= '0' && *text <= '9')
+		{
+			text++;
+		}
+	}
+	
+	if (digits == 0 || *text != '\0' || tenths > 0xFFFF)
+	{
+		return false;
+	}
+	value = (uint16_t)tenths;
+	return true;
+}
@@ -0,0 +1,100 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_serialcontrol.h
+ /// \brief Serial command class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Added command to export the input recording.
+ /// \version 1.2	Added command to calibrate with the current sensor.
+ /// \version 1.3	Added command to export the move log.
+ /// \version 1.4	Added maintenance command.
+ /// \version 1.5	Added watchdog report command.
+ /// \version 1.6	Added tick budget report command and peekCommand().
+ /// \version 1.7	Added EEPROM self-test command.
+ /// \version 1.8	Added _Overflow for lines longer than the buffer.
+ /// \version 1.9	Added preset direction command.
+
+#ifndef PE1MEW_SERIALCONTROL_H
+#define PE1MEW_SERIALCONTROL_H
+
+#include <stdint.h>
+
+static const uint8_t COMMAND_BUFFER_SIZE = 12;	///< Maximum length of a command line including the command character.
+static const uint16_t ARGUMENT_NONE = 0xFFFF;	///< Argument of a command with an optional argument sent without one, when 0 is a valid argument.
+
+/// \brief commands that can be received on the serial port.
+/// A command is one character followed by an optional argument and ended by CR or LF.
+enum eSerialCommand { COMMAND_NONE = 0,			///< No (valid) command received
+					  COMMAND_DIRECTION = 'D',	///< Set next direction, argument in degrees with one optional decimal: "D123.4"
+					  COMMAND_MEMORY = 'M',		///< Report free RAM and stack peak, no argument: "M"
+					  COMMAND_RECORDING = 'R',	///< Export the input recording, no argument: "R"
+					  COMMAND_CALIBRATE = 'C',	///< Calibrate the runtime between the end stops found by the current sensor, no argument: "C"
+					  COMMAND_LOG = 'L',		///< Export the move log in binary, no argument: "L"
+					  COMMAND_MAINTENANCE = 'W',	///< Report the relay cycles and motor hours: "W", clear the counter of relay 1 or 2: "W1", "W2"
+					  COMMAND_WATCHDOG = 'T',	///< Report the reset cause, the longest tick and the last watchdog reset, no argument: "T"
+					  COMMAND_BUDGET = 'B',		///< Report the deferred tasks and the longest tick of the tick budget, no argument: "B"
+					  COMMAND_EEPROM = 'E',		///< Run the write test of the EEPROM self-test and report its health, no argument: "E"
+					  COMMAND_PRESET = 'P' };	///< Mark a preset direction on the compass card: "P123.4", remove the marks: "P"
+
+/// \class PE1MEW_SerialControl
+/// \brief Receives and parses commands from the serial port.
+///
+/// Characters are read without blocking at each sys tick. Arguments are parsed to
+/// tenths of degrees in integer arithmetic, so "D123", "D123.4" and "D123.45" result
+/// in 1230, 1234 and 1234.
+class PE1MEW_SerialControl
+{
+public:
+	/// \brief Default constructor
+	PE1MEW_SerialControl();
+	
+	/// \brief at sys tick executed function to read characters from the serial port.
+	void Process(void);
+	
+	/// \brief get the last received command.
+	/// The command is cleared after reading.
+	/// \return command as eSerialCommand, COMMAND_NONE when no command is pending.
+	uint8_t getCommand(void);
+	
+	/// \brief get the last received command without clearing it.
+	/// \return command as eSerialCommand, COMMAND_NONE when no command is pending.
+	uint8_t peekCommand(void){return _Command;}
+	
+	/// \brief get the argument of the last received command.
+	/// \return argument in tenths.
+	uint16_t getArgument(void){return _Argument;}
+
+private:
+	char	 _Buffer[COMMAND_BUFFER_SIZE];	///< Characters of the command line received so far.
+	uint8_t	 _BufferLength;					///< Number of characters in _Buffer, up to COMMAND_BUFFER_SIZE - 1.
+	bool	 _Overflow;						///< The line is longer than _Buffer, it is dropped at the end of line.
+	uint8_t	 _Command;						///< Last received valid command
+	uint16_t _Argument;						///< Argument of the last received valid command in tenths.
+	
+	/// \brief parse a complete command line in _Buffer.
+	/// Sets _Command and _Argument when the line is valid.
+	/// \return true=valid command, false=invalid command.
+	bool parseLine(void);
+	
+	/// \brief parse a decimal number with one optional decimal in to tenths.
+	/// \param text string to parse, terminated by '\0'
+	/// \param[out] value parsed value in tenths.
+	/// \return true=valid number, false=invalid number.
+	bool parseTenths(const char* text, uint16_t& value);
+};
+
+#endif // PE1MEW_SERIALCONTROL_H
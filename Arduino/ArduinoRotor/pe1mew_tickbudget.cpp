@@ -0,0 +1,128 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_tickbudget.cpp
+ /// \brief Tick budget class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Deferrals and overruns logged by the debug logger.
+ /// \version 1.2	Only the first deferral of a frame or report in consecutive ticks logged.
+ /// \version 1.3	The tick measured by the watchdog, no measurement of its own.
+
+#include "pe1mew_tickbudget.h"
+#include "pe1mew_debuglog.h"
+
+#include "Arduino.h"
+
+PE1MEW_TickBudget::PE1MEW_TickBudget():
+	_Start(0),
+	_Planned(0),
+	_Reserved(0),
+	_Waiting(0),
+	_Deferred(0),
+	_Previous(0),
+	_Granted(false),
+	_Cost(),
+	_Deferrals()
+{
+}
+
+void PE1MEW_TickBudget::startTick(uint32_t start)
+{
+	_Start = start;
+	_Planned = (_Planned > WATCHDOG_TICK) ? _Planned - WATCHDOG_TICK : 0;
+	_Granted = false;
+	
+	// The tasks deferred in the previous tick are reserved in this tick.
+	_Waiting = _Deferred;
+	_Previous = _Deferred;
+	_Deferred = 0;
+	_Reserved = 0;
+	for (uint8_t task = 0; task < TASK_COUNT; task++)
+	{
+		if (_Waiting & (1 << task))
+		{
+			_Reserved += _Cost[task];
+		}
+		else
+		{
+			_Cost[task] = 0;
+		}
+	}
+}
+
+bool PE1MEW_TickBudget::request(uint8_t task, uint16_t cost)
+{
+	uint8_t  bit = 1 << task;
+	bool     waiting = (_Waiting & bit) != 0;
+	uint32_t elapsed = micros() - _Start;
+	uint32_t start = (elapsed > _Planned) ? elapsed : _Planned;
+	uint16_t reserved = waiting ? _Reserved - _Cost[task] : _Reserved;
+	
+	bool fits = (start + reserved + cost <= WATCHDOG_TICK - BUDGET_HEADROOM);
+	bool alone = waiting && !_Granted && (start + cost > WATCHDOG_TICK - BUDGET_HEADROOM);
+	
+	if (fits || alone)
+	{
+		if (waiting)
+		{
+			_Waiting &= ~bit;
+			_Reserved = reserved;
+		}
+		start += cost;
+		_Planned = (start > 0xFFFF) ? 0xFFFF : (uint16_t)start;
+		_Granted = true;
+		return true;
+	}
+	
+	// The cost of a reserved task stays as reserved for the rest of this tick.
+	if (!waiting && cost > _Cost[task])
+	{
+		_Cost[task] = cost;
+	}
+	// EEPROM bytes wait in most ticks of a burst by design, they are only counted. A frame or
+	// a report deferred in ticks in a row is logged once.
+	if (task != TASK_EEPROM && !((_Deferred | _Previous) & bit))
+	{
+		DEBUG_LOG1(DEFERRED, task);
+	}
+	_Deferred |= bit;
+	if (_Deferrals[task] < 0xFFFF)
+	{
+		_Deferrals[task]++;
+	}
+	return false;
+}
+
+uint16_t PE1MEW_TickBudget::getSerialCost(uint8_t length)
+{
+	int available = Serial.availableForWrite();
+	return (length > available) ? (uint16_t)(length - available) * COST_SERIAL_BYTE : 0;
+}
+
+void PE1MEW_TickBudget::report(uint16_t longest, uint16_t overruns)
+{
+	Serial.print(F("deferred frame "));
+	Serial.print(_Deferrals[TASK_FRAME]);
+	Serial.print(F(" eeprom "));
+	Serial.print(_Deferrals[TASK_EEPROM]);
+	Serial.print(F(" serial "));
+	Serial.print(_Deferrals[TASK_SERIAL]);
+	Serial.print(F(" longest "));
+	Serial.print(longest);
+	Serial.print(F(" us overruns "));
+	Serial.println(overruns);
+}
@@ -0,0 +1,98 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_tickbudget.h
+ /// \brief Tick budget class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	Deferrals and overruns logged by the debug logger.
+ /// \version 1.2	Only the first deferral of a frame or report in consecutive ticks logged.
+ /// \version 1.3	The tick measured by the watchdog, no measurement of its own.
+
+#ifndef PE1MEW_TICKBUDGET_H
+#define PE1MEW_TICKBUDGET_H
+
+#include <stdint.h>
+#include "pe1mew_watchdog.h"
+
+static const uint16_t BUDGET_HEADROOM = 2000;		///< uS kept free at the end of a tick for interrupts and the work that is not planned.
+static const uint16_t COST_EEPROM_BYTE = 3400;		///< uS of an EEPROM write, the next EEPROM access waits for it.
+static const uint16_t COST_SERIAL_BYTE = 87;		///< uS of a byte at 115200 baud that does not fit in the transmit buffer, print() waits for it.
+
+/// \brief expensive tasks that are planned in a tick.
+enum eBudgetTask { TASK_FRAME = 0,		///< Send the frame to the Neopixel ring
+				   TASK_EEPROM,			///< Write a byte to EEPROM
+				   TASK_SERIAL,			///< Send a report on the serial port
+				   TASK_COUNT };		///< Number of tasks
+
+/// \class PE1MEW_TickBudget
+/// \brief Plans the expensive tasks of a sys tick so the tick ends in time.
+///
+/// A task asks for its cost in uS with request() before it runs. It is granted when the time used
+/// in the tick, the tasks granted before and the tasks reserved for this tick fit before
+/// WATCHDOG_TICK - BUDGET_HEADROOM; else it is deferred and tries again at the next tick. A task that
+/// was deferred is reserved at the next tick, so the tasks that ask before it cannot take its time.
+/// A deferred task that does not fit in an empty tick is granted when it is the first task of a tick.
+///
+/// The time used is the larger of micros() since the start of the tick and the end of the granted
+/// tasks: an EEPROM write returns at once but the next write waits for it, so its cost is counted
+/// from the request. Costs planned past the end of the tick are carried to the next tick.
+///
+/// The tick is measured once, by PE1MEW_Watchdog: the budget plans from its start, and its longest
+/// tick and overruns are reported with the deferrals.
+class PE1MEW_TickBudget
+{
+public:
+	/// \brief Default constructor
+	PE1MEW_TickBudget();
+	
+	/// \brief start the plan of a sys tick, at the start of the tick.
+	/// \param start micros() at the start of the tick, PE1MEW_Watchdog::getTickStart().
+	void startTick(uint32_t start);
+	
+	/// \brief ask for time in this tick.
+	/// \param task eBudgetTask
+	/// \param cost time of the task in uS.
+	/// \return true when the task shall run now, false when it shall ask again at the next tick.
+	bool request(uint8_t task, uint16_t cost);
+	
+	/// \brief get the time print() waits to send a number of characters.
+	/// \param length characters to send.
+	/// \return cost in uS.
+	static uint16_t getSerialCost(uint8_t length);
+	
+	/// \brief get the number of requests of a task that were deferred since the start.
+	/// \param task eBudgetTask
+	uint16_t getDeferrals(uint8_t task){return _Deferrals[task];}
+	
+	/// \brief report the deferrals, the longest tick and the overruns on the serial port.
+	/// \param longest longest tick in uS, PE1MEW_Watchdog::getLongestTick().
+	/// \param overruns ticks longer than WATCHDOG_TICK, PE1MEW_Watchdog::getOverruns().
+	void report(uint16_t longest, uint16_t overruns);
+
+private:
+	uint32_t _Start;					///< micros() at the start of the tick.
+	uint16_t _Planned;					///< End of the granted tasks in uS from the start of the tick.
+	uint16_t _Reserved;					///< Cost of the reserved tasks that are not granted yet in this tick.
+	uint8_t  _Waiting;					///< Bits of the tasks deferred in the previous tick and not granted yet.
+	uint8_t  _Deferred;					///< Bits of the tasks deferred in this tick.
+	uint8_t  _Previous;					///< Bits of the tasks deferred in the previous tick.
+	bool     _Granted;					///< A task was granted in this tick.
+	uint16_t _Cost[TASK_COUNT];			///< Largest cost of a deferred request of each task.
+	uint16_t _Deferrals[TASK_COUNT];	///< Deferred requests of each task.
+};
+
+#endif // PE1MEW_TICKBUDGET_H
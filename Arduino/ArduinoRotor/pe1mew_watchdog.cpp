@@ -0,0 +1,152 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_watchdog.cpp
+ /// \brief Watchdog class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	A kept record tells a watchdog reset when the reset cause is not known.
+ /// \version 1.2	Record of the last tick per thread in the simulator.
+ /// \version 1.3	The measurement of the tick read by the tick budget, overruns logged by the debug logger.
+
+#include "pe1mew_watchdog.h"
+#include "pe1mew_debuglog.h"
+
+#include "Arduino.h"
+#include <EEPROM.h>
+#include <stddef.h>
+#ifdef __AVR__
+#include <avr/wdt.h>
+#endif
+
+#ifdef __AVR__
+sTickRecord PE1MEW_Watchdog::_Record __attribute__((section(".noinit")));
+#else
+WATCHDOG_SHARED sTickRecord PE1MEW_Watchdog::_Record;
+#endif
+
+PE1MEW_Watchdog::PE1MEW_Watchdog():
+	_ResetCause(0),
+	_Start(0),
+	_Overruns(0)
+{
+}
+
+void PE1MEW_Watchdog::Initialize(uint8_t resetCause)
+{
+	_ResetCause = resetCause;
+	
+	// Without a reset cause a record with ticks that the reset did not clear is taken as a watchdog reset.
+	bool watchdog = (resetCause & RESET_WATCHDOG) || (resetCause == 0 && _Record.tick > 0);
+	if (watchdog && _Record.check == getCheck())
+	{
+		uint8_t resets = EEPROM.read(WATCHDOG_START);
+		resets = (resets == 0xFF) ? 1 : ((resets < 0xFE) ? resets + 1 : resets);	// 0xFF is erased EEPROM
+		EEPROM.update(WATCHDOG_START, resets);
+		EEPROM.update(WATCHDOG_START + 1, _Record.runState);
+		EEPROM.update(WATCHDOG_START + 2, (uint8_t)(_Record.tick >> 24));
+		EEPROM.update(WATCHDOG_START + 3, (uint8_t)(_Record.tick >> 16));
+		EEPROM.update(WATCHDOG_START + 4, (uint8_t)(_Record.tick >> 8));
+		EEPROM.update(WATCHDOG_START + 5, (uint8_t)_Record.tick);
+		EEPROM.update(WATCHDOG_START + 6, (uint8_t)(_Record.longest >> 8));
+		EEPROM.update(WATCHDOG_START + 7, (uint8_t)_Record.longest);
+	}
+	
+	_Record.runState = 0;
+	_Record.tick = 0;
+	_Record.longest = 0;
+	_Record.check = getCheck();
+	
+#ifdef __AVR__
+	wdt_enable(WDTO_250MS);
+#endif
+}
+
+void PE1MEW_Watchdog::startTick(void)
+{
+	_Start = micros();
+}
+
+void PE1MEW_Watchdog::endTick(uint8_t runState, bool healthy)
+{
+	uint32_t duration = micros() - _Start;
+	
+	if (duration >= WATCHDOG_TICK)
+	{
+		DEBUG_LOG1(OVERRUN, (duration > 0xFFFF) ? 0xFFFF : duration);
+		if (_Overruns < 0xFFFF)
+		{
+			_Overruns++;
+		}
+	}
+	if (duration > _Record.longest)
+	{
+		_Record.longest = (duration > 0xFFFF) ? 0xFFFF : (uint16_t)duration;
+	}
+	_Record.runState = runState;
+	_Record.tick++;
+	_Record.check = getCheck();
+	
+	// A tick that does not end or a controller in an invalid state does not reset the watchdog.
+	if (healthy)
+	{
+#ifdef __AVR__
+		wdt_reset();
+#endif
+	}
+}
+
+void PE1MEW_Watchdog::report(void)
+{
+	Serial.print(F("reset 0x"));
+	Serial.print(_ResetCause, HEX);
+	Serial.print(F(" ticks "));
+	Serial.print(_Record.tick);
+	Serial.print(F(" longest "));
+	Serial.print(_Record.longest);
+	Serial.print(F(" us overruns "));
+	Serial.println(_Overruns);
+	
+	uint8_t resets = EEPROM.read(WATCHDOG_START);
+	if (resets != 0xFF)
+	{
+		uint32_t tick = 0;
+		for (uint8_t i = 2; i < 6; i++)
+		{
+			tick = (tick << 8) | EEPROM.read(WATCHDOG_START + i);
+		}
+		Serial.print(F("watchdog resets "));
+		Serial.print(resets);
+		Serial.print(F(" last state "));
+		Serial.print(EEPROM.read(WATCHDOG_START + 1));
+		Serial.print(F(" tick "));
+		Serial.print(tick);
+		Serial.print(F(" longest "));
+		Serial.print(((uint16_t)EEPROM.read(WATCHDOG_START + 6) << 8) | EEPROM.read(WATCHDOG_START + 7));
+		Serial.println(F(" us"));
+	}
+}
+
+uint8_t PE1MEW_Watchdog::getCheck(void)
+{
+	const uint8_t* record = (const uint8_t*)&_Record;
+	uint8_t check = 0x5A;					// RAM of 0x00 or 0xFF does not match
+	for (uint8_t i = 0; i < offsetof(sTickRecord, check); i++)
+	{
+		check ^= record[i];
+	}
+	return check;
+}
@@ -0,0 +1,118 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+ /// \file pe1mew_watchdog.h
+ /// \brief Watchdog class for PE1MEW Arduino Rotor Controller
+ /// \date 18-10-2026
+ /// \author Remko Welling (PE1MEW)
+ /// \version 1.0
+ /// \version 1.1	A kept record tells a watchdog reset when the reset cause is not known.
+ /// \version 1.2	Record of the last tick per thread in the simulator.
+ /// \version 1.3	The measurement of the tick read by the tick budget, overruns logged by the debug logger.
+
+#ifndef PE1MEW_WATCHDOG_H
+#define PE1MEW_WATCHDOG_H
+
+#include <stdint.h>
+
+static const uint16_t WATCHDOG_START = 0x08;		///< EEPROM address of the record of the last watchdog reset.
+static const uint16_t WATCHDOG_TICK = 10000;		///< Sys tick in uS, a longer tick is an overrun.
+
+/// \brief causes of a reset, the bits of MCUSR. 0 when the bootloader did not pass MCUSR.
+enum eResetCause { RESET_POWERON = 0x01,		///< Power-on reset
+				   RESET_EXTERNAL = 0x02,		///< Reset pin
+				   RESET_BROWNOUT = 0x04,		///< Brown-out detector
+				   RESET_WATCHDOG = 0x08 };		///< Watchdog timeout
+
+#ifdef __AVR__
+#define WATCHDOG_SHARED				///< Kept in .noinit, see pe1mew_watchdog.cpp.
+#else
+#define WATCHDOG_SHARED thread_local	///< The simulator runs a controller per thread.
+#endif
+
+/// \brief state of the last tick, kept in RAM that is not cleared by a reset.
+struct sTickRecord
+{
+	uint8_t  runState;		///< eRunState of the last tick.
+	uint32_t tick;			///< Ticks since the start.
+	uint16_t longest;		///< Longest tick in uS.
+	uint8_t  check;			///< Check byte of the record, tells if the RAM kept it.
+};
+
+/// \class PE1MEW_Watchdog
+/// \brief Resets the controller when a sys tick does not end or the controller is not healthy.
+///
+/// The watchdog of the AVR resets the controller after 250 mS unless a tick ended healthy.
+/// A reset releases the relays. The last run state, the tick number and the longest tick are kept
+/// in a record in RAM that is not cleared at a reset; after a watchdog reset they are written to
+/// EEPROM:
+/// - byte 0: number of watchdog resets, up to 255
+/// - byte 1: eRunState of the last tick
+/// - byte 2 - 5: tick number of the last tick, MSB first
+/// - byte 6, 7: longest tick in uS, MSB first
+///
+/// When the reset cause is not known, as with Optiboot before 5.0, a record that the reset did not
+/// clear is taken as a watchdog reset. A power-on leaves random RAM that fails the check byte,
+/// but a reset by the reset pin is recorded as well.
+class PE1MEW_Watchdog
+{
+public:
+	/// \brief Default constructor
+	PE1MEW_Watchdog();
+	
+	/// \brief write the record of a watchdog reset to EEPROM and start the watchdog, at the end of setup().
+	/// \param resetCause MCUSR at the start, eResetCause bits, 0 when not known.
+	void Initialize(uint8_t resetCause);
+	
+	/// \brief start the time of a sys tick.
+	void startTick(void);
+	
+	/// \brief get the start of the sys tick, the tick budget plans from it.
+	/// \return micros() at the start of the tick.
+	uint32_t getTickStart(void){return _Start;}
+	
+	/// \brief end a sys tick: measure it and reset the watchdog when the controller is healthy.
+	/// \param runState eRunState
+	/// \param healthy the controller is in a valid state.
+	void endTick(uint8_t runState, bool healthy);
+	
+	/// \brief get the cause of the last reset.
+	/// \return eResetCause bits.
+	uint8_t getResetCause(void){return _ResetCause;}
+	
+	/// \brief get the longest tick since the start.
+	/// \return duration in uS.
+	uint16_t getLongestTick(void){return _Record.longest;}
+	
+	/// \brief get the number of ticks longer than WATCHDOG_TICK since the start.
+	uint16_t getOverruns(void){return _Overruns;}
+	
+	/// \brief do not record the next watchdog reset, it restarts the controller on purpose.
+	void setRestart(void){_Record.check = ~getCheck();}
+	
+	/// \brief report the cause of the reset, the ticks of this run and the last watchdog reset on the serial port.
+	void report(void);
+
+private:
+	uint8_t  _ResetCause;			///< eResetCause bits at the start.
+	uint32_t _Start;				///< micros() at the start of the tick.
+	uint16_t _Overruns;				///< Ticks longer than WATCHDOG_TICK.
+	static WATCHDOG_SHARED sTickRecord _Record;	///< State of the last tick, not cleared by a reset.
+	
+	/// \brief get the check byte of _Record.
+	uint8_t getCheck(void);
+};
+
+#endif // PE1MEW_WATCHDOG_H
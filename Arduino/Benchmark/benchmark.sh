@@ -0,0 +1,40 @@
+#!/bin/sh
+#--------------------------------------------------------------------
+#  This file is part of the PE1MEW Arduino Rotor Controller.
+#
+#  The PE1MEW Arduino Rotor Controller is free software:
+#  you can redistribute it and/or modify it under the terms of a Creative
+#  Commons Attribution-NonCommercial 4.0 International License
+#  (http://creativecommons.org/licenses/by-nc/4.0/) by
+#  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+#--------------------------------------------------------------------
+#
+# Build the firmware with CYCLEBENCHMARK defined, run every scenario in simavr
+# and report the cycles of each Process() path.
+#
+# Usage: benchmark.sh [scenario ...]
+#
+# arduino-cli with the arduino:avr core and the Adafruit NeoPixel library, a C compiler
+# and simavr (headers and libsimavr, with libelf) shall be installed.
+
+cd "$(dirname "$0")" || exit 1
+
+BUILD=build
+FQBN="arduino:avr:pro:cpu=8MHzatmega328"	# ATmega328P at 8 MHz, see OCR1A in ArduinoRotor.ino
+
+arduino-cli compile --fqbn "$FQBN" --build-path "$BUILD" \
+	--build-property "compiler.cpp.extra_flags=-DCYCLEBENCHMARK" ../ArduinoRotor || exit 1
+
+SIMAVR_CFLAGS=$(pkg-config --cflags simavr 2>/dev/null)
+SIMAVR_LIBS=$(pkg-config --libs simavr 2>/dev/null || echo "-lsimavr")
+cc -O2 -o "$BUILD/cyclebench" cyclebench.c $SIMAVR_CFLAGS $SIMAVR_LIBS -lelf || exit 1
+
+if [ $# -eq 0 ]; then
+	set -- scenarios/*.txt
+fi
+
+for scenario in "$@"; do
+	echo "--- $(basename "$scenario" .txt) ---"
+	"$BUILD/cyclebench" "$BUILD/ArduinoRotor.ino.elf" "$scenario" || exit 1
+	echo
+done
@@ -0,0 +1,257 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file cyclebench.c
+/// \brief Cycle benchmark of the PE1MEW Rotor Controller firmware in simavr
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+///
+/// The firmware build with CYCLEBENCHMARK defined is run in simavr as an ATmega328P at 8 MHz.
+/// Before each Process() call the firmware writes the path (see PE1MEW_RotorController::getProcessPath())
+/// in GPIOR1 and 1 in GPIOR0, after the call 0 in GPIOR0. The cycles between both writes are counted
+/// per path. The buttons on pin 2 and 3 are driven from a scenario file with lines:
+///
+///     <time in ms> <buttons>      buttons as eButtonState: 0 none, 1 BUTTON_1 (CCW), 2 BUTTON_2 (CW), 3 both
+///     <time in ms> end            end of the benchmark
+///
+/// A line at time 0 sets the buttons at power-up. Lines starting with # are comments.
+/// The cycles include the sys tick interrupt when it occurs during Process().
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_ioport.h>
+
+#define CPU_FREQUENCY	8000000UL	///< Clock of the rotor controller.
+#define GPIOR0_ADDRESS	0x3E		///< Data address of GPIOR0 in the ATmega328P.
+#define GPIOR1_ADDRESS	0x4A		///< Data address of GPIOR1 in the ATmega328P.
+#define SW1_PIN			2			///< PD2, BUTTON_2 (CW), see pe1mew_rotorsteering.h
+#define SW2_PIN			3			///< PD3, BUTTON_1 (CCW)
+#define BUTTON_1		0x01
+#define BUTTON_2		0x02
+#define STEP_MAX		256			///< Lines in a scenario.
+#define PATH_MAX		256			///< Paths are one byte.
+
+/// \brief one line of a scenario.
+typedef struct
+{
+	uint32_t time;		///< Time since power-up in ms.
+	int      buttons;	///< eButtonState, or -1 at the end.
+} sStep;
+
+/// \brief cycles of one Process() path.
+typedef struct
+{
+	uint32_t calls;
+	uint64_t total;
+	uint64_t minimum;
+	uint64_t maximum;
+} sPath;
+
+static sPath paths[PATH_MAX];
+static avr_cycle_count_t processStart = 0;
+static int processRunning = 0;
+
+/// \brief names of eRunState and eModeState in pe1mew_rotorcontroller.h, keep in the same order.
+static const char* RUN_STATE[] = { "NORMAL", "SET_INTENSITY", "SYNCHRONIZE", "TEST_CALIBRATE" };
+static const char* MODE_STATE[] = { "MODE_EXIT", "SBINIT", "SB", "SBFINISH", "SYNCINIT", "SYNC1", "SYNC2", "SYNCFINISH",
+									"TCSINIT", "TCS1", "TCS2", "TCS3", "TCS4", "TCS5", "TCS6", "TCS7" };
+
+static void pathName(uint8_t path, char* name, size_t size)
+{
+	uint8_t runState = path >> 5;
+	uint8_t sub = path & 0x1F;
+
+	if (runState >= sizeof(RUN_STATE) / sizeof(RUN_STATE[0]))
+	{
+		snprintf(name, size, "path 0x%02X", path);
+	}
+	else if (runState == 0)
+	{
+		snprintf(name, size, "%s %s", RUN_STATE[0], sub ? "running" : "idle");
+	}
+	else if (sub < sizeof(MODE_STATE) / sizeof(MODE_STATE[0]))
+	{
+		snprintf(name, size, "%s %s", RUN_STATE[runState], MODE_STATE[sub]);
+	}
+	else
+	{
+		snprintf(name, size, "%s %u", RUN_STATE[runState], sub);
+	}
+}
+
+/// \brief called by simavr at a write in GPIOR0: start or end of Process().
+static void markerWrite(struct avr_t* avr, avr_io_addr_t addr, uint8_t value, void* param)
+{
+	(void)param;
+	avr->data[addr] = value;
+
+	if (value)
+	{
+		processStart = avr->cycle;
+		processRunning = 1;
+	}
+	else if (processRunning)
+	{
+		sPath* path = &paths[avr->data[GPIOR1_ADDRESS]];
+		uint64_t cycles = avr->cycle - processStart;
+
+		if (path->calls == 0 || cycles < path->minimum)
+		{
+			path->minimum = cycles;
+		}
+		if (cycles > path->maximum)
+		{
+			path->maximum = cycles;
+		}
+		path->total += cycles;
+		path->calls++;
+		processRunning = 0;
+	}
+}
+
+static int readScenario(const char* fileName, sStep* steps)
+{
+	FILE* file = fopen(fileName, "r");
+	char line[128];
+	int count = 0;
+
+	if (!file)
+	{
+		fprintf(stderr, "cannot open %s\n", fileName);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), file) && count < STEP_MAX)
+	{
+		unsigned long time;
+		char value[16];
+
+		if (line[0] == '#' || sscanf(line, "%lu %15s", &time, value) != 2)
+		{
+			continue;
+		}
+		steps[count].time = (uint32_t)time;
+		steps[count].buttons = strcmp(value, "end") ? atoi(value) & (BUTTON_1 | BUTTON_2) : -1;
+		count++;
+		if (steps[count - 1].buttons < 0)
+		{
+			break;
+		}
+	}
+	fclose(file);
+
+	if (count == 0 || steps[count - 1].buttons >= 0)
+	{
+		fprintf(stderr, "%s: no line with end\n", fileName);
+		return -1;
+	}
+	return count;
+}
+
+static void setButtons(avr_t* avr, int buttons)
+{
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), SW2_PIN), (buttons & BUTTON_1) ? 1 : 0);
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), SW1_PIN), (buttons & BUTTON_2) ? 1 : 0);
+}
+
+int main(int argc, char* argv[])
+{
+	elf_firmware_t firmware;
+	sStep steps[STEP_MAX];
+	avr_t* avr;
+	int count;
+	int next = 0;
+	int state = cpu_Running;
+
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: %s FIRMWARE.elf SCENARIO\n", argv[0]);
+		return 2;
+	}
+	count = readScenario(argv[2], steps);
+	if (count < 0)
+	{
+		return 2;
+	}
+
+	memset(&firmware, 0, sizeof(firmware));
+	if (elf_read_firmware(argv[1], &firmware) != 0)
+	{
+		fprintf(stderr, "cannot read %s\n", argv[1]);
+		return 2;
+	}
+	// The Arduino build has no .mmcu section.
+	strcpy(firmware.mmcu, "atmega328p");
+	firmware.frequency = CPU_FREQUENCY;
+
+	avr = avr_make_mcu_by_name(firmware.mmcu);
+	if (!avr)
+	{
+		fprintf(stderr, "simavr has no %s\n", firmware.mmcu);
+		return 2;
+	}
+	avr_init(avr);
+	avr_load_firmware(avr, &firmware);
+	avr_register_io_write(avr, GPIOR0_ADDRESS, markerWrite, NULL);
+
+	while (state != cpu_Done && state != cpu_Crashed)
+	{
+		uint64_t time = avr->cycle / (CPU_FREQUENCY / 1000);
+
+		while (next < count && steps[next].time <= time)
+		{
+			if (steps[next].buttons < 0)
+			{
+				state = cpu_Done;
+				break;
+			}
+			setButtons(avr, steps[next].buttons);
+			next++;
+		}
+		if (state != cpu_Done)
+		{
+			state = avr_run(avr);
+		}
+	}
+	if (state == cpu_Crashed)
+	{
+		fprintf(stderr, "firmware crashed at cycle %llu\n", (unsigned long long)avr->cycle);
+		return 1;
+	}
+
+	printf("%-30s %8s %8s %8s %8s %8s\n", "path", "calls", "min", "mean", "max", "max us");
+	for (int i = 0; i < PATH_MAX; i++)
+	{
+		char name[40];
+
+		if (paths[i].calls == 0)
+		{
+			continue;
+		}
+		pathName((uint8_t)i, name, sizeof(name));
+		printf("%-30s %8u %8llu %8llu %8llu %8.1f\n", name, paths[i].calls,
+			   (unsigned long long)paths[i].minimum,
+			   (unsigned long long)(paths[i].total / paths[i].calls),
+			   (unsigned long long)paths[i].maximum,
+			   paths[i].maximum * 1e6 / CPU_FREQUENCY);
+	}
+	return 0;
+}
@@ -0,0 +1,43 @@
+/// \file Adafruit_NeoPixel.h
+/// \brief Host replacement of the Adafruit Neopixel library: pixels are kept in memory.
+/// The frame that is shown is also copied to Simulator::leds.
+
+#ifndef SIMULATOR_ADAFRUIT_NEOPIXEL_H
+#define SIMULATOR_ADAFRUIT_NEOPIXEL_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "Arduino.h"
+
+#define NEO_GRB		0x52
+#define NEO_KHZ800	0x0000
+
+typedef uint16_t neoPixelType;
+
+/// \class Adafruit_NeoPixel
+/// \brief Keeps the frame in memory and counts the frames shown.
+class Adafruit_NeoPixel
+{
+public:
+	Adafruit_NeoPixel(uint16_t count, uint16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800)
+		: pixels(count, 0), shown(count, 0), brightness(0), shows(0) { (void)pin; (void)type; }
+
+	void begin(void) {}
+	void show(void) { shown = pixels; shows++; Simulator::leds = pixels; Simulator::ledBrightness = brightness; Simulator::ledShows++; }
+	void clear(void) { for (size_t i = 0; i < pixels.size(); i++) { pixels[i] = 0; } }
+	void setBrightness(uint8_t value) { brightness = value; }
+	uint8_t getBrightness(void) const { return brightness; }
+	void setPixelColor(uint16_t n, uint32_t color) { if (n < pixels.size()) { pixels[n] = color; } }
+	void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) { setPixelColor(n, Color(r, g, b)); }
+	uint32_t getPixelColor(uint16_t n) const { return (n < pixels.size()) ? pixels[n] : 0; }
+	uint16_t numPixels(void) const { return (uint16_t)pixels.size(); }
+	static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) { return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
+
+	std::vector<uint32_t> pixels;	///< Frame being built.
+	std::vector<uint32_t> shown;	///< Last frame send to the leds.
+	uint8_t  brightness;			///< Brightness set.
+	uint32_t shows;					///< Number of frames send to the leds.
+};
+
+#endif // SIMULATOR_ADAFRUIT_NEOPIXEL_H
@@ -0,0 +1,106 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file Arduino.h
+/// \brief Host replacement of the Arduino core for the PE1MEW Rotor Controller simulator
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+/// \version 1.1	Simulated hardware per thread, so controllers can run in parallel.
+/// \version 1.2	64 bit virtual clock, millis() and micros() wrap as on the Arduino.
+/// \version 1.3	Last frame send to the leds.
+///
+/// Only the functions used by the rotor controller are provided.
+/// The simulator reads and writes the pins and the serial port through the Simulator namespace.
+/// Each thread has its own simulated hardware: a controller shall be created, run and destroyed
+/// in one thread.
+
+#ifndef SIMULATOR_ARDUINO_H
+#define SIMULATOR_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include "avr/pgmspace.h"
+#include "avr/interrupt.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH			0x1
+#define LOW				0x0
+#define INPUT			0x0
+#define OUTPUT			0x1
+#define INPUT_PULLUP	0x2
+#define DEC				10
+#define HEX				16
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+unsigned long millis(void);
+unsigned long micros(void);
+
+/// \class HardwareSerial
+/// \brief Serial port that reads from and writes to memory.
+class HardwareSerial
+{
+public:
+	void begin(unsigned long baud);
+	int available(void);
+	int read(void);
+	int availableForWrite(void);
+	void flush(void);
+	size_t write(uint8_t value);
+	size_t write(const uint8_t* buffer, size_t size);
+	size_t print(const char* text);
+	size_t print(const __FlashStringHelper* text);
+	size_t print(char value);
+	size_t print(int value, int base = DEC);
+	size_t print(unsigned int value, int base = DEC);
+	size_t print(long value, int base = DEC);
+	size_t print(unsigned long value, int base = DEC);
+	size_t println(void);
+	template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+	template <typename T> size_t println(T value, int base) { size_t n = print(value, base); return n + println(); }
+};
+
+extern HardwareSerial Serial;
+
+/// \brief access to the simulated hardware.
+namespace Simulator
+{
+	static const uint8_t PINCOUNT = 20;		///< Number of digital pins.
+
+	extern thread_local uint8_t		pins[PINCOUNT];		///< Level of each pin, written by digitalWrite() or by the simulator for inputs.
+	extern thread_local uint64_t	time;				///< Virtual clock in uS, advanced by the simulator only. micros() and millis() return the lower 32 bits.
+	extern thread_local std::string	serialInput;		///< Characters not yet read by the rotor controller.
+	extern thread_local std::string	serialOutput;		///< Characters written by the rotor controller.
+	extern thread_local std::vector<uint32_t> leds;		///< Last frame send to the leds, 0xRRGGBB per led.
+	extern thread_local uint8_t		ledBrightness;		///< Brightness of the last frame send to the leds.
+	extern thread_local uint32_t	ledShows;			///< Number of frames send to the leds.
+
+	/// \brief put the simulated hardware of this thread in the state after power-up, including erased EEPROM.
+	void reset(void);
+}
+
+#endif // SIMULATOR_ARDUINO_H
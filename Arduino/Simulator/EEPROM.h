@@ -0,0 +1,28 @@
+/// \file EEPROM.h
+/// \brief Host replacement of the Arduino EEPROM library.
+
+#ifndef SIMULATOR_EEPROM_H
+#define SIMULATOR_EEPROM_H
+
+#include <stdint.h>
+
+/// \class EEPROMClass
+/// \brief 1 KB EEPROM in memory per thread, erased to 0xFF by Simulator::reset().
+class EEPROMClass
+{
+public:
+	static const uint16_t SIZE = 1024;	///< Size of the EEPROM of the ATMega328.
+
+	uint8_t data[SIZE];					///< Content of the EEPROM.
+	uint32_t writes;					///< Number of bytes written, to compare wear.
+	uint16_t lastAddress;				///< Address of the last byte written, to cut the power while it is written.
+
+	uint8_t read(int address) { return data[address % SIZE]; }
+	void write(int address, uint8_t value) { data[address % SIZE] = value; writes++; lastAddress = address % SIZE; }
+	void update(int address, uint8_t value) { if (read(address) != value) { write(address, value); } }
+	uint16_t length(void) { return SIZE; }
+};
+
+extern thread_local EEPROMClass EEPROM;
+
+#endif // SIMULATOR_EEPROM_H
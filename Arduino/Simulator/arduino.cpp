@@ -0,0 +1,174 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file arduino.cpp
+/// \brief Host replacement of the Arduino core for the PE1MEW Rotor Controller simulator
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+/// \version 1.1	Simulated hardware per thread.
+/// \version 1.2	64 bit virtual clock.
+/// \version 1.3	Last frame send to the leds.
+/// \version 1.4	Internal pull-up of an input.
+
+#include "Arduino.h"
+#include "EEPROM.h"
+
+#include <stdio.h>
+
+HardwareSerial Serial;					// Stateless, reads and writes the buffers of the calling thread.
+thread_local EEPROMClass EEPROM;
+
+namespace Simulator
+{
+	thread_local uint8_t		pins[PINCOUNT];
+	thread_local uint64_t		time;
+	thread_local std::string	serialInput;
+	thread_local std::string	serialOutput;
+	thread_local std::vector<uint32_t> leds;
+	thread_local uint8_t		ledBrightness;
+	thread_local uint32_t		ledShows;
+
+	void reset(void)
+	{
+		memset(pins, LOW, sizeof(pins));
+		memset(EEPROM.data, 0xFF, sizeof(EEPROM.data));
+		EEPROM.writes = 0;
+		time = 0;
+		serialInput.clear();
+		serialOutput.clear();
+		leds.clear();
+		ledBrightness = 0;
+		ledShows = 0;
+	}
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	if (mode == INPUT_PULLUP && pin < Simulator::PINCOUNT)
+	{
+		Simulator::pins[pin] = HIGH;	// nothing connected pulls it low yet
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	if (pin < Simulator::PINCOUNT)
+	{
+		Simulator::pins[pin] = value ? HIGH : LOW;
+	}
+}
+
+int digitalRead(uint8_t pin)
+{
+	return (pin < Simulator::PINCOUNT) ? Simulator::pins[pin] : LOW;
+}
+
+unsigned long millis(void)
+{
+	return (uint32_t)(Simulator::time / 1000);	// unsigned long is 32 bits on the Arduino
+}
+
+unsigned long micros(void)
+{
+	return (uint32_t)Simulator::time;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+	(void)baud;
+}
+
+int HardwareSerial::available(void)
+{
+	return (int)Simulator::serialInput.size();
+}
+
+int HardwareSerial::read(void)
+{
+	if (Simulator::serialInput.empty())
+	{
+		return -1;
+	}
+	int returnValue = (uint8_t)Simulator::serialInput[0];
+	Simulator::serialInput.erase(0, 1);
+	return returnValue;
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+	return 63;
+}
+
+void HardwareSerial::flush(void)
+{
+}
+
+size_t HardwareSerial::write(uint8_t value)
+{
+	Simulator::serialOutput += (char)value;
+	return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+	Simulator::serialOutput.append((const char*)buffer, size);
+	return size;
+}
+
+size_t HardwareSerial::print(const char* text)
+{
+	Simulator::serialOutput += text;
+	return strlen(text);
+}
+
+size_t HardwareSerial::print(const __FlashStringHelper* text)
+{
+	return print(reinterpret_cast<const char*>(text));
+}
+
+size_t HardwareSerial::print(char value)
+{
+	return write((uint8_t)value);
+}
+
+size_t HardwareSerial::print(int value, int base)
+{
+	return print((long)value, base);
+}
+
+size_t HardwareSerial::print(unsigned int value, int base)
+{
+	return print((unsigned long)value, base);
+}
+
+size_t HardwareSerial::print(long value, int base)
+{
+	char text[24];
+	snprintf(text, sizeof(text), (base == HEX) ? "%lX" : "%ld", value);
+	return print(text);
+}
+
+size_t HardwareSerial::print(unsigned long value, int base)
+{
+	char text[24];
+	snprintf(text, sizeof(text), (base == HEX) ? "%lX" : "%lu", value);
+	return print(text);
+}
+
+size_t HardwareSerial::println(void)
+{
+	return print("\r\n");
+}
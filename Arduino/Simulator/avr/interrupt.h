@@ -0,0 +1,11 @@
+/// \file interrupt.h
+/// \brief Host replacement of avr/interrupt.h: the simulator has no interrupts.
+
+#ifndef SIMULATOR_INTERRUPT_H
+#define SIMULATOR_INTERRUPT_H
+
+#define cli()
+#define sei()
+#define ISR(vector) extern "C" void vector(void)
+
+#endif // SIMULATOR_INTERRUPT_H
@@ -0,0 +1,18 @@
+/// \file pgmspace.h
+/// \brief Host replacement of avr/pgmspace.h: flash is normal memory.
+
+#ifndef SIMULATOR_PGMSPACE_H
+#define SIMULATOR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)					(s)
+#define pgm_read_byte(address)	(*(const uint8_t*)(address))
+#define pgm_read_word(address)	(*(const uint16_t*)(address))
+#define pgm_read_dword(address)	(*(const uint32_t*)(address))
+#define pgm_read_ptr(address)	(*(void* const*)(address))
+#define memcpy_P				memcpy
+
+#endif // SIMULATOR_PGMSPACE_H
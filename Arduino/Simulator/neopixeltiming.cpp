@@ -0,0 +1,244 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file neopixeltiming.cpp
+/// \brief WS2812 timing test of the SPI output of the PE1MEW Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+///
+/// Random frames are send by PE1MEW_NeoPixelSpi. The SPI bytes are turned in to the level of the
+/// data line at NEOPIXEL_SPI_CLOCK, with a random delay between bytes for the wait on SPIF and now
+/// and then an interrupt. The line is decoded as a WS2812B does: a high time in the T0H window is a 0,
+/// in the T1H window a 1, any other high time is an error. A low time shall be longer than the
+/// minimal low time and, within the frame, shorter than the reset time, else the leds latch halfway.
+/// The datasheet also gives a maximum low time and bit time; the leds only sample the high time, so
+/// these are reported but not tested. The decoded bytes are compared with the colors and brightness
+/// of the frame.
+
+#include "Arduino.h"
+#include "pe1mew_neopixelspi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+static const uint8_t  LEDS = 24;				///< Number of leds in the ring.
+static const uint32_t CPU_CLOCK = 8000000;		///< CPU clock in Hz.
+static const uint32_t T0H_MIN = 250;			///< Shortest high time of a 0 in nS, WS2812B 400 +/- 150.
+static const uint32_t T0H_MAX = 550;			///< Longest high time of a 0 in nS.
+static const uint32_t T1H_MIN = 650;			///< Shortest high time of a 1 in nS, WS2812B 800 +/- 150.
+static const uint32_t T1H_MAX = 950;			///< Longest high time of a 1 in nS.
+static const uint32_t TL_MIN = 300;				///< Shortest low time in nS, WS2812B T1L 450 - 150.
+static const uint32_t BITBANG_FRAME = LEDS * 24 * 1250;	///< Time in nS that Adafruit_NeoPixel disables interrupts for a frame.
+
+/// \brief settings of a timing test.
+struct sTiming
+{
+	uint32_t seed;			///< Seed of the test.
+	uint32_t frames;		///< Number of frames send.
+	uint32_t gap;			///< Largest delay between two SPI bytes in CPU cycles.
+	double   isrRate;		///< Chance of an interrupt before an SPI byte.
+	uint32_t isr;			///< Longest interrupt in nS.
+	uint32_t reset;			///< Low time in nS after which the leds latch the frame.
+};
+
+/// \brief a time the data line is high or low.
+struct sLevel
+{
+	bool     high;			///< Level of the data line.
+	uint32_t time;			///< Duration in nS.
+};
+
+/// \brief range of measured times.
+struct sRange
+{
+	uint32_t min;			///< Shortest time in nS.
+	uint32_t max;			///< Longest time in nS.
+	
+	sRange(): min(UINT32_MAX), max(0) {}
+	void add(uint32_t time) { min = (time < min) ? time : min; max = (time > max) ? time : max; }
+};
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+		   "  --seed N        seed of the test (1)\n"
+		   "  --frames N      frames send (1000)\n"
+		   "  --gap N         largest delay between SPI bytes in CPU cycles (6)\n"
+		   "  --isr-rate P    chance of an interrupt before an SPI byte (0.02)\n"
+		   "  --isr US        longest interrupt in uS (20)\n"
+		   "  --reset US      low time after which the leds latch in uS (50)\n", name);
+}
+
+/// \brief add a time to the data line, joined with the previous time at the same level.
+static void addLevel(std::vector<sLevel>& line, bool high, uint32_t time)
+{
+	if (!line.empty() && line.back().high == high)
+	{
+		line.back().time += time;
+	}
+	else
+	{
+		sLevel level = {high, time};
+		line.push_back(level);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	sTiming timing = {1, 1000, 6, 0.02, 20000, 50000};
+	
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : "0";
+		if (strcmp(option, "--seed") == 0) { timing.seed = strtoul(value, 0, 10); i++; }
+		else if (strcmp(option, "--frames") == 0) { timing.frames = strtoul(value, 0, 10); i++; }
+		else if (strcmp(option, "--gap") == 0) { timing.gap = strtoul(value, 0, 10); i++; }
+		else if (strcmp(option, "--isr-rate") == 0) { timing.isrRate = atof(value); i++; }
+		else if (strcmp(option, "--isr") == 0) { timing.isr = (uint32_t)(atof(value) * 1000); i++; }
+		else if (strcmp(option, "--reset") == 0) { timing.reset = (uint32_t)(atof(value) * 1000); i++; }
+		else { usage(argv[0]); return 1; }
+	}
+	
+	const uint32_t spiBit = 1000000000UL / NEOPIXEL_SPI_CLOCK;
+	const uint32_t cpuCycle = 1000000000UL / CPU_CLOCK;
+	std::mt19937 random(timing.seed);
+	std::uniform_int_distribution<uint32_t> color(0, 0xFFFFFF);
+	std::uniform_int_distribution<uint32_t> brightness(0, 255);
+	std::uniform_int_distribution<uint32_t> gap(0, timing.gap);
+	std::uniform_int_distribution<uint32_t> isr(0, timing.isr);
+	std::bernoulli_distribution interrupt(timing.isrRate);
+	
+	PE1MEW_NeoPixelSpi<LEDS> pixels(LEDS, 6, 0);
+	pixels.begin();
+	
+	sRange zeroHigh, oneHigh, low, bit, frame;
+	uint32_t errors = 0;
+	uint32_t bits = 0;
+	
+	for (uint32_t f = 0; f < timing.frames; f++)
+	{
+		uint32_t colors[LEDS];
+		uint8_t scale = (uint8_t)brightness(random);
+		for (uint8_t led = 0; led < LEDS; led++)
+		{
+			colors[led] = color(random);
+			pixels.setPixelColor(led, colors[led]);
+		}
+		pixels.setBrightness(scale);
+		pixels.show();
+		
+		// data line from the SPI bytes, each byte waits for the previous one.
+		const std::vector<uint8_t>& stream = pixels.getStream();
+		std::vector<sLevel> line;
+		for (size_t i = 0; i < stream.size(); i++)
+		{
+			if (i > 0)
+			{
+				uint32_t delay = gap(random) * cpuCycle;
+				if (interrupt(random))
+				{
+					delay += isr(random);
+				}
+				addLevel(line, false, delay);
+			}
+			for (uint8_t mask = 0x80; mask != 0; mask >>= 1)
+			{
+				addLevel(line, (stream[i] & mask) != 0, spiBit);
+			}
+		}
+		addLevel(line, false, timing.reset);
+		
+		// decode as the leds do.
+		std::vector<uint8_t> decoded;
+		uint8_t value = 0;
+		uint8_t count = 0;
+		uint32_t frameTime = 0;
+		for (size_t i = 0; i < line.size(); i++)
+		{
+			frameTime += line[i].time;
+			if (!line[i].high)
+			{
+				continue;
+			}
+			uint32_t high = line[i].time;
+			uint32_t next = (i + 1 < line.size()) ? line[i + 1].time : 0;
+			bool last = (i + 2 >= line.size());
+			
+			if (high >= T0H_MIN && high <= T0H_MAX)
+			{
+				zeroHigh.add(high);
+				value <<= 1;
+			}
+			else if (high >= T1H_MIN && high <= T1H_MAX)
+			{
+				oneHigh.add(high);
+				value = (value << 1) | 1;
+			}
+			else
+			{
+				printf("frame %u: high time of %u nS\n", f, high);
+				errors++;
+			}
+			if (!last)
+			{
+				low.add(next);
+				bit.add(high + next);
+				if (next < TL_MIN || next >= timing.reset)
+				{
+					printf("frame %u: low time of %u nS\n", f, next);
+					errors++;
+				}
+			}
+			bits++;
+			if (++count == 8)
+			{
+				decoded.push_back(value);
+				count = 0;
+			}
+		}
+		frame.add(frameTime - timing.reset);
+		
+		// green, red, blue per led, scaled by brightness + 1 as Adafruit_NeoPixel does.
+		bool match = (decoded.size() == (size_t)LEDS * 3) && (count == 0);
+		for (uint8_t led = 0; match && led < LEDS; led++)
+		{
+			uint8_t expected[3] = {(uint8_t)(colors[led] >> 8), (uint8_t)(colors[led] >> 16), (uint8_t)colors[led]};
+			for (uint8_t c = 0; c < 3; c++)
+			{
+				match &= (decoded[led * 3 + c] == (uint8_t)((expected[c] * (scale + 1)) >> 8));
+			}
+		}
+		if (!match)
+		{
+			printf("frame %u: decoded colors differ from the frame\n", f);
+			errors++;
+		}
+	}
+	
+	printf("frames: %u, bits: %u, errors: %u\n", timing.frames, bits, errors);
+	printf("T0H: %u - %u nS (%u - %u)\n", zeroHigh.min, zeroHigh.max, T0H_MIN, T0H_MAX);
+	printf("T1H: %u - %u nS (%u - %u)\n", oneHigh.min, oneHigh.max, T1H_MIN, T1H_MAX);
+	printf("low: %u - %u nS (%u - %u)\n", low.min, low.max, TL_MIN, timing.reset);
+	printf("bit: %u - %u nS\n", bit.min, bit.max);
+	printf("frame: %.0f - %.0f uS with interrupts enabled, bit banged %.0f uS with interrupts disabled\n",
+		   frame.min / 1000.0, frame.max / 1000.0, BITBANG_FRAME / 1000.0);
+	
+	return (errors == 0) ? 0 : 1;
+}
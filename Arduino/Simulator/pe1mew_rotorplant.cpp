@@ -0,0 +1,134 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file pe1mew_rotorplant.cpp
+/// \brief Rotor model for the PE1MEW Rotor Controller simulator
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+/// \version 1.1	Jam and slip of the motor for the current sensor.
+
+#include "pe1mew_rotorplant.h"
+
+#include <math.h>
+
+static const double INTEGRATION_STEP = 0.001;	///< Largest integration step in seconds.
+
+PE1MEW_RotorPlant::PE1MEW_RotorPlant(const sPlantParameters& parameters, double position, uint32_t seed):
+	_Parameters(parameters),
+	_Position(position),
+	_Speed(0.0),
+	_Run(false),
+	_CW(false),
+	_PendingRun(false),
+	_PendingCW(false),
+	_PendingTime(0.0),
+	_StallTime(0.0),
+	_Jam(false),
+	_JamPosition(0.0),
+	_JamAbove(false),
+	_Random(seed),
+	_Wind(0.0, 1.0)
+{
+}
+
+void PE1MEW_RotorPlant::Process(bool run, bool cw, double seconds)
+{
+	if (run != _PendingRun || cw != _PendingCW)
+	{
+		_PendingRun = run;
+		_PendingCW = cw;
+		_PendingTime = _Parameters.relayLatency;
+	}
+	
+	while (seconds > 0.0)
+	{
+		double step = (seconds < INTEGRATION_STEP) ? seconds : INTEGRATION_STEP;
+		
+		if (_PendingTime > 0.0)
+		{
+			_PendingTime -= step;
+		}
+		if (_PendingTime <= 0.0)
+		{
+			_Run = _PendingRun;
+			_CW = _PendingCW;
+		}
+		
+		Step(step);
+		seconds -= step;
+	}
+}
+
+double PE1MEW_RotorPlant::getSlip(void) const
+{
+	if (!_Run)
+	{
+		return 0.0;
+	}
+	double speed = _CW ? _Parameters.speedCW : _Parameters.speedCCW;
+	double slip = 1.0 - fabs(_Speed) / speed;
+	return (slip < 0.0) ? 0.0 : slip;
+}
+
+void PE1MEW_RotorPlant::setJam(double position)
+{
+	_Jam = true;
+	_JamPosition = position;
+	_JamAbove = (_Position > position);
+}
+
+void PE1MEW_RotorPlant::Step(double seconds)
+{
+	double target = 0.0;
+	double timeConstant = _Parameters.coastTime;
+	
+	if (_Run)
+	{
+		target = _CW ? _Parameters.speedCW : -_Parameters.speedCCW;
+		timeConstant = _Parameters.spinUpTime;
+	}
+	
+	if (timeConstant > 0.0)
+	{
+		_Speed += (target - _Speed) * (1.0 - exp(-seconds / timeConstant));
+	}
+	else
+	{
+		_Speed = target;
+	}
+	
+	_Position += _Speed * (1.0 + _Parameters.windNoise * _Wind(_Random)) * seconds;
+	
+	if (_Position < _Parameters.endStopCCW)
+	{
+		_Position = _Parameters.endStopCCW;
+		_Speed = 0.0;
+		_StallTime += _Run ? seconds : 0.0;
+	}
+	else if (_Position > _Parameters.endStopCW)
+	{
+		_Position = _Parameters.endStopCW;
+		_Speed = 0.0;
+		_StallTime += _Run ? seconds : 0.0;
+	}
+	
+	if (_Jam && (_JamAbove ? (_Position < _JamPosition) : (_Position > _JamPosition)))
+	{
+		_Position = _JamPosition;
+		_Speed = 0.0;
+		_StallTime += _Run ? seconds : 0.0;
+	}
+}
@@ -0,0 +1,115 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file pe1mew_rotorplant.h
+/// \brief Rotor model for the PE1MEW Rotor Controller simulator
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+/// \version 1.1	Jam and slip of the motor for the current sensor.
+
+#ifndef PE1MEW_ROTORPLANT_H
+#define PE1MEW_ROTORPLANT_H
+
+#include <stdint.h>
+#include <random>
+
+/// \brief physical properties of a rotor.
+struct sPlantParameters
+{
+	double speedCW;			///< Speed when turning CW at full speed in degrees per second.
+	double speedCCW;		///< Speed when turning CCW at full speed in degrees per second.
+	double spinUpTime;		///< Time constant of the motor starting in seconds.
+	double coastTime;		///< Time constant of the motor stopping after the relay is released in seconds.
+	double relayLatency;	///< Time between a relay change and the effect on the motor in seconds.
+	double endStopCCW;		///< Mechanical end stop CCW in degrees.
+	double endStopCW;		///< Mechanical end stop CW in degrees.
+	double windNoise;		///< Standard deviation of the speed variation by wind load, relative to the speed.
+};
+
+/// \brief default rotor: 360 degrees in 36 seconds, quick relays, no wind.
+static const sPlantParameters PLANT_DEFAULT = { 10.0, 10.0, 0.15, 0.10, 0.008, -2.0, 362.0, 0.0 };
+
+/// \class PE1MEW_RotorPlant
+/// \brief Model of a rotor driven by the relays of the rotor controller.
+///
+/// Relay 1 switches the motor on, relay 2 selects CW. Both are active low (RELAY_ACTIVE).
+/// The speed follows the relays with a first order response, delayed by the relay latency,
+/// and is limited by the end stops.
+class PE1MEW_RotorPlant
+{
+public:
+	/// \brief constructor
+	/// \param parameters physical properties of the rotor.
+	/// \param position start position in degrees.
+	/// \param seed seed of the random generator of the wind load.
+	PE1MEW_RotorPlant(const sPlantParameters& parameters, double position, uint32_t seed);
+	
+	/// \brief advance the model.
+	/// \param run relay 1 is active: motor on.
+	/// \param cw relay 2 is active: turn CW.
+	/// \param seconds time to advance.
+	void Process(bool run, bool cw, double seconds);
+	
+	/// \brief get true position of the rotor.
+	/// \return position in degrees.
+	double getPosition(void) const {return _Position;}
+	
+	/// \brief get speed of the rotor.
+	/// \return speed in degrees per second, positive is CW.
+	double getSpeed(void) const {return _Speed;}
+	
+	/// \brief get the state of the motor after the relay latency.
+	/// \return true when the motor is on.
+	bool getMotorOn(void) const {return _Run;}
+	
+	/// \brief get the slip of the motor, which sets its current.
+	/// \return 0 at full speed up to 1 stalled, 0 when the motor is off.
+	double getSlip(void) const;
+	
+	/// \brief block the rotor at a position, as by ice or a cable caught in the mast.
+	/// The rotor cannot pass the position from the side it is on.
+	/// \param position in degrees.
+	void setJam(double position);
+	
+	/// \brief remove the jam.
+	void clearJam(void) {_Jam = false;}
+	
+	/// \brief get time the rotor was pushed against an end stop or a jam.
+	/// \return time in seconds.
+	double getStallTime(void) const {return _StallTime;}
+
+private:
+	sPlantParameters _Parameters;	///< Physical properties of the rotor.
+	double	_Position;				///< True position in degrees.
+	double	_Speed;					///< Speed in degrees per second, positive is CW.
+	bool	_Run;					///< Motor on after the relay latency.
+	bool	_CW;					///< Direction CW after the relay latency.
+	bool	_PendingRun;			///< Relay 1 state waiting for the relay latency.
+	bool	_PendingCW;				///< Relay 2 state waiting for the relay latency.
+	double	_PendingTime;			///< Time left before the pending relay states take effect.
+	double	_StallTime;				///< Time the rotor was pushed against an end stop or a jam.
+	bool	_Jam;					///< The rotor is blocked at _JamPosition.
+	double	_JamPosition;			///< Position of the jam in degrees.
+	bool	_JamAbove;				///< The rotor is CW of the jam.
+	std::mt19937 _Random;			///< Random generator of the wind load.
+	std::normal_distribution<double> _Wind;	///< Distribution of the wind load.
+	
+	/// \brief advance the model one integration step.
+	/// \param seconds step size.
+	void Step(double seconds);
+};
+
+#endif // PE1MEW_ROTORPLANT_H
@@ -0,0 +1,310 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file pe1mew_simulation.cpp
+/// \brief Rotor controller connected to a rotor model for the PE1MEW Rotor Controller simulator
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+/// \version 1.1	Buttons held at power-up, test and calibration by an operator.
+/// \version 1.2	Brightness in EEPROM.
+/// \version 1.3	Feedback potentiometer on the ADC.
+/// \version 1.4	Non-linear potentiometer and its linearisation table.
+/// \version 1.5	Motor current on the ADC.
+/// \version 1.6	Power cut.
+/// \version 1.7	Rotary encoder.
+
+#include "pe1mew_simulation.h"
+
+#include "Arduino.h"
+#include "EEPROM.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+PE1MEW_Simulation::PE1MEW_Simulation(const sPlantParameters& plant, uint16_t runtime, uint16_t direction, uint32_t seed,
+									 uint8_t buttons, uint8_t brightness):
+	_Controller(createController(runtime, direction, buttons, brightness)),
+	_Plant(plant, direction / 10.0, seed),
+	_Ticks(0),
+	_RunningTicks(0),
+	_RelayCycles(0),
+	_Relay1(false),
+	_Relay2(false),
+	_SensorConnected(false),
+	_Sensor(SENSOR_DEFAULT),
+	_CurrentConnected(false),
+	_Current(CURRENT_DEFAULT),
+	_SampleTime(0.0),
+	_SensorTable(),
+	_Random(seed ^ 0xADC0ADC0),
+	_Noise(0.0, 1.0)
+{
+}
+
+void PE1MEW_Simulation::setSensor(const sSensorParameters& sensor)
+{
+	_Sensor = sensor;
+	_SensorConnected = true;
+}
+
+void PE1MEW_Simulation::setCurrentSensor(const sCurrentParameters& current)
+{
+	_Current = current;
+	_CurrentConnected = true;
+}
+
+uint16_t PE1MEW_Simulation::getCurrentSample(void)
+{
+	double sample = 0.0;
+	
+	if (_Plant.getMotorOn())
+	{
+		sample = _Current.running + (_Current.stall - _Current.running) * _Plant.getSlip();
+	}
+	sample = floor(sample + _Current.noise * _Noise(_Random) + 0.5);
+	return (uint16_t)((sample < 0.0) ? 0.0 : (sample > 1023.0) ? 1023.0 : sample);
+}
+
+const sSensorTable* PE1MEW_Simulation::getSensorTable(void)
+{
+	for (uint8_t i = 0; i < SENSOR_TABLE_SIZE; i++)
+	{
+		double value = getSensorValue(i * SENSOR_TABLE_STEP / 10.0) * (1 << SENSOR_EXTRA_BITS);
+		value = (value < 0.0) ? 0.0 : (value > SENSOR_FULL_SCALE) ? SENSOR_FULL_SCALE : value;
+		_SensorTable.value[i] = (uint16_t)(value + 0.5);
+	}
+	return &_SensorTable;
+}
+
+double PE1MEW_Simulation::getSensorValue(double position) const
+{
+	double track = position / 360.0;
+	
+	track += _Sensor.nonlinearity * sin(2.0 * M_PI * track);
+	return _Sensor.low + (_Sensor.high - _Sensor.low) * track;
+}
+
+uint16_t PE1MEW_Simulation::getSample(double position)
+{
+	double sample = getSensorValue(position) + _Sensor.noise * _Noise(_Random);
+	
+	sample = floor(sample + 0.5);
+	return (uint16_t)((sample < 0.0) ? 0.0 : (sample > 1023.0) ? 1023.0 : sample);
+}
+
+PE1MEW_RotorController* PE1MEW_Simulation::createController(uint16_t runtime, uint16_t direction, uint8_t buttons, uint8_t brightness)
+{
+	Simulator::reset();
+	
+	EEPROM.write(0, 0x02);					// Memory initialized, direction in tenths of degrees
+	EEPROM.write(1, brightness);
+	EEPROM.write(2, (uint8_t)(direction >> 8));
+	EEPROM.write(3, (uint8_t)direction);
+	EEPROM.write(6, (uint8_t)(runtime >> 8));
+	EEPROM.write(7, (uint8_t)runtime);
+	setButtons(buttons);
+	
+	return new PE1MEW_RotorController();
+}
+
+void PE1MEW_Simulation::powerCut(bool warning)
+{
+#ifdef POWERWARNING
+	if (warning)
+	{
+		_Controller->powerFail();
+	}
+#else
+	(void)warning;
+#endif
+	_Controller.reset();
+	Simulator::serialInput.clear();
+	_Controller.reset(new PE1MEW_RotorController());
+}
+
+uint16_t PE1MEW_Simulation::getCalibratedRunTime(const sPlantParameters& plant)
+{
+	double speed = (plant.speedCW + plant.speedCCW) / 2.0;
+	return (uint16_t)(360.0 / speed * 1000000.0 / TICK + 0.5);
+}
+
+void PE1MEW_Simulation::Process(double interval)
+{
+	bool relay1 = (Simulator::pins[REL1_PIN] == RELAY_ACTIVE);
+	bool relay2 = (Simulator::pins[REL2_PIN] == RELAY_ACTIVE);
+	
+	double position = _Plant.getPosition();
+	
+	_Plant.Process(relay1, relay2, interval / 1000000.0);
+	Simulator::time += (uint64_t)interval;
+	
+	if (_SensorConnected)
+	{
+		// The conversions during the tick, at the position interpolated between the start and end of the tick.
+		double speed = (_Plant.getPosition() - position) / interval;
+		for (_SampleTime += interval; _SampleTime >= ADC_CONVERSION; _SampleTime -= ADC_CONVERSION)
+		{
+			PE1MEW_PositionSensor::addSample(getSample(_Plant.getPosition() - speed * (_SampleTime - ADC_CONVERSION)));
+		}
+	}
+	else if (_CurrentConnected)
+	{
+		// The conversions during the tick, at the current at the end of the tick.
+		for (_SampleTime += interval; _SampleTime >= ADC_CONVERSION; _SampleTime -= ADC_CONVERSION)
+		{
+			PE1MEW_CurrentSensor::addSample(getCurrentSample());
+		}
+	}
+	_Controller->Process();
+	_Ticks++;
+	
+	relay1 = (Simulator::pins[REL1_PIN] == RELAY_ACTIVE);
+	relay2 = (Simulator::pins[REL2_PIN] == RELAY_ACTIVE);
+	_RelayCycles += (relay1 && !_Relay1) ? 1 : 0;
+	_RelayCycles += (relay2 && !_Relay2) ? 1 : 0;
+	_RunningTicks += relay1 ? 1 : 0;
+	_Relay1 = relay1;
+	_Relay2 = relay2;
+}
+
+uint16_t PE1MEW_Simulation::Calibrate(uint32_t reaction)
+{
+	static const uint32_t PRESS = 20;					// ticks a button is pressed or released
+	static const uint32_t STALL_TIMEOUT = 0xFFFF;		// longest calibration of the controller
+	
+	if (_Controller->getRunState() != TEST_CALIBRATE)
+	{
+		return 0;
+	}
+	Press(BUTTON_NONE, PRESS);							// TCS1: release the buttons of power-up
+	Press(BUTTON_1, PRESS);
+	Press(BUTTON_BOTH, PRESS);							// to TCS2, switch test
+	Press(BUTTON_NONE, PRESS);
+	Press(BUTTON_1, PRESS);
+	Press(BUTTON_BOTH, PRESS);							// to TCS3, relay test
+	Press(BUTTON_NONE, PRESS);
+	Press(BUTTON_1, PRESS);								// relay 1 turns the motor CCW for a moment
+	Press(BUTTON_2, PRESS);
+	Press(BUTTON_BOTH, PRESS);							// to TCS4, memory test
+	Press(BUTTON_NONE, PRESS);
+	Press(BUTTON_1, PRESS);
+	Press(BUTTON_BOTH, PRESS);							// to TCS5, turn to CW end stop
+	Press(BUTTON_NONE, PRESS);
+	if (!PressUntilStall(BUTTON_1, reaction, STALL_TIMEOUT))
+	{
+		return 0;
+	}
+	Press(BUTTON_2, PRESS);
+	Press(BUTTON_BOTH, PRESS);							// to TCS6, calibrate
+	Press(BUTTON_NONE, PRESS);
+	Press(BUTTON_1, 1);									// start: the runtime counter starts at this tick
+	Press(BUTTON_NONE, 0);
+	if (!PressUntilStall(BUTTON_NONE, reaction, STALL_TIMEOUT))
+	{
+		return 0;
+	}
+	Press(BUTTON_2, 1);									// stop: the runtime counter stops at this tick
+	Press(BUTTON_BOTH, PRESS);							// save, to TCS7
+	Press(BUTTON_1, PRESS);
+	Press(BUTTON_NONE, PRESS);							// to normal operation
+	
+	if (_Controller->getRunState() != NORMAL)
+	{
+		return 0;
+	}
+	return ((uint16_t)EEPROM.read(6) << 8) | EEPROM.read(7);
+}
+
+void PE1MEW_Simulation::Press(uint8_t buttons, uint32_t ticks)
+{
+	setButtons(buttons);
+	for (uint32_t tick = 0; tick < ticks; tick++)
+	{
+		Process();
+	}
+}
+
+bool PE1MEW_Simulation::PressUntilStall(uint8_t buttons, uint32_t reaction, uint32_t timeout)
+{
+	double stallTime = _Plant.getStallTime();
+	
+	setButtons(buttons);
+	for (uint32_t tick = 0; tick < timeout; tick++)
+	{
+		Process();
+		if (_Plant.getStallTime() - stallTime >= reaction * (TICK / 1000000.0))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void PE1MEW_Simulation::setButtons(uint8_t buttons)
+{
+	Simulator::pins[SW2_PIN] = (buttons & BUTTON_1) ? HIGH : LOW;	// CCW
+	Simulator::pins[SW1_PIN] = (buttons & BUTTON_2) ? HIGH : LOW;	// CW
+}
+
+void PE1MEW_Simulation::setEncoder(uint8_t levels)
+{
+	uint8_t previous = ((Simulator::pins[ENCODER_A_PIN] == HIGH) ? 0x01 : 0x00) | ((Simulator::pins[ENCODER_B_PIN] == HIGH) ? 0x02 : 0x00);
+	
+	Simulator::pins[ENCODER_A_PIN] = (levels & 0x01) ? HIGH : LOW;
+	Simulator::pins[ENCODER_B_PIN] = (levels & 0x02) ? HIGH : LOW;
+#ifdef ROTARYENCODER
+	if (levels != previous)
+	{
+		PE1MEW_RotorSteering::addEncoderEdge(levels);
+	}
+#else
+	(void)previous;
+#endif
+}
+
+void PE1MEW_Simulation::Turn(int8_t detents, uint8_t bounces)
+{
+	static const uint8_t GRAY[4] = { 0x00, 0x01, 0x03, 0x02 };	// levels of A and B turning CW
+	
+	uint8_t levels = ((Simulator::pins[ENCODER_A_PIN] == HIGH) ? 0x01 : 0x00) | ((Simulator::pins[ENCODER_B_PIN] == HIGH) ? 0x02 : 0x00);
+	uint8_t index = 0;
+	while (GRAY[index] != levels)
+	{
+		index++;
+	}
+	
+	for (int edge = 0; edge < abs(detents) * (int)ENCODER_EDGES; edge++)
+	{
+		uint8_t next = (detents > 0) ? (index + 1) & 0x03 : (index + 3) & 0x03;
+		for (uint8_t bounce = 0; bounce < bounces; bounce++)
+		{
+			setEncoder(GRAY[next]);
+			setEncoder(GRAY[index]);
+		}
+		setEncoder(GRAY[next]);
+		index = next;
+	}
+}
+
+void PE1MEW_Simulation::setEncoderSwitch(bool pushed)
+{
+	Simulator::pins[ENCODER_SWITCH_PIN] = pushed ? LOW : HIGH;
+}
+
+void PE1MEW_Simulation::sendCommand(const char* command)
+{
+	Simulator::serialInput += command;
+}
@@ -0,0 +1,224 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file pe1mew_simulation.h
+/// \brief Rotor controller connected to a rotor model for the PE1MEW Rotor Controller simulator
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+/// \version 1.1	Buttons held at power-up, test and calibration by an operator.
+/// \version 1.2	Brightness in EEPROM.
+/// \version 1.3	Feedback potentiometer on the ADC.
+/// \version 1.4	Non-linear potentiometer and its linearisation table.
+/// \version 1.5	Motor current on the ADC.
+/// \version 1.6	Power cut.
+/// \version 1.7	Rotary encoder.
+
+#ifndef PE1MEW_SIMULATION_H
+#define PE1MEW_SIMULATION_H
+
+#include <stdint.h>
+#include <memory>
+#include <random>
+
+#include "pe1mew_rotorplant.h"
+#include "pe1mew_rotorcontroller.h"
+
+/// \brief properties of a feedback potentiometer on the ADC.
+struct sSensorParameters
+{
+	double low;				///< ADC value at 0 degrees.
+	double high;			///< ADC value at 360 degrees.
+	double noise;			///< Standard deviation of the noise of each sample in ADC steps.
+	double nonlinearity;	///< Amplitude of a sine error of the track over one turn, relative to the range from low to high.
+};
+
+/// \brief linear potentiometer over the full range of the ADC with one step of noise.
+static const sSensorParameters SENSOR_DEFAULT = { 0.0, 1023.0, 1.0, 0.0 };
+
+/// \brief properties of the current sense voltage of the motor on the ADC.
+/// The current rises linearly with the slip of the motor from the running current at full speed
+/// to the stall current: at the start, against an end stop or a jam.
+struct sCurrentParameters
+{
+	double running;			///< ADC value of the running motor at full speed.
+	double stall;			///< ADC value of the stalled motor.
+	double noise;			///< Standard deviation of the noise of each sample in ADC steps.
+};
+
+/// \brief a motor that takes three times its running current when stalled.
+static const sCurrentParameters CURRENT_DEFAULT = { 200.0, 600.0, 4.0 };
+
+/// \class PE1MEW_Simulation
+/// \brief A rotor controller with its buttons, serial port and relays connected to a PE1MEW_RotorPlant.
+///
+/// The constructor resets the simulated hardware of the calling thread and writes the EEPROM
+/// before the controller is created, as after programming a calibrated controller.
+/// One simulation per thread: all simulations of a thread share the simulated hardware.
+/// The controller runs on the virtual clock of Simulator: hours of controller time take seconds
+/// and a run depends only on its settings and seed.
+class PE1MEW_Simulation
+{
+public:
+	static const uint32_t TICK = 10000;		///< Sys tick of the rotor controller in uS.
+	static constexpr double ADC_CONVERSION = 13.0 * 128.0 / 8.0;	///< Conversion time of the ADC in free running mode in uS.
+
+	/// \brief constructor
+	/// \param plant physical properties of the rotor.
+	/// \param runtime runtime written in EEPROM in ticks per 360 degrees, see getCalibratedRunTime().
+	/// \param direction direction written in EEPROM and start position of the rotor in tenths of degrees.
+	/// \param seed seed of the random generator of the rotor model.
+	/// \param buttons buttons held at power-up as eButtonState, BUTTON_BOTH starts the test and calibration mode.
+	/// \param brightness brightness written in EEPROM.
+	PE1MEW_Simulation(const sPlantParameters& plant, uint16_t runtime, uint16_t direction, uint32_t seed,
+					  uint8_t buttons = BUTTON_NONE, uint8_t brightness = 200);
+
+	/// \brief connect a feedback potentiometer to the ADC.
+	/// The samples are added to PE1MEW_PositionSensor as by the ADC interrupt, they are only used by
+	/// a controller build with POSITIONSENSOR defined.
+	/// \param sensor properties of the potentiometer.
+	void setSensor(const sSensorParameters& sensor);
+
+	/// \brief connect the current sense voltage of the motor to the ADC.
+	/// The samples are added to PE1MEW_CurrentSensor as by the ADC interrupt, they are only used by
+	/// a controller build with CURRENTSENSOR defined.
+	/// \param current properties of the current sense voltage.
+	void setCurrentSensor(const sCurrentParameters& current);
+
+	/// \brief block the rotor at a position, see PE1MEW_RotorPlant::setJam().
+	/// \param position in degrees.
+	void setJam(double position) {_Plant.setJam(position);}
+
+	/// \brief remove the jam.
+	void clearJam(void) {_Plant.clearJam();}
+
+	/// \brief cut the power and start the controller again on the EEPROM left.
+	/// The rotor model keeps its position, the controller starts as after power-up.
+	/// \param warning the power warning interrupt ran before the power was lost, only used by a
+	/// controller build with POWERWARNING defined.
+	void powerCut(bool warning);
+
+	/// \brief get the linearisation table of the potentiometer, as measured without noise.
+	/// The table is kept by the simulation, the controller may be set to use it.
+	/// \return table of the potentiometer connected with setSensor().
+	const sSensorTable* getSensorTable(void);
+
+	/// \brief get the runtime that the test and calibration mode would measure on a rotor.
+	/// \param plant physical properties of the rotor.
+	/// \return runtime in ticks per 360 degrees.
+	static uint16_t getCalibratedRunTime(const sPlantParameters& plant);
+
+	/// \brief advance the rotor model and the clock by an interval, then run one sys tick of the controller.
+	/// \param interval time since the previous sys tick in uS, TICK without jitter.
+	void Process(double interval = TICK);
+
+	/// \brief press or release the buttons.
+	/// \param buttons pressed buttons as eButtonState.
+	static void setButtons(uint8_t buttons);
+
+	/// \brief set the outputs of the rotary encoder.
+	/// A change is added to PE1MEW_RotorSteering as by the pin change interrupt, only by a controller
+	/// build with ROTARYENCODER defined.
+	/// \param levels level of output A in bit 0 and of output B in bit 1.
+	static void setEncoder(uint8_t levels);
+
+	/// \brief turn the rotary encoder before the next sys tick.
+	/// \param detents detents turned, positive CW.
+	/// \param bounces times each contact bounces back to its previous level before it settles.
+	static void Turn(int8_t detents, uint8_t bounces = 0);
+
+	/// \brief push or release the switch of the rotary encoder.
+	/// \param pushed switch closed.
+	static void setEncoderSwitch(bool pushed);
+
+	/// \brief hold buttons for a number of ticks.
+	/// \param buttons pressed buttons as eButtonState.
+	/// \param ticks sys ticks to run.
+	void Press(uint8_t buttons, uint32_t ticks);
+
+	/// \brief send a command to the serial port of the controller.
+	/// \param command command including the line end.
+	void sendCommand(const char* command);
+
+	/// \brief run the test and calibration mode as an operator would.
+	/// All steps TCS1 to TCS7 are taken. In TCS5 the rotor is turned CW until it stalls at the end stop,
+	/// in TCS6 the runtime is measured until it stalls at the CCW end stop. The simulation shall be
+	/// created with BUTTON_BOTH held at power-up.
+	/// \param reaction time the operator needs to notice that the rotor stalls in ticks.
+	/// \return runtime saved by the controller, 0 when the controller did not return to normal operation.
+	uint16_t Calibrate(uint32_t reaction);
+
+	/// \brief get the rotor controller.
+	/// \return controller
+	PE1MEW_RotorController& getController(void) {return *_Controller;}
+
+	/// \brief get the rotor model.
+	/// \return rotor model
+	const PE1MEW_RotorPlant& getPlant(void) const {return _Plant;}
+
+	/// \brief get the number of sys ticks run.
+	/// \return ticks
+	uint32_t getTicks(void) const {return _Ticks;}
+
+	/// \brief get the number of sys ticks the motor relay was active.
+	/// \return ticks
+	uint32_t getRunningTicks(void) const {return _RunningTicks;}
+
+	/// \brief get the number of times a relay was activated, both relays counted.
+	/// \return relay cycles
+	uint32_t getRelayCycles(void) const {return _RelayCycles;}
+
+private:
+	std::unique_ptr<PE1MEW_RotorController> _Controller;	///< Controller, created after the EEPROM is written.
+	PE1MEW_RotorPlant _Plant;		///< Rotor model driven by the relays.
+	uint32_t _Ticks;				///< Sys ticks run.
+	uint32_t _RunningTicks;			///< Sys ticks with the motor relay active.
+	uint32_t _RelayCycles;			///< Relay activations.
+	bool	 _Relay1;				///< Relay 1 active at the previous sys tick.
+	bool	 _Relay2;				///< Relay 2 active at the previous sys tick.
+	bool	 _SensorConnected;		///< A potentiometer is connected to the ADC.
+	sSensorParameters _Sensor;		///< Properties of the potentiometer.
+	bool	 _CurrentConnected;		///< The current sense voltage is connected to the ADC.
+	sCurrentParameters _Current;	///< Properties of the current sense voltage.
+	double	 _SampleTime;			///< Time since the last conversion of the ADC in uS.
+	sSensorTable _SensorTable;		///< Linearisation table of the potentiometer.
+	std::mt19937 _Random;			///< Random generator of the ADC noise.
+	std::normal_distribution<double> _Noise;	///< Distribution of the ADC noise.
+
+	/// \brief reset the simulated hardware, write the EEPROM and hold the buttons.
+	/// \return controller created on the written EEPROM.
+	static PE1MEW_RotorController* createController(uint16_t runtime, uint16_t direction, uint8_t buttons, uint8_t brightness);
+
+
+	/// \brief get the voltage of the potentiometer.
+	/// \param position in degrees.
+	/// \return value in ADC steps without noise and quantization.
+	double getSensorValue(double position) const;
+
+	/// \brief convert the current of the motor of the rotor model.
+	/// \return 10 bit sample of the ADC.
+	uint16_t getCurrentSample(void);
+
+	/// \brief convert a position of the rotor model.
+	/// \param position in degrees.
+	/// \return 10 bit sample of the ADC.
+	uint16_t getSample(double position);
+
+	/// \brief hold buttons until the rotor stalls against an end stop.
+	/// \return true when the rotor stalled within the timeout.
+	bool PressUntilStall(uint8_t buttons, uint32_t reaction, uint32_t timeout);
+};
+
+#endif // PE1MEW_SIMULATION_H
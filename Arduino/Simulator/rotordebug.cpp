@@ -0,0 +1,193 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file rotordebug.cpp
+/// \brief Decoder of the debug logger of the PE1MEW Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+///
+/// Reads the output of the serial port, from a file or standard input, and prints the text of the
+/// controller and the messages of the debug logger. A byte from 0x80 is the token of a message and
+/// is followed by its arguments; the formats are taken from DEBUGLOG_MESSAGES in pe1mew_debuglog.h,
+/// the firmware does not contain them. The output of a build with the same messages is decoded.
+
+#include "pe1mew_debuglog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/// \brief message of the debug logger as known by the decoder.
+struct sMessage
+{
+	const char* name;		///< Name in DEBUGLOG_MESSAGES.
+	uint8_t     level;		///< eDebugLevel
+	uint8_t     arguments;	///< Number of 16 bit arguments.
+	const char* format;		///< Format of the text.
+};
+
+#define DECODER_MESSAGE(name, level, arguments, format)	{ #name, level, arguments, format },
+static const sMessage MESSAGES[] = { DEBUGLOG_MESSAGES(DECODER_MESSAGE) };
+#undef DECODER_MESSAGE
+
+static const uint8_t MESSAGE_COUNT = sizeof(MESSAGES) / sizeof(MESSAGES[0]);
+static const char* LEVEL_NAMES[] = { "", "error", "warning", "info", "debug" };
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options] [FILE]\n"
+		   "  --level N       print the messages up to level N: 1 error, 2 warning, 3 info, 4 debug (4)\n"
+		   "  --no-text       print the messages only, not the text of the controller\n"
+		   "  FILE            output of the serial port, standard input when not given\n", name);
+}
+
+/// \brief format the arguments of a message.
+/// \param message message
+/// \param arguments its arguments.
+/// \return text of the message.
+static std::string format(const sMessage& message, const uint16_t* arguments)
+{
+	std::string text;
+	char field[16];
+	uint8_t next = 0;
+	
+	for (const char* c = message.format; *c; c++)
+	{
+		if (*c != '%' || c[1] == '\0' || next >= message.arguments)
+		{
+			text += *c;
+			continue;
+		}
+		uint16_t value = arguments[next++];
+		switch (*++c)
+		{
+			case 'd': snprintf(field, sizeof(field), "%d", (int16_t)value); break;
+			case 'x': snprintf(field, sizeof(field), "%02X", value); break;
+			case 'c': snprintf(field, sizeof(field), "%c", (char)value); break;
+			case 't': snprintf(field, sizeof(field), "%u.%u", value / 10, value % 10); break;
+			default:  snprintf(field, sizeof(field), "%u", value); break;
+		}
+		text += field;
+	}
+	return text;
+}
+
+int main(int argc, char* argv[])
+{
+	uint8_t level = LEVEL_DEBUG;
+	bool text = true;
+	const char* name = 0;
+	
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--level") && i + 1 < argc) { level = (uint8_t)strtoul(argv[++i], 0, 0); }
+		else if (!strcmp(argv[i], "--no-text"))         { text = false; }
+		else if (argv[i][0] != '-' && !name)            { name = argv[i]; }
+		else { usage(argv[0]); return 1; }
+	}
+	
+	FILE* file = name ? fopen(name, "rb") : stdin;
+	if (!file)
+	{
+		printf("can not open %s\n", name);
+		return 1;
+	}
+	std::vector<uint8_t> data;
+	int value;
+	while ((value = fgetc(file)) != EOF)
+	{
+		data.push_back((uint8_t)value);
+	}
+	if (name)
+	{
+		fclose(file);
+	}
+	
+	// Text is collected per line, so a message sent while a line was sent is printed before it.
+	std::string line;
+	uint32_t counts[MESSAGE_COUNT] = {};
+	uint32_t unknown = 0;
+	bool truncated = false;
+	
+	for (size_t i = 0; i < data.size(); )
+	{
+		uint8_t byte = data[i++];
+		if (byte < 0x80)
+		{
+			if (byte == '\n')
+			{
+				if (text)
+				{
+					printf("%s\n", line.c_str());
+				}
+				line.clear();
+			}
+			else if (byte != '\r')
+			{
+				line += (char)byte;
+			}
+			continue;
+		}
+		
+		if (byte <= DEBUG_TOKEN_BASE || byte >= DEBUG_TOKEN_END)
+		{
+			unknown++;								// A build with other messages, or a binary export.
+			continue;
+		}
+		const sMessage& message = MESSAGES[byte - DEBUG_TOKEN_BASE - 1];
+		if (i + 2 * message.arguments > data.size())
+		{
+			truncated = true;
+			break;
+		}
+		uint16_t arguments[2] = {};
+		for (uint8_t a = 0; a < message.arguments && a < 2; a++, i += 2)
+		{
+			arguments[a] = data[i] | (data[i + 1] << 8);
+		}
+		counts[byte - DEBUG_TOKEN_BASE - 1]++;
+		if (message.level <= level)
+		{
+			printf("[%s] %s\n", LEVEL_NAMES[message.level], format(message, arguments).c_str());
+		}
+	}
+	if (text && !line.empty())
+	{
+		printf("%s\n", line.c_str());
+	}
+	
+	printf("--- messages:");
+	for (uint8_t m = 0; m < MESSAGE_COUNT; m++)
+	{
+		if (counts[m] > 0)
+		{
+			printf(" %s %u", MESSAGES[m].name, counts[m]);
+		}
+	}
+	printf("\n");
+	if (unknown > 0)
+	{
+		printf("--- %u unknown tokens\n", unknown);
+	}
+	if (truncated)
+	{
+		printf("--- last message truncated\n");
+		return 1;
+	}
+	return 0;
+}
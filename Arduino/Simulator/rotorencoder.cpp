@@ -0,0 +1,260 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file rotorencoder.cpp
+/// \brief Rotary encoder test of the PE1MEW Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+///
+/// The controller shall be build with ROTARYENCODER defined. First a pulse stream with bouncing
+/// contacts is decoded: detents turned slowly shall step exactly ENCODER_INCREMENT each, and with the
+/// push switch held ENCODER_INCREMENT_PUSHED. Then an operator model dials a session of headings
+/// with the encoder. The operator sees the display with a reaction time and expects it to move on as
+/// it moved before. It turns fast while far from the heading, slower as the display comes closer and
+/// at 3/4 of the rate each time it passed the heading. Close to the heading it turns single detents,
+/// watching the display for the reaction time after each.
+
+#include "pe1mew_simulation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const uint32_t DIAL_TIMEOUT = 6000;		///< Maximum number of ticks to dial one heading.
+static const uint32_t FLICK_TICKS = 5;		///< Ticks per detent of a fast turn.
+static const uint32_t WATCH_TICKS = 10;		///< Ticks over which the operator sees the display move.
+static const int      FINE_ZONE = 30;			///< Distance in tenths of degrees below which the operator turns single detents.
+static const int      TOLERANCE = ENCODER_INCREMENT / 2;	///< Distance in tenths of degrees the operator accepts.
+static const double   SLOW_RATE = 4.0;			///< Detents per second of the operator at the fine zone.
+static const double   TICKS_PER_SECOND = 1000000.0 / PE1MEW_Simulation::TICK;
+
+/// \brief settings of an encoder test.
+struct sSession
+{
+	uint32_t seed;			///< Seed of the session.
+	uint32_t headings;		///< Number of headings dialed.
+	uint32_t reaction;		///< Reaction time of the operator in ticks.
+	double   rate;			///< Largest rate of turning of the operator in detents per second.
+	double   gain;			///< Rate of turning per degree from the heading in detents per second.
+	uint8_t  bounces;		///< Bounces of the contacts at each edge.
+	double   maxDial;		///< Largest mean dial time in seconds, 0 is no limit.
+};
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+		   "  --seed N        seed of the session (1)\n"
+		   "  --headings N    headings dialed (200)\n"
+		   "  --reaction N    reaction time of the operator in ticks (25)\n"
+		   "  --rate R        largest rate of turning in detents per second (20)\n"
+		   "  --gain G        rate of turning per degree from the heading (1.6)\n"
+		   "  --bounces N     bounces of the contacts at each edge (2)\n"
+		   "  --max-dial S    exit status 1 when the mean dial time exceeds S seconds\n", name);
+}
+
+/// \brief turn the encoder at a rate for a number of detents.
+/// \return next direction afterwards in tenths of degrees.
+static uint16_t turn(PE1MEW_Simulation& simulation, int detents, uint32_t ticksPerDetent, uint8_t bounces)
+{
+	for (int i = 0; i < abs(detents); i++)
+	{
+		simulation.Turn((detents > 0) ? 1 : -1, bounces);
+		for (uint32_t tick = 0; tick < ticksPerDetent; tick++)
+		{
+			simulation.Process();
+		}
+	}
+	return simulation.getController().getNextDirection();
+}
+
+/// \brief decode slowly turned detents with bouncing contacts.
+/// \return true when every detent stepped as expected.
+static bool decodeTest(uint8_t bounces)
+{
+	uint16_t runtime = PE1MEW_Simulation::getCalibratedRunTime(PLANT_DEFAULT);
+	PE1MEW_Simulation simulation(PLANT_DEFAULT, runtime, 1800, 1);
+	bool pass = true;
+	uint16_t next;
+	
+	next = turn(simulation, 20, 50, bounces);
+	printf("20 detents CW:  %5.1f degrees, expected %5.1f\n", next / 10.0, (1800 + 20 * ENCODER_INCREMENT) / 10.0);
+	pass &= (next == 1800 + 20 * ENCODER_INCREMENT);
+	
+	next = turn(simulation, -20, 50, bounces);
+	printf("20 detents CCW: %5.1f degrees, expected %5.1f\n", next / 10.0, 1800 / 10.0);
+	pass &= (next == 1800);
+	
+	simulation.setEncoderSwitch(true);
+	next = turn(simulation, 3, 50, bounces);
+	simulation.setEncoderSwitch(false);
+	printf("3 detents CW pushed: %5.1f degrees, expected %5.1f\n", next / 10.0, (1800 + 3 * ENCODER_INCREMENT_PUSHED) / 10.0);
+	pass &= (next == 1800 + 3 * ENCODER_INCREMENT_PUSHED);
+	
+	next = turn(simulation, -24, 1, bounces);
+	printf("24 detents CCW in 0.24 s: %5.1f degrees\n", next / 10.0);
+	
+	uint32_t ticks = 0;
+	while (next < 1800)
+	{
+		next = turn(simulation, 1, FLICK_TICKS, bounces);
+		ticks += FLICK_TICKS;
+	}
+	printf("0 to 180 degrees at %.0f detents per second: %.2f s\n", TICKS_PER_SECOND / FLICK_TICKS, ticks / TICKS_PER_SECOND);
+	return pass;
+}
+
+/// \brief dial a heading with the encoder as an operator would.
+/// \return ticks from the start of dialing to the last detent, DIAL_TIMEOUT when the heading was not reached.
+static uint32_t dial(PE1MEW_Simulation& simulation, uint16_t heading, const sSession& session, uint32_t& detents)
+{
+	std::vector<int> shown;
+	double phase = 0.0;
+	double limit = session.rate;
+	int turning = 0;
+	uint32_t wait = 0;
+	uint32_t stable = 0;
+	uint32_t ticks = 0;
+	uint32_t lastDetent = 0;
+	
+	for (ticks = 0; ticks < DIAL_TIMEOUT && stable <= session.reaction; ticks++)
+	{
+		// The display as seen reaction ticks ago, moved on as it moved in the WATCH_TICKS before.
+		shown.push_back(simulation.getController().getNextDirection());
+		int seen = shown[(ticks > session.reaction) ? ticks - session.reaction : 0];
+		int before = shown[(ticks > session.reaction + WATCH_TICKS) ? ticks - session.reaction - WATCH_TICKS : 0];
+		int distance = (int)heading - seen;
+		int ahead = (int)heading - (seen + (seen - before) * (int)session.reaction / (int)WATCH_TICKS);
+		int toward = (distance > 0) ? 1 : -1;
+		int step = 0;
+		
+		if (abs(distance) <= TOLERANCE)
+		{
+			stable++;
+		}
+		else if (abs(distance) >= FINE_ZONE && abs(ahead) >= FINE_ZONE)
+		{
+			toward = (ahead > 0) ? 1 : -1;
+			if (turning != 0 && turning != toward)
+			{
+				limit = (limit * 0.75 > SLOW_RATE) ? limit * 0.75 : SLOW_RATE;	// passed the heading, turn back slower
+			}
+			turning = toward;
+			stable = 0;
+			double rate = abs(ahead) / 10.0 * session.gain;
+			rate = (rate > limit) ? limit : ((rate < SLOW_RATE) ? SLOW_RATE : rate);
+			phase += rate / TICKS_PER_SECOND;
+			step = (int)phase * toward;
+			phase -= (int)phase;
+		}
+		else
+		{
+			stable = 0;
+			if (wait > 0)
+			{
+				wait--;
+			}
+			else
+			{
+				step = toward;				// one detent, then watch
+				wait = session.reaction;
+			}
+		}
+		
+		if (step != 0)
+		{
+			simulation.Turn((int8_t)step, session.bounces);
+			detents += abs(step);
+			lastDetent = ticks;
+		}
+		simulation.Process();
+	}
+	return (ticks < DIAL_TIMEOUT) ? lastDetent : DIAL_TIMEOUT;
+}
+
+int main(int argc, char* argv[])
+{
+	sSession session = { 1, 200, 25, 20.0, 1.6, 2, 0.0 };
+	
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : "0";
+		
+		if      (!strcmp(option, "--seed"))     { session.seed = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--headings")) { session.headings = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--reaction")) { session.reaction = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--rate"))     { session.rate = atof(value); i++; }
+		else if (!strcmp(option, "--gain"))     { session.gain = atof(value); i++; }
+		else if (!strcmp(option, "--bounces"))  { session.bounces = (uint8_t)strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--max-dial")) { session.maxDial = atof(value); i++; }
+		else { usage(argv[0]); return 1; }
+	}
+	
+#ifndef ROTARYENCODER
+	printf("build with -DROTARYENCODER\n");
+	return 1;
+#endif
+	
+	bool pass = decodeTest(session.bounces);
+	
+	uint16_t runtime = PE1MEW_Simulation::getCalibratedRunTime(PLANT_DEFAULT);
+	PE1MEW_Simulation simulation(PLANT_DEFAULT, runtime, 1800, session.seed);
+	simulation.Process();
+	std::mt19937 random(session.seed);
+	std::uniform_int_distribution<int> direction(0, 3600);
+	std::vector<double> dials;
+	uint32_t timeouts = 0, detents = 0;
+	double dialSum = 0.0;
+	
+	for (uint32_t i = 0; i < session.headings; i++)
+	{
+		uint16_t heading = (uint16_t)direction(random);
+		int distance = abs((int)heading - (int)simulation.getController().getNextDirection());
+		uint32_t ticks = dial(simulation, heading, session, detents);
+		timeouts += (ticks == DIAL_TIMEOUT) ? 1 : 0;
+		dialSum += ticks / TICKS_PER_SECOND;
+		if (distance >= 900)
+		{
+			dials.push_back(ticks / TICKS_PER_SECOND);
+		}
+	}
+	
+	std::sort(dials.begin(), dials.end());
+	uint32_t headings = (session.headings > 0) ? session.headings : 1;
+	printf("headings %u, timeouts %u, detents per heading %.1f\n", session.headings, timeouts, (double)detents / headings);
+	printf("dial time: mean %.2f s", dialSum / headings);
+	if (!dials.empty())
+	{
+		printf(", 90 degrees or more: median %.2f, max %.2f s", dials[dials.size() / 2], dials.back());
+	}
+	printf("\n");
+	
+	if (!pass)
+	{
+		printf("decoded detents differ\n");
+		return 1;
+	}
+	if (session.maxDial > 0.0 && dialSum / headings > session.maxDial)
+	{
+		printf("mean dial time exceeds %.2f s\n", session.maxDial);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,145 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file rotorlog.cpp
+/// \brief Decoder of the move log of the PE1MEW Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+///
+/// Reads the binary export of the move log, as send by the controller on the serial command L,
+/// from a file or standard input. Bytes before the export are skipped, so the output of the serial
+/// port can be captured from before the command. The moves are printed as comma separated values
+/// with --csv, followed by the duty cycle of the motor and the pointing statistics of the moves.
+
+#include "pe1mew_movelog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+static const double TICK_SECONDS = 0.01;	///< Sys tick of the rotor controller in seconds.
+
+/// \brief move as logged by the controller.
+struct sMove
+{
+	double   start;		///< Direction at the start in degrees.
+	double   target;	///< Target in degrees.
+	double   stop;		///< Direction at the end in degrees.
+	double   duration;	///< Duration in seconds.
+	double   idle;		///< Seconds since the previous move.
+	bool     cw;		///< Target CW of the start.
+	uint8_t  cycles;	///< Relay cycles.
+};
+
+static void usage(const char* name)
+{
+	printf("usage: %s [--csv] [FILE]\n"
+		   "  --csv           print every move\n"
+		   "  FILE            export of the move log, standard input when not given\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+	bool csv = false;
+	const char* name = 0;
+	
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--csv"))  { csv = true; }
+		else if (argv[i][0] != '-' && !name) { name = argv[i]; }
+		else { usage(argv[0]); return 1; }
+	}
+	
+	FILE* file = name ? fopen(name, "rb") : stdin;
+	if (!file)
+	{
+		printf("can not open %s\n", name);
+		return 1;
+	}
+	std::vector<uint8_t> data;
+	int value;
+	while ((value = fgetc(file)) != EOF)
+	{
+		data.push_back((uint8_t)value);
+	}
+	if (name)
+	{
+		fclose(file);
+	}
+	
+	// Find the start of the export: 'L', the format and a number of moves that fits in the data.
+	size_t begin = 0;
+	while (begin + 3 <= data.size() && !(data[begin] == 'L' && data[begin + 1] == LOG_FORMAT &&
+		   data[begin + 2] <= LOG_SLOTS && begin + 3 + data[begin + 2] * LOG_RECORD_SIZE <= data.size()))
+	{
+		begin++;
+	}
+	if (begin + 3 > data.size())
+	{
+		printf("no move log found\n");
+		return 1;
+	}
+	
+	std::vector<sMove> moves;
+	const uint8_t* record = &data[begin + 3];
+	for (uint8_t i = 0; i < data[begin + 2]; i++, record += LOG_RECORD_SIZE)
+	{
+		sMove move;
+		move.start = ((record[0] << 8) | record[1]) / 10.0;
+		move.target = ((record[2] << 8) | record[3]) / 10.0;
+		move.stop = ((record[4] << 8) | record[5]) / 10.0;
+		move.duration = ((record[6] << 8) | record[7]) * TICK_SECONDS;
+		move.idle = (record[8] << 8) | record[9];
+		move.cw = (record[10] & LOG_CW) != 0;
+		move.cycles = record[10] & LOG_CYCLES_MAX;
+		moves.push_back(move);
+	}
+	
+	if (csv)
+	{
+		printf("move,start,target,stop,error,duration,idle,direction,relay cycles\n");
+	}
+	
+	double runTime = 0.0, idleTime = 0.0, travel = 0.0, errorSum = 0.0, errorMax = 0.0;
+	uint32_t cycles = 0;
+	for (size_t i = 0; i < moves.size(); i++)
+	{
+		const sMove& move = moves[i];
+		double error = move.stop - move.target;
+		
+		if (csv)
+		{
+			printf("%u,%.1f,%.1f,%.1f,%.1f,%.2f,%.0f,%s,%u\n", (unsigned)i, move.start, move.target, move.stop,
+				   error, move.duration, move.idle, move.cw ? "CW" : "CCW", move.cycles);
+		}
+		runTime += move.duration;
+		idleTime += (i > 0) ? move.idle : 0.0;		// the idle time before the first move is not in the log
+		travel += fabs(move.stop - move.start);
+		errorSum += fabs(error);
+		errorMax = (fabs(error) > errorMax) ? fabs(error) : errorMax;
+		cycles += move.cycles;
+	}
+	
+	size_t count = (moves.size() > 0) ? moves.size() : 1;
+	printf("moves %u, %.0f degrees of travel\n", (unsigned)moves.size(), travel);
+	printf("motor on %.1f s of %.1f s, duty cycle %.1f%%\n", runTime, runTime + idleTime,
+		   100.0 * runTime / ((runTime + idleTime > 0.0) ? runTime + idleTime : 1.0));
+	printf("direction at the end against the target: mean %.2f, max %.2f degrees\n", errorSum / count, errorMax);
+	printf("relay cycles: %u, %.2f per move\n", cycles, (double)cycles / count);
+	return 0;
+}
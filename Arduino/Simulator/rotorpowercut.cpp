@@ -0,0 +1,208 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file rotorpowercut.cpp
+/// \brief Power cut test of the journal of the PE1MEW Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+/// \version 1.1	Power cut during the write test of the EEPROM self-test.
+///
+/// Each trial makes a few moves, starts an other move and cuts the power at a random tick of it.
+/// The controller is then started again on the EEPROM left and its direction is compared with
+/// the position of the rotor model. Optionally the byte that was written during the last tick is 
+/// corrupted, as when the power is lost during the EEPROM write, or the power warning interrupt 
+/// runs before the power is lost. With --selftest the write test of the EEPROM self-test runs 
+/// during the move and the configuration cells are compared with their values before the test.
+
+#include "pe1mew_simulation.h"
+#include "EEPROM.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <random>
+
+static const uint32_t MOVE_TIMEOUT = 100000;	///< Maximum number of ticks for one move.
+static const uint32_t RESTART_TICKS = 100;		///< Ticks run after the restart, the rotor coasts to a stop.
+
+/// \brief settings of a power cut test.
+struct sSession
+{
+	uint32_t seed;			///< Seed of all random generators.
+	uint32_t trials;		///< Number of power cuts.
+	bool     warning;		///< The power warning interrupt runs before the power is lost.
+	double   torn;			///< Probability that the byte written in the last tick is corrupted.
+	double   maxError;		///< Largest error of the restored direction in degrees, 0 is no limit.
+	bool     selfTest;		///< The write test of the EEPROM self-test runs during the move.
+};
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+		   "  --seed N        seed of the random generators (1)\n"
+		   "  --trials N      number of power cuts (1000)\n"
+		   "  --warning       the power warning runs before the power is lost,\n"
+		   "                  the controller shall be build with -DPOWERWARNING\n"
+		   "  --torn P        probability that the byte in the last tick is corrupted (0.5)\n"
+		   "  --max-error D   exit status 1 when a restored direction is more than D degrees off\n"
+		   "  --selftest      the EEPROM self-test writes during the move, exit status 1 when\n"
+		   "                  the brightness or the runtime differs after the restart\n", name);
+}
+
+/// \brief send a direction and run until the rotor stopped.
+/// \param simulation simulation to run.
+/// \param direction in tenths of degrees.
+static void move(PE1MEW_Simulation& simulation, int direction)
+{
+	char command[16];
+	snprintf(command, sizeof(command), "D%d.%d\n", direction / 10, direction % 10);
+	simulation.sendCommand(command);
+	
+	uint32_t idle = 0;
+	for (uint32_t tick = 0; tick < MOVE_TIMEOUT && idle < 20; tick++)
+	{
+		simulation.Process();
+		idle = (tick > 2 && !simulation.getController().getRotorRunning()) ? idle + 1 : 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	sSession session = { 1, 1000, false, 0.5, 0.0, false };
+	
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : "0";
+		
+		if      (!strcmp(option, "--seed"))      { session.seed = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--trials"))    { session.trials = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--warning"))   { session.warning = true; }
+		else if (!strcmp(option, "--torn"))      { session.torn = atof(value); i++; }
+		else if (!strcmp(option, "--max-error")) { session.maxError = atof(value); i++; }
+		else if (!strcmp(option, "--selftest"))  { session.selfTest = true; }
+		else { usage(argv[0]); return 1; }
+	}
+	
+#ifndef POWERWARNING
+	if (session.warning)
+	{
+		printf("--warning: build with -DPOWERWARNING\n");
+		return 1;
+	}
+#endif
+	
+	uint16_t runtime = PE1MEW_Simulation::getCalibratedRunTime(PLANT_DEFAULT);
+	std::mt19937 random(session.seed);
+	std::uniform_int_distribution<int> direction(0, 3600);
+	std::uniform_int_distribution<int> moves(0, 4);
+	std::uniform_int_distribution<int> byte(0, 255);
+	std::bernoulli_distribution torn(session.torn);
+	
+	double errorSum = 0.0, errorMax = 0.0, legacySum = 0.0, legacyMax = 0.0;
+	uint32_t tornWrites = 0;
+	uint32_t configErrors = 0;
+	
+	for (uint32_t trial = 0; trial < session.trials; trial++)
+	{
+		PE1MEW_Simulation simulation(PLANT_DEFAULT, runtime, direction(random), random());
+		PE1MEW_RotorController& controller = simulation.getController();
+		
+		for (int i = moves(random); i > 0; i--)
+		{
+			move(simulation, direction(random));
+		}
+		
+		// A move of at least 20 degrees, cut at a random tick of it.
+		int target;
+		do
+		{
+			target = direction(random);
+		} while (abs(target - controller.getCurrentDirection()) < 200);
+		
+		uint32_t duration = (uint32_t)abs(target - controller.getCurrentDirection()) * runtime / 3600;
+		uint32_t cut = std::uniform_int_distribution<uint32_t>(1, duration)(random);
+		
+		// Brightness and runtime do not change during the move, the self-test writes their cells.
+		static const uint8_t CONFIG_CELLS[] = { 0, 1, 6, 7 };
+		uint8_t config[sizeof(CONFIG_CELLS)];
+		for (uint8_t i = 0; i < sizeof(CONFIG_CELLS); i++)
+		{
+			config[i] = EEPROM.read(CONFIG_CELLS[i]);
+		}
+		if (session.selfTest)
+		{
+			simulation.sendCommand("E\n");
+			simulation.Process();					// One command per tick.
+		}
+		
+		char command[16];
+		snprintf(command, sizeof(command), "D%d.%d\n", target / 10, target % 10);
+		simulation.sendCommand(command);
+		
+		uint32_t writes = EEPROM.writes;
+		for (uint32_t tick = 0; tick < cut; tick++)
+		{
+			writes = EEPROM.writes;
+			simulation.Process();
+		}
+		if (!session.warning && EEPROM.writes != writes && torn(random))
+		{
+			EEPROM.data[EEPROM.lastAddress] = (uint8_t)byte(random);		// the write is not finished
+			tornWrites++;
+		}
+		
+		double legacy = (((uint16_t)EEPROM.read(2) << 8) | EEPROM.read(3)) / 10.0;
+		simulation.powerCut(session.warning);
+		for (uint32_t tick = 0; tick < RESTART_TICKS; tick++)
+		{
+			simulation.Process();
+		}
+		
+		for (uint8_t i = 0; i < sizeof(CONFIG_CELLS); i++)
+		{
+			configErrors += (EEPROM.read(CONFIG_CELLS[i]) != config[i]) ? 1 : 0;
+		}
+		
+		double position = simulation.getPlant().getPosition();
+		double error = fabs(controller.getCurrentDirection() / 10.0 - position);
+		errorSum += error;
+		errorMax = (error > errorMax) ? error : errorMax;
+		legacySum += fabs(legacy - position);
+		legacyMax = (fabs(legacy - position) > legacyMax) ? fabs(legacy - position) : legacyMax;
+	}
+	
+	uint32_t trials = (session.trials > 0) ? session.trials : 1;
+	printf("power cuts %u, %u during an EEPROM write\n", session.trials, tornWrites);
+	printf("restored direction error: mean %.2f, max %.2f degrees\n", errorSum / trials, errorMax);
+	printf("direction of the last move error: mean %.2f, max %.2f degrees\n", legacySum / trials, legacyMax);
+	if (session.selfTest)
+	{
+		printf("self-test: %u configuration cells changed\n", configErrors);
+		if (configErrors > 0)
+		{
+			return 1;
+		}
+	}
+	
+	if (session.maxError > 0.0 && errorMax > session.maxError)
+	{
+		printf("restored direction exceeds %.2f degrees\n", session.maxError);
+		return 1;
+	}
+	return 0;
+}
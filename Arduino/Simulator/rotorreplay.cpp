@@ -0,0 +1,319 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file rotorreplay.cpp
+/// \brief Replay of an input recording of the PE1MEW Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+///
+/// A recording exported by the controller with the serial command "R" (see PE1MEW_InputRecorder)
+/// is replayed in the simulated controller: the EEPROM and the buttons at power-up are set from the
+/// header, the buttons and serial directions are applied at the recorded ticks. After every tick the
+/// relays are compared with the recorded relays. The leds cannot be recorded on the controller;
+/// they are written to a file with --display and compared with a file of an other build with --compare.
+
+#include "pe1mew_simulation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+
+static const unsigned REPORT_MAX = 10;		///< Differences that are printed.
+
+/// \brief settings at power-up from the header of a recording.
+struct sRecordingHeader
+{
+	uint8_t  buttons;		///< Buttons at power-up as eButtonState.
+	uint16_t direction;		///< Direction in EEPROM in tenths of degrees.
+	uint16_t runtime;		///< Runtime in EEPROM in ticks.
+	uint8_t  brightness;	///< Brightness in EEPROM.
+};
+
+/// \brief one decoded event of a recording.
+struct sRecordedEvent
+{
+	uint32_t tick;			///< Tick of the event.
+	uint8_t  type;			///< eRecorderEvent
+	uint8_t  data;			///< Bit 1 and 0 of the event.
+	uint16_t value;			///< Direction of a RECORD_DIRECTION event.
+};
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options] RECORDING\n"
+		   "  RECORDING       file with the line R<hex> send by the controller, a serial log is fine\n"
+		   "  --display FILE  write every change of the leds: tick, brightness and colors\n"
+		   "  --compare FILE  compare the leds tick for tick with a file written by --display\n"
+		   "  --verbose       print every event\n"
+		   "exit status 0 when relays and leds are identical, 1 when they differ, 2 on errors\n", name);
+}
+
+/// \brief read the last exported recording from a file.
+static bool readRecording(const char* fileName, std::vector<uint8_t>& bytes)
+{
+	FILE* file = fopen(fileName, "r");
+	char line[1024];
+	
+	if (file == 0)
+	{
+		return false;
+	}
+	while (fgets(line, sizeof(line), file) != 0)
+	{
+		size_t length = strlen(line);
+		while (length > 0 && isspace((unsigned char)line[length - 1]))
+		{
+			line[--length] = '\0';
+		}
+		if (line[0] != 'R' || length < 3 || (length - 1) % 2 != 0 || strspn(&line[1], "0123456789ABCDEFabcdef") != length - 1)
+		{
+			continue;							// not a recording, for example the answer to M
+		}
+		bytes.clear();
+		for (size_t i = 1; i < length; i += 2)
+		{
+			char hex[3] = { line[i], line[i + 1], '\0' };
+			bytes.push_back((uint8_t)strtoul(hex, 0, 16));
+		}
+	}
+	fclose(file);
+	return !bytes.empty();
+}
+
+/// \brief decode a recording.
+/// \param[out] endTick first tick that is not completely recorded.
+/// \param[out] full the recording ended because it was full.
+/// \return true when the recording is valid.
+static bool decodeRecording(const std::vector<uint8_t>& bytes, sRecordingHeader& header,
+							std::vector<sRecordedEvent>& events, uint32_t& endTick, bool& full)
+{
+	uint32_t tick = 0;
+	size_t position = RECORDER_HEADER;
+	
+	if (bytes.size() < RECORDER_HEADER || bytes[0] != RECORDER_FORMAT)
+	{
+		return false;
+	}
+	header.buttons = bytes[1];
+	header.direction = ((uint16_t)bytes[2] << 8) | bytes[3];
+	header.runtime = ((uint16_t)bytes[4] << 8) | bytes[5];
+	header.brightness = bytes[6];
+	
+	while (position < bytes.size())
+	{
+		sRecordedEvent event = { 0, (uint8_t)(bytes[position] & 0xC0), (uint8_t)(bytes[position] & 0x03), 0 };
+		uint32_t delta = (bytes[position] >> 2) & 0x0F;
+		position++;
+		
+		if (delta == 15)
+		{
+			uint32_t extra = 0;
+			uint8_t shift = 0;
+			do
+			{
+				if (position >= bytes.size() || shift > 28)
+				{
+					return false;
+				}
+				extra |= (uint32_t)(bytes[position] & 0x7F) << shift;
+				shift += 7;
+			} while (bytes[position++] & 0x80);
+			delta += extra;
+		}
+		if (event.type == RECORD_DIRECTION)
+		{
+			if (position + 2 > bytes.size())
+			{
+				return false;
+			}
+			event.value = ((uint16_t)bytes[position] << 8) | bytes[position + 1];
+			position += 2;
+		}
+		tick += delta;
+		event.tick = tick;
+		
+		if (event.type == RECORD_END)
+		{
+			endTick = tick;
+			full = (event.data & 0x01) != 0;
+			return true;
+		}
+		events.push_back(event);
+	}
+	return false;								// no RECORD_END
+}
+
+/// \brief describe the leds as a line of the display file.
+static std::string displayLine(uint32_t tick)
+{
+	char text[16];
+	std::string returnValue;
+	
+	snprintf(text, sizeof(text), "%u %u", tick, Simulator::ledBrightness);
+	returnValue = text;
+	for (size_t i = 0; i < Simulator::leds.size(); i++)
+	{
+		snprintf(text, sizeof(text), " %06X", Simulator::leds[i]);
+		returnValue += text;
+	}
+	return returnValue;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* recordingName = 0;
+	const char* displayName = 0;
+	const char* compareName = 0;
+	bool verbose = false;
+	
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+		
+		if      (!strcmp(option, "--display")) { displayName = value; i++; }
+		else if (!strcmp(option, "--compare")) { compareName = value; i++; }
+		else if (!strcmp(option, "--verbose")) { verbose = true; }
+		else if (option[0] != '-' && recordingName == 0) { recordingName = option; }
+		else { usage(argv[0]); return 2; }
+	}
+	if (recordingName == 0)
+	{
+		usage(argv[0]);
+		return 2;
+	}
+	
+	std::vector<uint8_t> bytes;
+	std::vector<sRecordedEvent> events;
+	sRecordingHeader header;
+	uint32_t endTick = 0;
+	bool full = false;
+	
+	if (!readRecording(recordingName, bytes) || !decodeRecording(bytes, header, events, endTick, full))
+	{
+		fprintf(stderr, "no valid recording in %s\n", recordingName);
+		return 2;
+	}
+	printf("recording of %u bytes, %u events, %u ticks%s\n", (unsigned)bytes.size(), (unsigned)events.size(),
+		   endTick, full ? ", recording was full" : "");
+	printf("power-up: buttons %u, direction %.1f, runtime %u, brightness %u\n", header.buttons,
+		   header.direction / 10.0, header.runtime, header.brightness);
+	
+	PE1MEW_Simulation simulation(PLANT_DEFAULT, header.runtime, header.direction, 1, header.buttons, header.brightness);
+	std::vector<std::string> display;
+	uint8_t relays = 0;
+	unsigned relayErrors = 0;
+	size_t event = 0;
+	
+	for (uint32_t tick = 0; tick < endTick; tick++)
+	{
+		// Buttons are recorded at the start of the tick, directions during the tick.
+		for (size_t e = event; e < events.size() && events[e].tick == tick; e++)
+		{
+			if (events[e].type == RECORD_BUTTONS)
+			{
+				simulation.setButtons(events[e].data);
+			}
+			else if (events[e].type == RECORD_DIRECTION)
+			{
+				char command[16];
+				snprintf(command, sizeof(command), "D%u.%u\n", events[e].value / 10, events[e].value % 10);
+				simulation.sendCommand(command);
+			}
+		}
+		
+		simulation.Process();
+		
+		// Relays are recorded at the end of the tick.
+		for (; event < events.size() && events[event].tick == tick; event++)
+		{
+			if (events[event].type == RECORD_RELAYS)
+			{
+				relays = events[event].data;
+			}
+			if (verbose)
+			{
+				printf("%u: %s %u\n", tick, (events[event].type == RECORD_BUTTONS) ? "buttons" :
+					   (events[event].type == RECORD_RELAYS) ? "relays" : "direction",
+					   (events[event].type == RECORD_DIRECTION) ? events[event].value : events[event].data);
+			}
+		}
+		
+		uint8_t simulated = ((Simulator::pins[REL1_PIN] == RELAY_ACTIVE) ? 0x01 : 0x00) |
+							((Simulator::pins[REL2_PIN] == RELAY_ACTIVE) ? 0x02 : 0x00);
+		if (simulated != relays && relayErrors++ < REPORT_MAX)
+		{
+			printf("tick %u: relays recorded %u, simulated %u\n", tick, relays, simulated);
+		}
+		
+		std::string line = displayLine(tick);
+		if (display.empty() || line.substr(line.find(' ')) != display.back().substr(display.back().find(' ')))
+		{
+			display.push_back(line);
+		}
+	}
+	printf("relays: %u ticks differ\n", relayErrors);
+	
+	if (displayName != 0)
+	{
+		FILE* file = fopen(displayName, "w");
+		if (file == 0)
+		{
+			fprintf(stderr, "cannot write %s\n", displayName);
+			return 2;
+		}
+		for (size_t i = 0; i < display.size(); i++)
+		{
+			fprintf(file, "%s\n", display[i].c_str());
+		}
+		fclose(file);
+	}
+	
+	unsigned displayErrors = 0;
+	if (compareName != 0)
+	{
+		FILE* file = fopen(compareName, "r");
+		std::vector<std::string> reference;
+		static char line[4096];
+		
+		if (file == 0)
+		{
+			fprintf(stderr, "cannot read %s\n", compareName);
+			return 2;
+		}
+		while (fgets(line, sizeof(line), file) != 0)
+		{
+			line[strcspn(line, "\r\n")] = '\0';
+			reference.push_back(line);
+		}
+		fclose(file);
+		
+		for (size_t i = 0; i < display.size() || i < reference.size(); i++)
+		{
+			const std::string& simulated = (i < display.size()) ? display[i] : std::string("end");
+			const std::string& expected = (i < reference.size()) ? reference[i] : std::string("end");
+			if (simulated != expected && displayErrors++ < REPORT_MAX)
+			{
+				printf("display change %u: expected %.40s, simulated %.40s\n", (unsigned)i, expected.c_str(), simulated.c_str());
+			}
+		}
+		printf("display: %u changes differ\n", displayErrors);
+	}
+	return (relayErrors > 0 || displayErrors > 0) ? 1 : 0;
+}
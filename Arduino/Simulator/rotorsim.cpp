@@ -0,0 +1,386 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file rotorsim.cpp
+/// \brief Closed loop simulation of the PE1MEW Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+/// \version 1.1	Controller and rotor model connected by PE1MEW_Simulation.
+/// \version 1.2	Sessions in hours of controller time, calibration by the test and calibration mode.
+/// \version 1.3	Feedback potentiometer, error between the target and the true position.
+/// \version 1.4	Non-linear potentiometer, tracking error at each tick of the fused and the measured direction.
+/// \version 1.5	Moves to the end stops and an error of the runtime in EEPROM.
+/// \version 1.6	Settings of the re-synchronisation at the end stops.
+/// \version 1.7	Motor current sensor, jams and the automatic calibration.
+/// \version 1.8	Export of the move log.
+/// \version 1.9	Output of the serial port written to a file, for the decoder of the debug logger.
+///
+/// The rotor controller is run on the host and drives a PE1MEW_RotorPlant through its relay pins.
+/// A randomized session of moves is commanded by serial commands. After each move the direction
+/// registered by the controller (believed) is compared with the position of the model (true).
+/// The controller runs on a virtual clock, a session depends only on its options and seed.
+/// With --max-error the exit status tells if the pointing error stayed within a limit, so a
+/// session can be used as a regression check.
+
+#include "pe1mew_simulation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <random>
+#include <chrono>
+
+static const uint32_t TICK = PE1MEW_Simulation::TICK;	///< Sys tick of the rotor controller in uS.
+static const uint32_t MOVE_TIMEOUT = 100000;	///< Maximum number of ticks for one move.
+
+/// \brief settings of a simulation session.
+struct sSession
+{
+	uint32_t seed;			///< Seed of all random generators.
+	uint32_t moves;			///< Number of moves.
+	double   hours;			///< Controller time of the session in hours, replaces moves when not 0.
+	bool     calibrate;		///< Calibrate by the test and calibration mode instead of writing the runtime.
+	uint32_t reaction;		///< Reaction time of the operator when calibrating in ticks.
+	double   maxError;		///< Largest pointing error allowed in degrees, 0 is no limit.
+	double   jitter;		///< Standard deviation of the tick interval in uS.
+	double   lostTicks;		///< Probability that a tick is lost.
+	double   sensorNoise;	///< Noise of the feedback potentiometer in ADC steps, negative when not connected.
+	double   nonlinearity;	///< Sine error of the potentiometer relative to its range.
+	bool     linearize;		///< Give the controller the linearisation table of the potentiometer.
+	double   endMoves;		///< Probability that a move goes to 0 or 360 degrees.
+	double   runtimeError;	///< Error of the runtime written in EEPROM in percent.
+	uint16_t resync;		///< Degrees of travel after which the controller re-synchronises, 0 is off.
+	uint16_t overdrive;		///< Ticks the rotor is driven into the end stop when re-synchronised.
+	double   currentNoise;	///< Noise of the motor current in ADC steps, negative when not connected.
+	double   jams;			///< Probability that the rotor jams half way a move.
+	bool     autoCalibrate;	///< Calibrate by the serial command C before the session.
+	const char* log;		///< File for the export of the move log at the end of the session, 0 is none.
+	const char* serial;		///< File for the output of the serial port during the session, 0 is none.
+	bool     verbose;		///< Print every move.
+	sPlantParameters plant;	///< Rotor model.
+};
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+		   "  --seed N        seed of the random generators (1)\n"
+		   "  --moves N       number of moves (1000)\n"
+		   "  --hours H       run H hours of controller time instead of a number of moves\n"
+		   "  --calibrate     calibrate with the test and calibration mode before the session\n"
+		   "  --reaction N    reaction time of the operator when calibrating in ticks (25)\n"
+		   "  --max-error D   exit status 1 when the pointing error exceeds D degrees\n"
+		   "  --jitter US     standard deviation of the tick interval in uS (0)\n"
+		   "  --lost P        probability that a tick is lost (0)\n"
+		   "  --speed-cw D    rotor speed CW in degrees per second (10)\n"
+		   "  --speed-ccw D   rotor speed CCW in degrees per second (10)\n"
+		   "  --spin-up S     time constant of the motor starting in seconds (0.15)\n"
+		   "  --coast S       time constant of the motor stopping in seconds (0.10)\n"
+		   "  --latency S     relay latency in seconds (0.008)\n"
+		   "  --wind R        wind load as relative standard deviation of the speed (0)\n"
+		   "  --sensor N      connect a feedback potentiometer with N ADC steps of noise,\n"
+		   "                  the controller shall be build with -DPOSITIONSENSOR\n"
+		   "  --nonlinear A   sine error of the potentiometer relative to its range (0)\n"
+		   "  --linearize     set the linearisation table of the potentiometer in the controller\n"
+		   "  --end-moves P   probability that a move goes to 0 or 360 degrees (0)\n"
+		   "  --runtime-error P  error of the runtime written in EEPROM in percent (0)\n"
+		   "  --resync D      re-synchronise at an end stop after D degrees of travel, 0 is off (3600)\n"
+		   "  --overdrive N   ticks the rotor is driven into the end stop when re-synchronised (200)\n"
+		   "  --current N     connect the motor current with N ADC steps of noise,\n"
+		   "                  the controller shall be build with -DCURRENTSENSOR\n"
+		   "  --jams P        probability that the rotor jams half way a move (0)\n"
+		   "  --auto-calibrate  calibrate with serial command C before the session\n"
+		   "  --log FILE      write the export of the move log (serial command L) to FILE\n"
+		   "  --serial FILE   write the output of the serial port during the session to FILE\n"
+		   "  --verbose       print every move\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+	sSession session = { 1, 1000, 0.0, false, 25, 0.0, 0.0, 0.0, -1.0, 0.0, false, 0.0, 0.0, RESYNC_TRAVEL, RESYNC_OVERDRIVE, -1.0, 0.0, false, 0, 0, false, PLANT_DEFAULT };
+	
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : "0";
+		
+		if      (!strcmp(option, "--seed"))      { session.seed = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--moves"))     { session.moves = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--hours"))     { session.hours = atof(value); i++; }
+		else if (!strcmp(option, "--calibrate")) { session.calibrate = true; }
+		else if (!strcmp(option, "--reaction"))  { session.reaction = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--max-error")) { session.maxError = atof(value); i++; }
+		else if (!strcmp(option, "--jitter"))    { session.jitter = atof(value); i++; }
+		else if (!strcmp(option, "--lost"))      { session.lostTicks = atof(value); i++; }
+		else if (!strcmp(option, "--speed-cw"))  { session.plant.speedCW = atof(value); i++; }
+		else if (!strcmp(option, "--speed-ccw")) { session.plant.speedCCW = atof(value); i++; }
+		else if (!strcmp(option, "--spin-up"))   { session.plant.spinUpTime = atof(value); i++; }
+		else if (!strcmp(option, "--coast"))     { session.plant.coastTime = atof(value); i++; }
+		else if (!strcmp(option, "--latency"))   { session.plant.relayLatency = atof(value); i++; }
+		else if (!strcmp(option, "--wind"))      { session.plant.windNoise = atof(value); i++; }
+		else if (!strcmp(option, "--sensor"))    { session.sensorNoise = atof(value); i++; }
+		else if (!strcmp(option, "--nonlinear")) { session.nonlinearity = atof(value); i++; }
+		else if (!strcmp(option, "--linearize")) { session.linearize = true; }
+		else if (!strcmp(option, "--end-moves")) { session.endMoves = atof(value); i++; }
+		else if (!strcmp(option, "--runtime-error")) { session.runtimeError = atof(value); i++; }
+		else if (!strcmp(option, "--resync"))    { session.resync = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--overdrive")) { session.overdrive = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--current"))   { session.currentNoise = atof(value); i++; }
+		else if (!strcmp(option, "--jams"))      { session.jams = atof(value); i++; }
+		else if (!strcmp(option, "--auto-calibrate")) { session.autoCalibrate = true; }
+		else if (!strcmp(option, "--log"))       { session.log = value; i++; }
+		else if (!strcmp(option, "--serial"))    { session.serial = value; i++; }
+		else if (!strcmp(option, "--verbose"))   { session.verbose = true; }
+		else { usage(argv[0]); return 1; }
+	}
+	
+#ifndef POSITIONSENSOR
+	if (session.sensorNoise >= 0.0)
+	{
+		printf("--sensor: build with -DPOSITIONSENSOR\n");
+		return 1;
+	}
+#endif
+#ifndef CURRENTSENSOR
+	if (session.currentNoise >= 0.0 || session.autoCalibrate)
+	{
+		printf("--current: build with -DCURRENTSENSOR\n");
+		return 1;
+	}
+#endif
+	
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	uint16_t runtime = PE1MEW_Simulation::getCalibratedRunTime(session.plant);
+	uint16_t written = (uint16_t)(runtime * (1.0 + session.runtimeError / 100.0) + 0.5);
+	PE1MEW_Simulation simulation(session.plant, written, 1800, session.seed, session.calibrate ? BUTTON_BOTH : BUTTON_NONE);
+	PE1MEW_RotorController& controller = simulation.getController();
+	controller.setResync(session.resync, session.overdrive);
+	
+	if (session.sensorNoise >= 0.0)
+	{
+		sSensorParameters sensor = SENSOR_DEFAULT;
+		sensor.noise = session.sensorNoise;
+		sensor.nonlinearity = session.nonlinearity;
+		simulation.setSensor(sensor);
+#ifdef POSITIONSENSOR
+		if (session.linearize)
+		{
+			controller.setSensorTable(simulation.getSensorTable());
+		}
+		// Variance of the decimated direction in tenths of degrees squared, plus the quantization of a tenth.
+		double deviation = sensor.noise * 3600.0 / 1023.0 / sqrt(TICK / PE1MEW_Simulation::ADC_CONVERSION);
+		double variance = (deviation * deviation + 1.0 / 12.0) * 256.0;
+		controller.setSensorVariance((uint16_t)((variance > 0xFFFF) ? 0xFFFF : variance));
+#endif
+	}
+	
+	if (session.currentNoise >= 0.0)
+	{
+		sCurrentParameters current = CURRENT_DEFAULT;
+		current.noise = session.currentNoise;
+		simulation.setCurrentSensor(current);
+	}
+	
+#ifdef CURRENTSENSOR
+	if (session.autoCalibrate)
+	{
+		uint32_t tick = 0;
+		simulation.sendCommand("C\n");
+		for (tick = 0; tick < MOVE_TIMEOUT && (tick < 2 || controller.getAutoCalibration() != AUTO_OFF); tick++)
+		{
+			simulation.Process();
+		}
+		printf("automatic calibration: runtime %u ticks in %.1f s, %u ticks for 360 degrees\n",
+			   controller.getRunTime(), tick * TICK / 1000000.0, runtime);
+	}
+#endif
+	
+	if (session.calibrate)
+	{
+		uint16_t calibrated = simulation.Calibrate(session.reaction);
+		if (calibrated == 0)
+		{
+			printf("calibration failed\n");
+			return 2;
+		}
+		printf("calibrated runtime %u ticks, %u ticks for 360 degrees\n", calibrated, runtime);
+	}
+	
+	const PE1MEW_RotorPlant& plant = simulation.getPlant();
+	std::mt19937 random(session.seed);
+	std::uniform_int_distribution<int> target(0, 3600);
+	std::uniform_int_distribution<int> idle(10, 500);
+	std::normal_distribution<double> jitter(0.0, session.jitter);
+	std::bernoulli_distribution lost(session.lostTicks);
+	std::bernoulli_distribution endMove(session.endMoves);
+	std::bernoulli_distribution jam(session.jams);
+	std::uniform_real_distribution<double> jamPoint(0.2, 0.8);
+	
+	double errorSum = 0.0, errorSquareSum = 0.0, errorMax = 0.0, error = 0.0;
+	double targetSum = 0.0, targetMax = 0.0;
+	double trackSquareSum = 0.0, trackMax = 0.0;		// believed against true position at each tick
+	double sensorSquareSum = 0.0, sensorMax = 0.0;		// measured against true position at each tick
+	uint64_t trackTicks = 0;
+	uint32_t jams = 0, jamsDetected = 0;
+	double jamStallTime = 0.0;							// time the motor pushed against the jams
+	
+	if (session.verbose)
+	{
+		printf("move,target,believed,true,error\n");
+	}
+	
+	uint64_t sessionTicks = (uint64_t)(session.hours * 3600.0 * 1000000.0 / TICK);
+	uint32_t move = 0;
+	
+	for (move = 0; (session.hours > 0.0) ? (simulation.getTicks() < sessionTicks) : (move < session.moves); move++)
+	{
+		char command[16];
+		int direction = target(random);
+		if (session.endMoves > 0.0 && endMove(random))
+		{
+			direction = (direction < 1800) ? 0 : 3600;
+		}
+		uint32_t moveTicks = 0;
+		int idleTicks = idle(random);
+		
+		snprintf(command, sizeof(command), "D%d.%d\n", direction / 10, direction % 10);
+		simulation.sendCommand(command);
+		
+		bool jammed = session.jams > 0.0 && jam(random);
+		double stallTime = plant.getStallTime();
+		if (jammed)
+		{
+			simulation.setJam(plant.getPosition() + (direction / 10.0 - plant.getPosition()) * jamPoint(random));
+		}
+		
+		// Run until the controller stopped the rotor and the idle time has passed.
+		while (moveTicks < MOVE_TIMEOUT && idleTicks > 0)
+		{
+			double interval = TICK + jitter(random);
+			if (lost(random))
+			{
+				interval += TICK;					// Tick lost: controller sees one tick for two intervals
+			}
+			
+			simulation.Process(interval);
+			moveTicks++;
+			
+			double track = fabs(controller.getCurrentDirection() / 10.0 - plant.getPosition());
+			trackSquareSum += track * track;
+			trackMax = (track > trackMax) ? track : trackMax;
+			trackTicks++;
+#ifdef POSITIONSENSOR
+			double measured = fabs(controller.getSensorDirection() / 10.0 - plant.getPosition());
+			sensorSquareSum += measured * measured;
+			sensorMax = (measured > sensorMax) ? measured : sensorMax;
+#endif
+			
+			if (moveTicks > 2 && !controller.getRotorRunning())
+			{
+				idleTicks--;
+			}
+		}
+		
+		if (jammed)
+		{
+			simulation.clearJam();
+			jams++;
+			jamsDetected += controller.getUncertain() ? 1 : 0;
+			jamStallTime += plant.getStallTime() - stallTime;
+		}
+		
+		error = controller.getCurrentDirection() / 10.0 - plant.getPosition();
+		errorSum += fabs(error);
+		errorSquareSum += error * error;
+		errorMax = (fabs(error) > errorMax) ? fabs(error) : errorMax;
+		
+		double targetError = fabs(direction / 10.0 - plant.getPosition());
+		targetSum += targetError;
+		targetMax = (targetError > targetMax) ? targetError : targetMax;
+		
+		if (session.verbose)
+		{
+			printf("%u,%.1f,%.1f,%.2f,%.2f\n", move, direction / 10.0,
+				   controller.getCurrentDirection() / 10.0, plant.getPosition(), error);
+		}
+	}
+	
+	double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double controllerTime = (double)simulation.getTicks() * TICK / 1000000.0;
+	move = (move > 0) ? move : 1;
+	
+	printf("moves %u, controller time %.1f s in %.2f s, %.0f times real time\n", move, controllerTime,
+		   wallTime, controllerTime / ((wallTime > 0.0) ? wallTime : 1e-9));
+	printf("pointing error: mean %.2f, rms %.2f, max %.2f, final %.2f degrees\n",
+		   errorSum / move, sqrt(errorSquareSum / move), errorMax, error);
+	printf("target error: mean %.2f, max %.2f degrees\n", targetSum / move, targetMax);
+	printf("runtime %u ticks, %u written in EEPROM, %u ticks for 360 degrees\n",
+		   controller.getRunTime(), written, runtime);
+	printf("tracking error at each tick: rms %.2f, max %.2f degrees\n",
+		   sqrt(trackSquareSum / trackTicks), trackMax);
+	if (session.sensorNoise >= 0.0)
+	{
+		printf("sensor alone at each tick: rms %.2f, max %.2f degrees\n",
+			   sqrt(sensorSquareSum / trackTicks), sensorMax);
+	}
+	
+	if (session.jams > 0.0)
+	{
+		printf("jams %u, %u detected, motor stalled %.2f s per jam\n", jams, jamsDetected,
+			   jamStallTime / ((jams > 0) ? jams : 1));
+	}
+	
+	if (session.serial)
+	{
+		FILE* file = fopen(session.serial, "wb");
+		const std::string& output = Simulator::serialOutput;
+		if (!file || fwrite(output.data(), 1, output.size(), file) != output.size())
+		{
+			printf("--serial: can not write %s\n", session.serial);
+			return 2;
+		}
+		fclose(file);
+	}
+	
+#ifdef MOVELOG
+	if (session.log)
+	{
+		// The export is binary: it starts at the end of the output before the command.
+		size_t begin = Simulator::serialOutput.size();
+		simulation.sendCommand("L\n");
+		for (int tick = 0; tick < 100; tick++)
+		{
+			simulation.Process();
+		}
+		std::string output = Simulator::serialOutput.substr(begin);
+		size_t length = (output.size() >= 3) ? 3 + (uint8_t)output[2] * LOG_RECORD_SIZE : 0;
+		FILE* file = fopen(session.log, "wb");
+		if (!file || output.size() < length || length == 0 || fwrite(output.data(), 1, length, file) != length)
+		{
+			printf("--log: can not write %s\n", session.log);
+			return 2;
+		}
+		fclose(file);
+		printf("move log: %u moves written to %s\n", (uint8_t)output[2], session.log);
+	}
+#endif
+	
+	if (session.maxError > 0.0 && errorMax > session.maxError)
+	{
+		printf("pointing error exceeds %.2f degrees\n", session.maxError);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,401 @@
+/*--------------------------------------------------------------------
+  This file is part of the PE1MEW Arduino Rotor Controller.
+
+  The PE1MEW Arduino Rotor Controller is free software: 
+  you can redistribute it and/or modify it under the terms of a Creative 
+  Commons Attribution-NonCommercial 4.0 International License 
+  (http://creativecommons.org/licenses/by-nc/4.0/) by 
+  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+
+  The PE1MEW Arduino Rotor Controller is distributed in the hope that 
+  it will be useful, but WITHOUT ANY WARRANTY; without even the 
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+  PURPOSE.
+  --------------------------------------------------------------------*/
+
+/// \file rotorsweep.cpp
+/// \brief Parallel parameter sweep of the PE1MEW Rotor Controller
+/// \date 18-10-2026
+/// \author Remko Welling (PE1MEW)
+/// \version 1.0
+/// \version 1.1	Commit delay of the next direction.
+/// \version 1.2	Default commit delay of the controller, COMMIT_DELAY.
+///
+/// Every combination of the swept settings is run as an independent PE1MEW_Simulation on a pool
+/// of threads, one simulation per thread at a time. An operator model dials each heading of a
+/// session with the buttons, the controller turns the rotor model. Per combination one CSV line
+/// is printed with the dial time, pointing error, travel time and relay cycles.
+///
+/// The operator holds a button while far from the heading and reacts to the display with a delay.
+/// Close to the heading, or after passing it, the operator taps: the button is released after each
+/// step of the next direction and the display is watched for the reaction time before the next tap.
+
+#include "pe1mew_simulation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+static const uint32_t TICK = PE1MEW_Simulation::TICK;	///< Sys tick of the rotor controller in uS.
+static const uint32_t DIAL_TIMEOUT = 6000;		///< Maximum number of ticks to dial one heading.
+static const uint32_t MOVE_TIMEOUT = 100000;	///< Maximum number of ticks for the rotor to stop.
+static const uint32_t SETTLE_TICKS = 100;		///< Ticks the rotor shall be stopped before the position is measured.
+static const int      FINE_ZONE = 100;			///< Distance in tenths of degrees below which the operator taps.
+
+/// \brief one heading of an operator session.
+struct sHeading
+{
+	uint32_t idleTicks;		///< Ticks the operator waits before dialing.
+	uint16_t direction;		///< Heading in tenths of degrees.
+};
+
+/// \brief one combination of swept settings.
+struct sSweepPoint
+{
+	sSteeringProfile profile;	///< Timing of the buttons.
+	uint8_t  deadband;			///< Deadband of the rotor in tenths of degrees.
+	double   calibration;		///< Error of the runtime in EEPROM in percent.
+	uint8_t  commit;			///< Commit delay of the next direction in ticks.
+};
+
+/// \brief results of one combination, summed over all repeats.
+struct sSweepResult
+{
+	uint32_t headings;			///< Headings dialed.
+	uint32_t timeouts;			///< Headings not reached within DIAL_TIMEOUT.
+	uint32_t presses;			///< Button presses.
+	uint64_t dialTicks;			///< Ticks from the start of dialing to the last release.
+	uint64_t travelTicks;		///< Ticks the motor relay was active.
+	uint64_t relayCycles;		///< Relay activations.
+	double   errorSum;			///< Sum of the distance between heading and true position in degrees.
+	double   errorMax;			///< Largest distance between heading and true position in degrees.
+	double   driftSum;			///< Sum of the distance between believed and true position in degrees.
+};
+
+/// \brief settings shared by all combinations.
+struct sSweep
+{
+	uint32_t seed;				///< Seed of the first repeat.
+	uint32_t repeats;			///< Sessions per combination, each with its own seed.
+	uint32_t headings;			///< Headings of a random session.
+	uint32_t reaction;			///< Reaction time of the operator in ticks.
+	unsigned threads;			///< Worker threads.
+	std::vector<sHeading> trace;	///< Recorded session, replaces the random sessions when not empty.
+	sPlantParameters plant;		///< Rotor model.
+};
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+		   "Lists are comma separated, every combination of the lists is simulated.\n"
+		   "  --hold1 LIST        ticks between steps in speed step 1 (20)\n"
+		   "  --hold2 LIST        ticks between steps in speed step 2 (9)\n"
+		   "  --hold3 LIST        ticks between steps in speed step 3 (3)\n"
+		   "  --hold4 LIST        ticks between steps in speed step 4 (1)\n"
+		   "  --steps LIST        steps taken in speed steps 1 to 3 (10)\n"
+		   "  --increment LIST    step of the next direction in tenths of degrees (40)\n"
+		   "  --deadband LIST     deadband of the rotor in tenths of degrees (0)\n"
+		   "  --calibration LIST  error of the runtime in EEPROM in percent (0)\n"
+		   "  --commit LIST       commit delay of the next direction in ticks (%u)\n"
+		   "  --trace FILE        session to dial: lines with idle seconds and heading in degrees\n"
+		   "  --headings N        headings of a random session (50)\n"
+		   "  --repeats N         sessions per combination (1)\n"
+		   "  --seed N            seed of the first session (1)\n"
+		   "  --reaction N        reaction time of the operator in ticks (25)\n"
+		   "  --threads N         worker threads (all cores)\n"
+		   "  --speed-cw D        rotor speed CW in degrees per second (10)\n"
+		   "  --speed-ccw D       rotor speed CCW in degrees per second (10)\n"
+		   "  --wind R            wind load as relative standard deviation of the speed (0)\n", name, COMMIT_DELAY);
+}
+
+/// \brief parse a comma separated list of numbers.
+static std::vector<double> parseList(const char* text)
+{
+	std::vector<double> returnValue;
+	char* end = 0;
+	
+	while (*text != '\0')
+	{
+		returnValue.push_back(strtod(text, &end));
+		text = (*end == ',') ? end + 1 : end;
+		if (end == text && *end != '\0')
+		{
+			break;							// not a number
+		}
+	}
+	return returnValue;
+}
+
+/// \brief read a session, lines with idle time in seconds and heading in degrees, # starts a comment.
+static bool readTrace(const char* fileName, std::vector<sHeading>& trace)
+{
+	FILE* file = fopen(fileName, "r");
+	char line[128];
+	
+	if (file == 0)
+	{
+		return false;
+	}
+	while (fgets(line, sizeof(line), file) != 0)
+	{
+		double idle = 0.0, direction = 0.0;
+		if (line[0] != '#' && sscanf(line, "%lf %lf", &idle, &direction) == 2 && direction >= 0.0 && direction <= 360.0)
+		{
+			sHeading heading = { (uint32_t)(idle * 1000000.0 / TICK), (uint16_t)(direction * 10.0 + 0.5) };
+			trace.push_back(heading);
+		}
+	}
+	fclose(file);
+	return !trace.empty();
+}
+
+/// \brief dial a heading with the buttons as an operator would.
+/// \return ticks from the start of dialing to the last release, DIAL_TIMEOUT when the heading was not reached.
+static uint32_t dial(PE1MEW_Simulation& simulation, uint16_t heading, uint32_t reaction, uint8_t increment, sSweepResult& result)
+{
+	std::vector<uint16_t> seen(reaction + 1, simulation.getController().getNextDirection());
+	int tolerance = (increment > 1) ? increment / 2 : 1;
+	bool fine = false;
+	uint8_t buttons = BUTTON_NONE;
+	uint8_t pressed = BUTTON_NONE;
+	uint32_t wait = 0;
+	uint32_t stable = 0;
+	uint32_t ticks = 0;
+	uint32_t lastRelease = 0;
+	
+	for (ticks = 0; ticks < DIAL_TIMEOUT && stable <= reaction; ticks++)
+	{
+		uint16_t next = simulation.getController().getNextDirection();
+		int distance = (int)heading - (int)seen[ticks % seen.size()];	// display as seen reaction ticks ago
+		uint8_t toward = (distance > 0) ? BUTTON_2 : BUTTON_1;
+		seen[ticks % seen.size()] = next;
+		
+		if (abs(distance) <= tolerance)
+		{
+			buttons = BUTTON_NONE;
+			stable++;
+		}
+		else if (!fine)
+		{
+			stable = 0;
+			if (buttons != BUTTON_NONE && buttons != toward)
+			{
+				fine = true;				// passed the heading
+				buttons = BUTTON_NONE;
+				wait = reaction;
+			}
+			else if (abs(distance) < FINE_ZONE)
+			{
+				fine = true;
+				buttons = BUTTON_NONE;
+				wait = reaction;
+			}
+			else
+			{
+				buttons = toward;
+			}
+		}
+		else
+		{
+			stable = 0;
+			if (buttons != BUTTON_NONE)
+			{
+				if (next != seen[(ticks + seen.size() - 1) % seen.size()])
+				{
+					buttons = BUTTON_NONE;	// step taken, release and watch
+					wait = reaction;
+				}
+			}
+			else if (wait > 0)
+			{
+				wait--;
+			}
+			else
+			{
+				buttons = toward;
+			}
+		}
+		
+		if (buttons != BUTTON_NONE && pressed == BUTTON_NONE)
+		{
+			result.presses++;
+		}
+		if (buttons == BUTTON_NONE && pressed != BUTTON_NONE)
+		{
+			lastRelease = ticks;
+		}
+		pressed = buttons;
+		simulation.setButtons(buttons);
+		simulation.Process();
+	}
+	simulation.setButtons(BUTTON_NONE);
+	return (ticks < DIAL_TIMEOUT) ? lastRelease : DIAL_TIMEOUT;
+}
+
+/// \brief run one session on a new controller.
+static void runSession(const sSweep& sweep, const sSweepPoint& point, uint32_t seed, sSweepResult& result)
+{
+	std::vector<sHeading> session = sweep.trace;
+	
+	if (session.empty())
+	{
+		std::mt19937 random(seed);
+		std::uniform_int_distribution<int> direction(0, 3600);
+		std::uniform_int_distribution<int> idle(100, 1000);
+		for (uint32_t i = 0; i < sweep.headings; i++)
+		{
+			sHeading heading = { (uint32_t)idle(random), (uint16_t)direction(random) };
+			session.push_back(heading);
+		}
+	}
+	
+	uint16_t runtime = PE1MEW_Simulation::getCalibratedRunTime(sweep.plant);
+	runtime = (uint16_t)(runtime * (1.0 + point.calibration / 100.0) + 0.5);
+	
+	PE1MEW_Simulation simulation(sweep.plant, runtime, 1800, seed);
+	PE1MEW_RotorController& controller = simulation.getController();
+	controller.setSteeringProfile(&point.profile);
+	controller.setDeadband(point.deadband);
+	controller.setCommitDelay(point.commit);
+	
+	for (size_t i = 0; i < session.size(); i++)
+	{
+		for (uint32_t tick = 0; tick < session[i].idleTicks; tick++)
+		{
+			simulation.Process();
+		}
+		
+		uint32_t dialTicks = dial(simulation, session[i].direction, sweep.reaction, point.profile.increment, result);
+		result.timeouts += (dialTicks == DIAL_TIMEOUT) ? 1 : 0;
+		result.dialTicks += dialTicks;
+		
+		// Wait until the rotor stopped and coasted out.
+		uint32_t stopped = 0;
+		for (uint32_t tick = 0; tick < MOVE_TIMEOUT && stopped < SETTLE_TICKS; tick++)
+		{
+			simulation.Process();
+			stopped = controller.getRotorRunning() ? 0 : stopped + 1;
+		}
+		
+		double error = fabs(session[i].direction / 10.0 - simulation.getPlant().getPosition());
+		result.errorSum += error;
+		result.errorMax = (error > result.errorMax) ? error : result.errorMax;
+		result.driftSum += fabs(controller.getCurrentDirection() / 10.0 - simulation.getPlant().getPosition());
+		result.headings++;
+	}
+	result.travelTicks += simulation.getRunningTicks();
+	result.relayCycles += simulation.getRelayCycles();
+}
+
+int main(int argc, char* argv[])
+{
+	sSweep sweep = { 1, 1, 50, 25, std::thread::hardware_concurrency(), std::vector<sHeading>(), PLANT_DEFAULT };
+	std::vector<double> hold[STEP4 + 1] = { {PRESS_COUNTER_TRESHOLD1}, {PRESS_COUNTER_TRESHOLD2}, {PRESS_COUNTER_TRESHOLD3}, {PRESS_COUNTER_TRESHOLD4} };
+	std::vector<double> steps = { PRESS_COUNTER_STEP1_TRESHOLD };
+	std::vector<double> increment = { INCREMENT_DEFAULT };
+	std::vector<double> deadband = { 0 };
+	std::vector<double> calibration = { 0 };
+	std::vector<double> commit = { COMMIT_DELAY };
+	
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+		
+		if      (!strcmp(option, "--hold1"))       { hold[STEP1] = parseList(value); i++; }
+		else if (!strcmp(option, "--hold2"))       { hold[STEP2] = parseList(value); i++; }
+		else if (!strcmp(option, "--hold3"))       { hold[STEP3] = parseList(value); i++; }
+		else if (!strcmp(option, "--hold4"))       { hold[STEP4] = parseList(value); i++; }
+		else if (!strcmp(option, "--steps"))       { steps = parseList(value); i++; }
+		else if (!strcmp(option, "--increment"))   { increment = parseList(value); i++; }
+		else if (!strcmp(option, "--deadband"))    { deadband = parseList(value); i++; }
+		else if (!strcmp(option, "--calibration")) { calibration = parseList(value); i++; }
+		else if (!strcmp(option, "--commit"))      { commit = parseList(value); i++; }
+		else if (!strcmp(option, "--trace"))
+		{
+			if (!readTrace(value, sweep.trace))
+			{
+				fprintf(stderr, "cannot read trace %s\n", value);
+				return 1;
+			}
+			i++;
+		}
+		else if (!strcmp(option, "--headings"))    { sweep.headings = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--repeats"))     { sweep.repeats = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--seed"))        { sweep.seed = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--reaction"))    { sweep.reaction = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--threads"))     { sweep.threads = strtoul(value, 0, 0); i++; }
+		else if (!strcmp(option, "--speed-cw"))    { sweep.plant.speedCW = atof(value); i++; }
+		else if (!strcmp(option, "--speed-ccw"))   { sweep.plant.speedCCW = atof(value); i++; }
+		else if (!strcmp(option, "--wind"))        { sweep.plant.windNoise = atof(value); i++; }
+		else { usage(argv[0]); return 1; }
+	}
+	
+	// Build every combination of the lists.
+	std::vector<sSweepPoint> points;
+	for (double h1 : hold[STEP1]) for (double h2 : hold[STEP2]) for (double h3 : hold[STEP3]) for (double h4 : hold[STEP4])
+	for (double st : steps) for (double in : increment) for (double db : deadband) for (double ca : calibration)
+	for (double co : commit)
+	{
+		sSweepPoint point = { { {(uint8_t)h1, (uint8_t)h2, (uint8_t)h3, (uint8_t)h4},
+								{(uint8_t)st, (uint8_t)st, (uint8_t)st, PRESS_COUNTER_STEP4_TRESHOLD},
+								(uint8_t)in }, (uint8_t)db, ca, (uint8_t)co };
+		points.push_back(point);
+	}
+	
+	// Every session of every combination is a job, taken by the next free thread.
+	std::vector<sSweepResult> results(points.size() * sweep.repeats, sSweepResult());
+	std::atomic<size_t> nextJob(0);
+	std::vector<std::thread> workers;
+	
+	sweep.threads = (sweep.threads > 0) ? sweep.threads : 1;
+	for (unsigned t = 0; t < sweep.threads; t++)
+	{
+		workers.push_back(std::thread([&]()
+		{
+			for (size_t job = nextJob++; job < results.size(); job = nextJob++)
+			{
+				runSession(sweep, points[job / sweep.repeats], sweep.seed + job % sweep.repeats, results[job]);
+			}
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+	
+	printf("hold1,hold2,hold3,hold4,steps,increment,deadband,calibration,commit,headings,timeouts,presses,"
+		   "dial_s,error_mean,error_max,drift_mean,travel_s,relay_cycles\n");
+	for (size_t p = 0; p < points.size(); p++)
+	{
+		sSweepResult sum = sSweepResult();
+		for (uint32_t r = 0; r < sweep.repeats; r++)
+		{
+			const sSweepResult& result = results[p * sweep.repeats + r];
+			sum.headings += result.headings;
+			sum.timeouts += result.timeouts;
+			sum.presses += result.presses;
+			sum.dialTicks += result.dialTicks;
+			sum.travelTicks += result.travelTicks;
+			sum.relayCycles += result.relayCycles;
+			sum.errorSum += result.errorSum;
+			sum.errorMax = (result.errorMax > sum.errorMax) ? result.errorMax : sum.errorMax;
+			sum.driftSum += result.driftSum;
+		}
+		
+		const sSweepPoint& point = points[p];
+		double headings = (sum.headings > 0) ? sum.headings : 1;
+		printf("%u,%u,%u,%u,%u,%.1f,%.1f,%.2f,%u,%u,%u,%u,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f\n",
+			   point.profile.holdTicks[STEP1], point.profile.holdTicks[STEP2], point.profile.holdTicks[STEP3],
+			   point.profile.holdTicks[STEP4], point.profile.stepCount[STEP1], point.profile.increment / 10.0,
+			   point.deadband / 10.0, point.calibration, point.commit, sum.headings, sum.timeouts, sum.presses,
+			   sum.dialTicks * (TICK / 1000000.0) / headings, sum.errorSum / headings, sum.errorMax,
+			   sum.driftSum / headings, sum.travelTicks * (TICK / 1000000.0) / headings, sum.relayCycles / headings);
+	}
+	return 0;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+#--------------------------------------------------------------------
+#  This file is part of the PE1MEW Arduino Rotor Controller.
+#
+#  The PE1MEW Arduino Rotor Controller is free software:
+#  you can redistribute it and/or modify it under the terms of a Creative
+#  Commons Attribution-NonCommercial 4.0 International License
+#  (http://creativecommons.org/licenses/by-nc/4.0/) by
+#  PE1MEW (http://pe1mew.nl) E-mail: pe1mew@pe1mew.nl
+#--------------------------------------------------------------------
+#
+# Report the RAM use (.data and .bss) per module of the rotor controller.
+#
+# Usage: memoryreport.sh <build folder>
+#
+# The build folder is shown in the Arduino IDE when "Show verbose output during compilation"
+# is enabled, or can be selected with: arduino-cli compile --build-path <build folder>
+# avr-size and avr-nm of the Arduino AVR toolchain shall be in the PATH.
+
+if [ $# -ne 1 ] || [ ! -d "$1" ]; then
+	echo "usage: $0 <build folder>" >&2
+	exit 1
+fi
+
+BUILD="$1"
+
+echo "--- RAM per module (bytes) ---"
+printf "%-40s %6s %6s %6s\n" "module" "data" "bss" "ram"
+for object in $(find "$BUILD" -name "*.o" | sort); do
+	avr-size "$object" | awk -v name="$(basename "$object")" \
+		'NR == 2 { printf "%-40s %6d %6d %6d\n", name, $2, $3, $2 + $3 }'
+done
+
+ELF=$(find "$BUILD" -maxdepth 1 -name "*.elf" | head -n 1)
+if [ -n "$ELF" ]; then
+	echo
+	echo "--- Largest RAM symbols ---"
+	avr-nm --size-sort --demangle -S "$ELF" | awk '$3 ~ /[bBdD]/' | tail -n 20
+	echo
+	echo "--- Total ---"
+	avr-size -C --mcu=atmega328p "$ELF"
+fi